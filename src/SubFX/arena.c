@@ -0,0 +1,181 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+#define ARENA_ALIGN 16
+#define ALIGN_UP(x) (((x) + (ARENA_ALIGN - 1)) & ~((size_t)ARENA_ALIGN - 1))
+
+struct ArenaBlock
+{
+    ArenaBlock *next;
+
+    size_t size;
+
+    size_t offset;
+};
+
+#define BLOCK_HEADER ALIGN_UP(sizeof(ArenaBlock))
+
+static ArenaBlock *newBlock(size_t size)
+{
+    ArenaBlock *ret = malloc(BLOCK_HEADER + size);
+    if (!ret)
+    {
+        return NULL;
+    }
+
+    ret->next = NULL;
+    ret->size = size;
+    ret->offset = 0;
+    return ret;
+}
+
+uint8_t Arena_init(Arena *in, size_t blockSize)
+{
+    if (!in) return 1;
+
+    memset(in, 0, sizeof(Arena));
+    in->blockSize = blockSize ? ALIGN_UP(blockSize) : ARENA_DEFAULT_BLOCK_SIZE;
+    return 0;
+}
+
+void Arena_fin(Arena *in)
+{
+    if (!in) return;
+
+    ArenaBlock *block = in->head;
+    ArenaBlock *next;
+    while (block)
+    {
+        next = block->next;
+        free(block);
+        block = next;
+    }
+
+    memset(in, 0, sizeof(Arena));
+}
+
+void *Arena_alloc(Arena *in, size_t size)
+{
+    if (!in || !size) return NULL;
+
+    size = ALIGN_UP(size);
+    ArenaBlock *block = in->head;
+    if (!block || (block->size - block->offset) < size)
+    {
+        if (size > (in->blockSize >> 2))
+        {
+            // large request, give it its own block and keep using
+            // the current one for small requests
+            block = newBlock(size);
+            if (!block)
+            {
+                return NULL;
+            }
+
+            if (in->head)
+            {
+                block->next = in->head->next;
+                in->head->next = block;
+            }
+            else
+            {
+                in->head = block;
+            }
+        }
+        else
+        {
+            block = newBlock(in->blockSize);
+            if (!block)
+            {
+                return NULL;
+            }
+
+            block->next = in->head;
+            in->head = block;
+        }
+
+        in->reserved += (BLOCK_HEADER + block->size);
+    }
+
+    void *ret = (char *)block + BLOCK_HEADER + block->offset;
+    block->offset += size;
+    in->used += size;
+    return ret;
+}
+
+void *Arena_calloc(Arena *in, size_t size)
+{
+    void *ret = Arena_alloc(in, size);
+    if (ret)
+    {
+        memset(ret, 0, size);
+    }
+
+    return ret;
+}
+
+char *Arena_strndup(Arena *in, const char *str, size_t len)
+{
+    if (!str) return NULL;
+
+    char *ret = Arena_alloc(in, len + 1);
+    if (!ret)
+    {
+        return NULL;
+    }
+
+    memcpy(ret, str, len);
+    ret[len] = '\0';
+    return ret;
+}
+
+void Arena_merge(Arena *dst, Arena *src)
+{
+    if (!dst || !src || !src->head) return;
+
+    // keep dst's current block as the head,
+    // so that its free space is still used
+    ArenaBlock *tail = src->head;
+    while (tail->next)
+    {
+        tail = tail->next;
+    }
+
+    if (dst->head)
+    {
+        tail->next = dst->head->next;
+        dst->head->next = src->head;
+    }
+    else
+    {
+        dst->head = src->head;
+    }
+
+    dst->used += src->used;
+    dst->reserved += src->reserved;
+
+    size_t blockSize = src->blockSize;
+    memset(src, 0, sizeof(Arena));
+    src->blockSize = blockSize;
+}
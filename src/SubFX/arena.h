@@ -0,0 +1,76 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define ARENA_DEFAULT_BLOCK_SIZE (1 << 16)
+
+typedef struct ArenaBlock ArenaBlock;
+
+/**
+ * A bump allocator.
+ * Memory is taken from large blocks and is never freed one by one,
+ * Arena_fin() releases every block in one shot.
+ * It is NOT thread-safe.
+ */
+typedef struct Arena
+{
+    ArenaBlock *head;
+
+    size_t blockSize;
+
+    // bytes handed out by Arena_alloc()
+    size_t used;
+
+    // bytes allocated from the system
+    size_t reserved;
+} Arena;
+
+uint8_t Arena_init(Arena *, size_t blockSize);
+
+void Arena_fin(Arena *);
+
+/**
+ * @return memory aligned for any built-in type, or NULL if out of memory.
+ */
+void *Arena_alloc(Arena *, size_t size);
+
+// same as Arena_alloc, but the memory is zero-filled
+void *Arena_calloc(Arena *, size_t size);
+
+// copy len bytes of str, the copy is '\0' terminated
+char *Arena_strndup(Arena *, const char *str, size_t len);
+
+/**
+ * Moves every block of src into dst, src is empty after that.
+ * Memory from src stays valid until dst is released.
+ */
+void Arena_merge(Arena *dst, Arena *src);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,1140 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "assextend.h"
+#include "common.h"
+#include "fonthandle.h"
+#include "global.h"
+
+// dialogs taken from the queue at once
+#define QUEUE_BATCH 4
+
+static const char *patterns[REGEX_EXTEND_COUNT] =
+{
+    REGEX_STR_EXTEND_TAGS,
+    REGEX_STR_EXTEND_TEXT_CHUNK,
+    REGEX_STR_EXTEND_K_TAG,
+    REGEX_STR_EXTEND_SYL_TEXT,
+    REGEX_STR_EXTEND_WORD
+};
+
+static void noFree(void *in)
+{
+    // everything is in the parser's arena
+    UNUSED(in);
+}
+
+static uint32_t utf8Len(const char *str, size_t len)
+{
+    uint32_t ret = 0;
+    size_t i;
+    for (i = 0; i < len; ++i)
+    {
+        ret += (((uint8_t)str[i] & 0xc0) != 0x80);
+    }
+
+    return ret;
+}
+
+// same rule as subfx_utf8_stringSplit
+static size_t utf8CharLen(const char *str, size_t remain)
+{
+    size_t len = 1;
+    if (((uint8_t)str[0] & 0xf8) == 0xf0)
+        len = 4;
+    else if (((uint8_t)str[0] & 0xf0) == 0xe0)
+        len = 3;
+    else if (((uint8_t)str[0] & 0xe0) == 0xc0)
+        len = 2;
+
+    return (len > remain) ? 1 : len;
+}
+
+static fdsa_ptrVector *createVector(size_t reserve)
+{
+    fDSA *fdsa = getFDSA();
+    fdsa_ptrVector *ret = fdsa->ptrVector.create(noFree);
+    if (!ret)
+    {
+        return NULL;
+    }
+
+    if (reserve &&
+        fdsa->ptrVector.reserve(ret, reserve) == fdsa_failed)
+    {
+        fdsa->ptrVector.destory(ret);
+        return NULL;
+    }
+
+    return ret;
+}
+
+static uint8_t textSize(AssExtendWorker *worker,
+                        subfx_fontHandle *font,
+                        const TEXT_SIZE *metrics,
+                        const char *text,
+                        size_t textLen,
+                        TEXT_SIZE *out)
+{
+    double extents[2];
+    if (subfx_fontHandle_text_extents2(font,
+                                       text,
+                                       textLen,
+                                       extents) == subfx_failed)
+    {
+        subfx_pError(worker->errMsg,
+                     "extendDialogs: Fail to get text properties");
+        return 1;
+    }
+
+    out->width = extents[subfx_fonthandle_text_extents_width];
+    out->height = extents[subfx_fonthandle_text_extents_height];
+    out->ascent = metrics->ascent;
+    out->descent = metrics->descent;
+    out->internal_leading = metrics->internal_leading;
+    out->external_leading = metrics->external_leading;
+    return 0;
+}
+
+#define SET_TEXT_SIZE(dst, size) \
+    (dst)->width = (size).width; \
+    (dst)->height = (size).height; \
+    (dst)->ascent = (size).ascent; \
+    (dst)->descent = (size).descent; \
+    (dst)->internal_leading = (size).internal_leading; \
+    (dst)->external_leading = (size).external_leading;
+
+uint8_t AssExtendQueue_init(AssExtendQueue *in, fdsa_ptrVector *dialogs)
+{
+    if (!in || !dialogs) return 1;
+
+    memset(in, 0, sizeof(AssExtendQueue));
+    if (Mutex_init(&in->mutex))
+    {
+        return 1;
+    }
+
+    fDSA *fdsa = getFDSA();
+    if (fdsa->ptrVector.size(dialogs, &in->size) == fdsa_failed)
+    {
+        Mutex_fin(&in->mutex);
+        return 1;
+    }
+
+    in->dialogs = dialogs;
+    return 0;
+}
+
+void AssExtendQueue_fin(AssExtendQueue *in)
+{
+    if (!in) return;
+
+    Mutex_fin(&in->mutex);
+    memset(in, 0, sizeof(AssExtendQueue));
+}
+
+uint8_t AssExtendWorker_init(AssExtendWorker *in,
+                             const subfx_ass_meta *meta,
+                             AssExtendQueue *queue)
+{
+    if (!in || !meta || !queue) return 1;
+
+    memset(in, 0, sizeof(AssExtendWorker));
+    in->meta = meta;
+    in->queue = queue;
+    in->failedAt = SIZE_MAX;
+    Arena_init(&in->arena, 0);
+    FontCache_init(&in->fonts);
+
+    int index;
+    for (index = 0; index < REGEX_EXTEND_COUNT; ++index)
+    {
+        if (RegexData_init(&in->regex[index], patterns[index]))
+        {
+            AssExtendWorker_fin(in);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void AssExtendWorker_fin(AssExtendWorker *in)
+{
+    if (!in) return;
+
+    int index;
+    for (index = 0; index < REGEX_EXTEND_COUNT; ++index)
+    {
+        RegexData_fin(&in->regex[index]);
+    }
+
+    memset(in->regex, 0, REGEX_EXTEND_COUNT * sizeof(Regex));
+    FontCache_fin(&in->fonts);
+    Arena_fin(&in->arena);
+}
+
+void AssExtendWorker_run(void *in)
+{
+    AssExtendWorker *worker = (AssExtendWorker *)in;
+    AssExtendQueue *queue = worker->queue;
+    fDSA *fdsa = getFDSA();
+    size_t begin, end, index;
+    while (1)
+    {
+        if (Mutex_lock(&queue->mutex))
+        {
+            subfx_pError(worker->errMsg,
+                         "extendDialogs: Fail to lock the queue.");
+            worker->failedAt = queue->next;
+            return;
+        }
+
+        begin = queue->next;
+        end = begin + QUEUE_BATCH;
+        if (end > queue->size) end = queue->size;
+        if (queue->failed) end = begin;
+        queue->next = end;
+        Mutex_unlock(&queue->mutex);
+
+        if (begin == end)
+        {
+            return;
+        }
+
+        // dialogs taken are always finished, so the dialog with
+        // the smallest index that fails is always reported
+        for (index = begin; index < end; ++index)
+        {
+            if (AssExtendWorker_dialog(
+                    worker,
+                    (subfx_ass_dialog *)fdsa->ptrVector.at(queue->dialogs,
+                                                           index)))
+            {
+                worker->failedAt = index;
+                Mutex_lock(&queue->mutex);
+                queue->failed = true;
+                Mutex_unlock(&queue->mutex);
+                return;
+            }
+        }
+    }
+}
+
+static const char *stripTags(AssExtendWorker *worker,
+                             const char *text,
+                             size_t textLen,
+                             size_t *outLen)
+{
+    char *ret = Arena_alloc(&worker->arena, textLen + 1);
+    if (!ret)
+    {
+        return NULL;
+    }
+
+    Regex *regex = &worker->regex[REGEX_EXTEND_TAGS];
+    size_t offset = 0, len = 0, begin, matchLen;
+    int pcreRet;
+    while (offset < textLen &&
+           RegexData_matchLen(regex, text + offset, textLen - offset, &pcreRet))
+    {
+        RegexData_group(regex, 0, &begin, &matchLen);
+        memcpy(ret + len, text + offset, begin);
+        len += begin;
+        offset += (begin + matchLen);
+    }
+
+    memcpy(ret + len, text + offset, textLen - offset);
+    len += (textLen - offset);
+    ret[len] = '\0';
+    *outLen = len;
+    return ret;
+}
+
+static uint8_t pushChunk(AssExtendWorker *worker,
+                         subfx_ass_dialog *dialog,
+                         const char *tags,
+                         size_t tagsLen,
+                         const char *text,
+                         size_t textLen)
+{
+    subfx_ass_chunked *chunk = Arena_alloc(&worker->arena,
+                                           sizeof(subfx_ass_chunked));
+    if (!chunk)
+    {
+        return 1;
+    }
+
+    chunk->tags = Arena_strndup(&worker->arena, tags, tagsLen);
+    chunk->tags_len = tagsLen;
+    chunk->text = Arena_strndup(&worker->arena, text, textLen);
+    chunk->text_len = textLen;
+    if (!chunk->tags || !chunk->text)
+    {
+        return 1;
+    }
+
+    fDSA *fdsa = getFDSA();
+    return (fdsa->ptrVector.pushBack(dialog->textChunked, chunk) ==
+            fdsa_failed);
+}
+
+static uint8_t addTextChunks(AssExtendWorker *worker,
+                             subfx_ass_dialog *dialog)
+{
+    Regex *regex = &worker->regex[REGEX_EXTEND_TEXT_CHUNK];
+    const char *text = dialog->text;
+    size_t textLen = dialog->text_len;
+    size_t offset = 0, begin, len, tagsBegin, tagsLen, chunkBegin, chunkLen;
+    int pcreRet;
+    while (offset < textLen &&
+           RegexData_matchLen(regex, text + offset, textLen - offset, &pcreRet))
+    {
+        RegexData_group(regex, 0, &begin, &len);
+        RegexData_group(regex, 1, &tagsBegin, &tagsLen);
+        RegexData_group(regex, 2, &chunkBegin, &chunkLen);
+
+        // text before the first tags
+        if (begin &&
+            pushChunk(worker, dialog, "", 0, text + offset, begin))
+        {
+            return 1;
+        }
+
+        if (pushChunk(worker, dialog,
+                      text + offset + tagsBegin, tagsLen,
+                      text + offset + chunkBegin, chunkLen))
+        {
+            return 1;
+        }
+
+        offset += (begin + len);
+    }
+
+    return 0;
+}
+
+static uint8_t addSyls(AssExtendWorker *worker,
+                       subfx_ass_dialog *dialog,
+                       subfx_fontHandle *font,
+                       const TEXT_SIZE *metrics)
+{
+    fDSA *fdsa = getFDSA();
+    size_t chunks;
+    if (fdsa->ptrVector.size(dialog->textChunked, &chunks) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (!chunks)
+    {
+        return 0;
+    }
+
+    // syls are only kept if every chunk has a karaoke tag
+    subfx_ass_syl **syls = Arena_alloc(&worker->arena,
+                                       chunks * sizeof(subfx_ass_syl *));
+    if (!syls)
+    {
+        return 1;
+    }
+
+    Regex *kTag = &worker->regex[REGEX_EXTEND_K_TAG];
+    Regex *sylText = &worker->regex[REGEX_EXTEND_SYL_TEXT];
+    uint64_t lastTime = 0, kdur;
+    size_t index, begin, len, group, groupLen;
+    int pcreRet;
+    char *tags;
+    TEXT_SIZE size;
+    for (index = 0; index < chunks; ++index)
+    {
+        subfx_ass_chunked *chunk = fdsa->ptrVector.at(dialog->textChunked,
+                                                      index);
+        if (!RegexData_matchLen(kTag, chunk->tags, chunk->tags_len, &pcreRet))
+        {
+            return 0;
+        }
+
+        RegexData_group(kTag, 0, &begin, &len);
+        RegexData_group(kTag, 1, &group, &groupLen);
+        if (groupLen > 18)
+        {
+            subfx_pError(worker->errMsg,
+                         "parseDialogs: Error when getting syl's duration.");
+            return 1;
+        }
+
+        kdur = strtoull(chunk->tags + group, NULL, 10);
+
+        subfx_ass_syl *syl = Arena_calloc(&worker->arena,
+                                          sizeof(subfx_ass_syl));
+        if (!syl)
+        {
+            return 1;
+        }
+
+        syl->i = (uint32_t)index;
+        syl->start_time = lastTime;
+        syl->mid_time = lastTime + kdur * 5; // kdur * 10 / 2
+        syl->duration = kdur * 10;
+        syl->end_time = lastTime + syl->duration;
+
+        // the tags without the karaoke tag
+        tags = Arena_alloc(&worker->arena, chunk->tags_len - len + 1);
+        if (!tags)
+        {
+            return 1;
+        }
+
+        memcpy(tags, chunk->tags, begin);
+        memcpy(tags + begin,
+               chunk->tags + begin + len,
+               chunk->tags_len - begin - len);
+        syl->tags_len = chunk->tags_len - len;
+        tags[syl->tags_len] = '\0';
+        syl->tags = tags;
+
+        if (RegexData_matchLen(sylText, chunk->text, chunk->text_len,
+                               &pcreRet))
+        {
+            RegexData_group(sylText, 2, &group, &groupLen);
+            syl->text = Arena_strndup(&worker->arena,
+                                      chunk->text + group,
+                                      groupLen);
+            syl->text_len = groupLen;
+
+            RegexData_group(sylText, 1, &group, &groupLen);
+            syl->prespace = utf8Len(chunk->text + group, groupLen);
+
+            RegexData_group(sylText, 3, &group, &groupLen);
+            syl->postspace = utf8Len(chunk->text + group, groupLen);
+        }
+        else
+        {
+            syl->prespace = 0;
+            syl->postspace = 0;
+            syl->text = chunk->text;
+            syl->text_len = chunk->text_len;
+        }
+
+        if (!syl->text)
+        {
+            return 1;
+        }
+
+        if (textSize(worker, font, metrics,
+                     syl->text, syl->text_len, &size))
+        {
+            return 1;
+        }
+
+        SET_TEXT_SIZE(syl, size)
+        lastTime = syl->end_time;
+        syls[index] = syl;
+    }
+
+    for (index = 0; index < chunks; ++index)
+    {
+        if (fdsa->ptrVector.pushBack(dialog->syls, syls[index]) ==
+            fdsa_failed)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void sylPositions(subfx_ass_dialog *dialog,
+                         const subfx_ass_meta *meta,
+                         double space_width)
+{
+    fDSA *fdsa = getFDSA();
+    size_t size, index;
+    if (fdsa->ptrVector.size(dialog->syls, &size) == fdsa_failed || !size)
+    {
+        return;
+    }
+
+    subfx_ass_syl *syl = fdsa->ptrVector.at(dialog->syls, 0);
+    if (syl->width == 0.)
+    {
+        return;
+    }
+
+    uint8_t alignment = dialog->styleref->alignment;
+    if (alignment > 6 || alignment < 4)
+    {
+        double cur_x = dialog->left;
+        for (index = 0; index < size; ++index)
+        {
+            syl = fdsa->ptrVector.at(dialog->syls, index);
+
+            // Horizontal position
+            cur_x += (syl->prespace * space_width);
+            syl->left = cur_x;
+            syl->center = syl->left + (syl->width / 2.);
+            syl->right = syl->left + syl->width;
+
+            if (((alignment - 1) % 3) == 0)
+            {
+                syl->x = syl->left;
+            }
+            else if (((alignment - 2) % 3) == 0)
+            {
+                syl->x = syl->center;
+            }
+            else
+            {
+                syl->x = syl->right;
+            }
+
+            cur_x += (syl->width + (syl->postspace * space_width));
+
+            // Vertical position
+            syl->top = dialog->top;
+            syl->middle = dialog->middle;
+            syl->bottom = dialog->bottom;
+            syl->y = dialog->y;
+        } // end for index
+
+        return;
+    }
+
+    double max_width = 0., sum_height = 0.;
+    for (index = 0; index < size; ++index)
+    {
+        syl = fdsa->ptrVector.at(dialog->syls, index);
+        if (syl->width > max_width) max_width = syl->width;
+        sum_height += syl->height;
+    }
+
+    double cur_y = (double)(meta->play_res_y >> 1) - (sum_height / 2.);
+    double x_fix;
+    for (index = 0; index < size; ++index)
+    {
+        syl = fdsa->ptrVector.at(dialog->syls, index);
+        x_fix = ((max_width - syl->width) / 2.);
+        if (alignment == 4)
+        {
+            syl->left = dialog->left + x_fix;
+            syl->center = syl->left + (syl->width / 2.);
+            syl->right = syl->left + syl->width;
+            syl->x = syl->left;
+        }
+        else if (alignment == 5)
+        {
+            syl->left = (double)(meta->play_res_x >> 1) - (syl->width / 2.);
+            syl->center = syl->left + (syl->width / 2.);
+            syl->right = syl->left + syl->width;
+            syl->x = syl->center;
+        }
+        else // alignment == 6
+        {
+            syl->left = dialog->right - syl->width - x_fix;
+            syl->center = syl->left + (syl->width / 2.);
+            syl->right = syl->left + syl->width;
+            syl->x = syl->right;
+        }
+
+        // Vertical position
+        syl->top = cur_y;
+        syl->middle = syl->top + (syl->height / 2.);
+        syl->bottom = syl->top + syl->height;
+        syl->y = syl->middle;
+        cur_y += syl->height;
+    } // end for index
+}
+
+static uint8_t addWords(AssExtendWorker *worker,
+                        subfx_ass_dialog *dialog,
+                        subfx_fontHandle *font,
+                        const TEXT_SIZE *metrics)
+{
+    fDSA *fdsa = getFDSA();
+    Regex *regex = &worker->regex[REGEX_EXTEND_WORD];
+    const char *text = dialog->text_stripped;
+    size_t textLen = dialog->text_stripped_len;
+    size_t offset = 0, begin, len, group, groupLen;
+    uint32_t wordIndex = 0;
+    int pcreRet;
+    TEXT_SIZE size;
+    while (offset < textLen &&
+           RegexData_matchLen(regex, text + offset, textLen - offset, &pcreRet))
+    {
+        subfx_ass_word *word = Arena_calloc(&worker->arena,
+                                            sizeof(subfx_ass_word));
+        if (!word)
+        {
+            return 1;
+        }
+
+        RegexData_group(regex, 0, &begin, &len);
+
+        RegexData_group(regex, 2, &group, &groupLen);
+        word->text = Arena_strndup(&worker->arena,
+                                   text + offset + group,
+                                   groupLen);
+        word->text_len = groupLen;
+        if (!word->text)
+        {
+            return 1;
+        }
+
+        RegexData_group(regex, 1, &group, &groupLen);
+        word->prespace = utf8Len(text + offset + group, groupLen);
+
+        RegexData_group(regex, 3, &group, &groupLen);
+        word->postspace = utf8Len(text + offset + group, groupLen);
+
+        word->i = wordIndex;
+        word->start_time = dialog->start_time;
+        word->mid_time = dialog->mid_time;
+        word->end_time = dialog->end_time;
+        word->duration = dialog->duration;
+
+        if (textSize(worker, font, metrics,
+                     word->text, word->text_len, &size))
+        {
+            return 1;
+        }
+
+        SET_TEXT_SIZE(word, size)
+        if (fdsa->ptrVector.pushBack(dialog->words, word) == fdsa_failed)
+        {
+            return 1;
+        }
+
+        offset += (begin + len);
+        ++wordIndex;
+    }
+
+    return 0;
+}
+
+static void wordPositions(subfx_ass_dialog *dialog,
+                          const subfx_ass_meta *meta,
+                          double space_width)
+{
+    fDSA *fdsa = getFDSA();
+    size_t size, index;
+    if (fdsa->ptrVector.size(dialog->words, &size) == fdsa_failed || !size)
+    {
+        return;
+    }
+
+    subfx_ass_word *word = fdsa->ptrVector.at(dialog->words, 0);
+    if (word->width == 0.)
+    {
+        return;
+    }
+
+    uint8_t alignment = dialog->styleref->alignment;
+    if (alignment > 6 || alignment < 4)
+    {
+        double cur_x = dialog->left;
+        for (index = 0; index < size; ++index)
+        {
+            word = fdsa->ptrVector.at(dialog->words, index);
+
+            // Horizontal position
+            cur_x += (word->prespace * space_width);
+            word->left = cur_x;
+            word->center = word->left + (word->width / 2.);
+            word->right = word->left + word->width;
+
+            if (((alignment - 1) % 3) == 0)
+            {
+                word->x = word->left;
+            }
+            else if (((alignment - 2) % 3) == 0)
+            {
+                word->x = word->center;
+            }
+            else
+            {
+                word->x = word->right;
+            }
+
+            cur_x += (word->width + (word->postspace * space_width));
+
+            // Vertical position
+            word->top = dialog->top;
+            word->middle = dialog->middle;
+            word->bottom = dialog->bottom;
+            word->y = dialog->y;
+        } // end for index
+
+        return;
+    }
+
+    double max_width = 0., sum_height = 0.;
+    for (index = 0; index < size; ++index)
+    {
+        word = fdsa->ptrVector.at(dialog->words, index);
+        if (word->width > max_width) max_width = word->width;
+        sum_height += word->height;
+    }
+
+    double cur_y = (double)(meta->play_res_y >> 1) - (sum_height / 2.);
+    double x_fix;
+    for (index = 0; index < size; ++index)
+    {
+        word = fdsa->ptrVector.at(dialog->words, index);
+
+        // Horizontal position
+        x_fix = ((max_width - word->width) / 2.);
+        if (alignment == 4)
+        {
+            word->left = dialog->left + x_fix;
+            word->center = word->left + (word->width / 2.);
+            word->right = word->left + word->width;
+            word->x = word->left;
+        }
+        else if (alignment == 5)
+        {
+            word->left = (double)(meta->play_res_x >> 1) - (word->width / 2.);
+            word->center = word->left + (word->width / 2.);
+            word->right = word->left + word->width;
+            word->x = word->center;
+        }
+        else // alignment == 6
+        {
+            word->left = dialog->right - word->width - x_fix;
+            word->center = word->left + (word->width / 2.);
+            word->right = word->left + word->width;
+            word->x = word->right;
+        }
+
+        // Vertical position
+        word->top = cur_y;
+        word->middle = word->top + (word->height / 2.);
+        word->bottom = word->top + word->height;
+        word->y = word->middle;
+        cur_y += word->height;
+    } // end for index
+}
+
+static uint8_t addChars(AssExtendWorker *worker,
+                        subfx_ass_dialog *dialog,
+                        subfx_fontHandle *font,
+                        const TEXT_SIZE *metrics)
+{
+    fDSA *fdsa = getFDSA();
+    const char *text = dialog->text_stripped;
+    size_t textLen = dialog->text_stripped_len;
+    uint32_t charCount = utf8Len(text, textLen);
+    if (!charCount)
+    {
+        return 0;
+    }
+
+    // which syl and word each char belongs to,
+    // counted in the same way as prespace + text + postspace
+    subfx_ass_syl **sylOf = Arena_calloc(&worker->arena,
+                                         charCount * sizeof(subfx_ass_syl *));
+    subfx_ass_word **wordOf = Arena_calloc(&worker->arena,
+                                           charCount *
+                                           sizeof(subfx_ass_word *));
+    if (!sylOf || !wordOf)
+    {
+        return 1;
+    }
+
+    size_t size, index;
+    uint32_t charIndex = 0, maxLoop, loop;
+    if (fdsa->ptrVector.size(dialog->syls, &size) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    for (index = 0; index < size && charIndex < charCount; ++index)
+    {
+        subfx_ass_syl *syl = fdsa->ptrVector.at(dialog->syls, index);
+        maxLoop = syl->prespace + utf8Len(syl->text, syl->text_len) +
+                  syl->postspace;
+        for (loop = 0; loop < maxLoop && charIndex < charCount; ++loop)
+        {
+            sylOf[charIndex++] = syl;
+        }
+    }
+
+    if (fdsa->ptrVector.size(dialog->words, &size) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    charIndex = 0;
+    for (index = 0; index < size && charIndex < charCount; ++index)
+    {
+        subfx_ass_word *word = fdsa->ptrVector.at(dialog->words, index);
+        maxLoop = word->prespace + utf8Len(word->text, word->text_len) +
+                  word->postspace;
+        for (loop = 0; loop < maxLoop && charIndex < charCount; ++loop)
+        {
+            wordOf[charIndex++] = word;
+        }
+    }
+
+    size_t offset = 0, len;
+    TEXT_SIZE textsize;
+    for (charIndex = 0; offset < textLen; ++charIndex)
+    {
+        len = utf8CharLen(text + offset, textLen - offset);
+        subfx_ass_char *assChar = Arena_calloc(&worker->arena,
+                                               sizeof(subfx_ass_char));
+        if (!assChar)
+        {
+            return 1;
+        }
+
+        assChar->i = charIndex;
+        assChar->start_time = dialog->start_time;
+        assChar->mid_time = dialog->mid_time;
+        assChar->end_time = dialog->end_time;
+        assChar->duration = dialog->duration;
+        assChar->text = Arena_strndup(&worker->arena, text + offset, len);
+        assChar->text_len = len;
+        if (!assChar->text)
+        {
+            return 1;
+        }
+
+        if (charIndex < charCount && sylOf[charIndex])
+        {
+            subfx_ass_syl *syl = sylOf[charIndex];
+            assChar->syl_i = (int)syl->i;
+            assChar->start_time = syl->start_time;
+            assChar->mid_time = syl->mid_time;
+            assChar->end_time = syl->end_time;
+            assChar->duration = syl->duration;
+        }
+
+        if (charIndex < charCount && wordOf[charIndex])
+        {
+            assChar->word_i = (int)wordOf[charIndex]->i;
+        }
+
+        if (textSize(worker, font, metrics,
+                     assChar->text, assChar->text_len, &textsize))
+        {
+            return 1;
+        }
+
+        SET_TEXT_SIZE(assChar, textsize)
+        if (fdsa->ptrVector.pushBack(dialog->chars, assChar) == fdsa_failed)
+        {
+            return 1;
+        }
+
+        offset += len;
+    }
+
+    return 0;
+}
+
+static void charPositions(subfx_ass_dialog *dialog,
+                          const subfx_ass_meta *meta)
+{
+    fDSA *fdsa = getFDSA();
+    size_t size, index;
+    if (fdsa->ptrVector.size(dialog->chars, &size) == fdsa_failed || !size)
+    {
+        return;
+    }
+
+    subfx_ass_char *assChar = fdsa->ptrVector.at(dialog->chars, 0);
+    if (assChar->width == 0.)
+    {
+        return;
+    }
+
+    uint8_t alignment = dialog->styleref->alignment;
+    if (alignment > 6 || alignment < 4)
+    {
+        double cur_x = dialog->left;
+        for (index = 0; index < size; ++index)
+        {
+            assChar = fdsa->ptrVector.at(dialog->chars, index);
+
+            // Horizontal position
+            assChar->left = cur_x;
+            assChar->center = assChar->left + (assChar->width / 2.);
+            assChar->right = assChar->left + assChar->width;
+
+            if (((alignment - 1) % 3) == 0)
+            {
+                assChar->x = assChar->left;
+            }
+            else if (((alignment - 2) % 3) == 0)
+            {
+                assChar->x = assChar->center;
+            }
+            else
+            {
+                assChar->x = assChar->right;
+            }
+
+            cur_x += assChar->width;
+
+            // Vertical position
+            assChar->top = dialog->top;
+            assChar->middle = dialog->middle;
+            assChar->bottom = dialog->bottom;
+            assChar->y = dialog->y;
+        } // end for index
+
+        return;
+    }
+
+    double max_width = 0., sum_height = 0.;
+    for (index = 0; index < size; ++index)
+    {
+        assChar = fdsa->ptrVector.at(dialog->chars, index);
+        if (assChar->width > max_width) max_width = assChar->width;
+        sum_height += assChar->height;
+    }
+
+    double cur_y = (double)(meta->play_res_y >> 1) - (sum_height / 2.);
+    double x_fix;
+    for (index = 0; index < size; ++index)
+    {
+        assChar = fdsa->ptrVector.at(dialog->chars, index);
+
+        // Horizontal position
+        x_fix = ((max_width - assChar->width) / 2.);
+        if (alignment == 4)
+        {
+            assChar->left = dialog->left + x_fix;
+            assChar->center = assChar->left + (assChar->width / 2.);
+            assChar->right = assChar->left + assChar->width;
+            assChar->x = assChar->left;
+        }
+        else if (alignment == 5)
+        {
+            assChar->left = (double)(meta->play_res_x >> 1) -
+                    (assChar->width / 2.);
+            assChar->center = assChar->left + (assChar->width / 2.);
+            assChar->right = assChar->left + assChar->width;
+            assChar->x = assChar->center;
+        }
+        else // alignment == 6
+        {
+            assChar->left = dialog->right - assChar->width - x_fix;
+            assChar->center = assChar->left + (assChar->width / 2.);
+            assChar->right = assChar->left + assChar->width;
+            assChar->x = assChar->right;
+        }
+
+        // Vertical position
+        assChar->top = cur_y;
+        assChar->middle = assChar->top + (assChar->height / 2.);
+        assChar->bottom = assChar->top + assChar->height;
+        assChar->y = assChar->middle;
+        cur_y += assChar->height;
+    } // end for index
+}
+
+static void dialogPosition(subfx_ass_dialog *dialog,
+                           const subfx_ass_meta *meta)
+{
+    const subfx_ass_style *style = dialog->styleref;
+
+    // Horizontal position
+    if (((style->alignment - 1) % 3) == 0)
+    {
+        dialog->left = (dialog->margin_l != 0. ?
+                    dialog->margin_l :
+                    style->margin_l);
+        dialog->center = dialog->left + (dialog->width / 2.);
+        dialog->right = dialog->left + dialog->width;
+        dialog->x = dialog->left;
+    }
+    else if (((style->alignment - 2) % 3) == 0)
+    {
+        dialog->left = (double)(meta->play_res_x >> 1) -
+                (dialog->width / 2.);
+        dialog->center = dialog->left + (dialog->width / 2.);
+        dialog->right = dialog->left + dialog->width;
+        dialog->x = dialog->center;
+    }
+    else
+    {
+        dialog->left = meta->play_res_x - (dialog->margin_r != 0. ?
+                    dialog->margin_r :
+                    style->margin_r) - dialog->width;
+        dialog->center = dialog->left + (dialog->width / 2.);
+        dialog->right = dialog->left + dialog->width;
+        dialog->x = dialog->right;
+    }
+
+    // Vertical position
+    if (style->alignment > 6)
+    {
+        dialog->top = (dialog->margin_v != 0. ?
+                    dialog->margin_v :
+                    style->margin_v);
+        dialog->middle = dialog->top + (dialog->height / 2.);
+        dialog->bottom = dialog->top + dialog->height;
+        dialog->y = dialog->top;
+    }
+    else if (style->alignment > 3)
+    {
+        dialog->top = (double)(meta->play_res_y >> 1) -
+                (dialog->height / 2.);
+        dialog->middle = dialog->top + (dialog->height / 2.);
+        dialog->bottom = dialog->top + dialog->height;
+        dialog->y = dialog->middle;
+    }
+    else
+    {
+        dialog->top = meta->play_res_y - (dialog->margin_v != 0. ?
+                    dialog->margin_v :
+                    style->margin_v) - dialog->height;
+        dialog->middle = dialog->top + (dialog->height / 2.);
+        dialog->bottom = dialog->top + dialog->height;
+        dialog->y = dialog->bottom;
+    }
+}
+
+uint8_t AssExtendWorker_dialog(AssExtendWorker *worker,
+                               subfx_ass_dialog *dialog)
+{
+    FontCacheEntry *entry = FontCache_get(&worker->fonts,
+                                          dialog->styleref,
+                                          worker->errMsg);
+    if (!entry)
+    {
+        if (!worker->errMsg[0])
+        {
+            subfx_pError(worker->errMsg,
+                         "extendDialogs: Fail to create FontHandle");
+        }
+
+        return 1;
+    }
+
+    subfx_fontHandle *font = entry->handle;
+
+    // metrics do not depend on the text
+    TEXT_SIZE metrics;
+    metrics.ascent = entry->metrics[subfx_fonthandle_metrics_ascent];
+    metrics.descent = entry->metrics[subfx_fonthandle_metrics_descent];
+    metrics.internal_leading =
+            entry->metrics[subfx_fonthandle_metrics_internal_leading];
+    metrics.external_leading =
+            entry->metrics[subfx_fonthandle_metrics_external_leading];
+
+    dialog->text_stripped = stripTags(worker,
+                                      dialog->text,
+                                      dialog->text_len,
+                                      &dialog->text_stripped_len);
+    if (!dialog->text_stripped)
+    {
+        subfx_pError(worker->errMsg,
+                     "extendDialogs: Fail to allocate memory.");
+        return 1;
+    }
+
+    TEXT_SIZE size;
+    if (textSize(worker, font, &metrics,
+                 dialog->text_stripped, dialog->text_stripped_len, &size))
+    {
+        return 1;
+    }
+
+    SET_TEXT_SIZE(dialog, size)
+    dialogPosition(dialog, worker->meta);
+
+    if (textSize(worker, font, &metrics, " ", 1, &size))
+    {
+        return 1;
+    }
+
+    double space_width = size.width;
+
+    dialog->textChunked = createVector(50);
+    dialog->syls = createVector(50);
+    dialog->words = createVector(50);
+    dialog->chars = createVector(50);
+    if (!dialog->textChunked || !dialog->syls ||
+        !dialog->words || !dialog->chars)
+    {
+        subfx_pError(worker->errMsg,
+                     "extendDialogs: Fail to allocate memory.");
+        return 1;
+    }
+
+    // Add dialog text chunks
+    if (addTextChunks(worker, dialog))
+    {
+        subfx_pError(worker->errMsg,
+                     "extendDialogs: Fail to split text chunks.");
+        return 1;
+    }
+
+    // Add dialog sylables
+    if (addSyls(worker, dialog, font, &metrics))
+    {
+        if (!worker->errMsg[0])
+        {
+            subfx_pError(worker->errMsg,
+                         "extendDialogs: Fail to add syls.");
+        }
+
+        return 1;
+    }
+
+    sylPositions(dialog, worker->meta, space_width);
+
+    // Add dialog words
+    if (addWords(worker, dialog, font, &metrics))
+    {
+        if (!worker->errMsg[0])
+        {
+            subfx_pError(worker->errMsg,
+                         "extendDialogs: Fail to add words.");
+        }
+
+        return 1;
+    }
+
+    wordPositions(dialog, worker->meta, space_width);
+
+    // Add dialog characters
+    if (addChars(worker, dialog, font, &metrics))
+    {
+        if (!worker->errMsg[0])
+        {
+            subfx_pError(worker->errMsg,
+                         "extendDialogs: Fail to add chars.");
+        }
+
+        return 1;
+    }
+
+    charPositions(dialog, worker->meta);
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "arena.h"
+#include "assparser.h"
+#include "assparserregex.h"
+#include "fontcache.h"
+#include "mutex.h"
+#include "regex.h"
+#include "thread.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define ASS_EXTEND_ERR_LEN 1024
+
+/**
+ * Dialogs waiting for extension.
+ * Workers take them in order, a few at a time.
+ */
+typedef struct AssExtendQueue
+{
+    Mutex mutex;
+
+    fdsa_ptrVector *dialogs;
+
+    size_t size;
+
+    size_t next;
+
+    // set when any worker fails, no more dialogs are taken after that
+    bool failed;
+} AssExtendQueue;
+
+/**
+ * Everything a worker needs that can not be shared:
+ * regex match data, font handles and the memory for the results.
+ * A worker only writes to the dialogs it takes from the queue.
+ */
+typedef struct AssExtendWorker
+{
+    const subfx_ass_meta *meta;
+
+    AssExtendQueue *queue;
+
+    Regex regex[REGEX_EXTEND_COUNT];
+
+    // font handles of the styles this worker has seen
+    FontCache fonts;
+
+    // moved into the parser's arena when the worker is done
+    Arena arena;
+
+    Thread thread;
+
+    // index of the first dialog this worker failed on, SIZE_MAX if none
+    size_t failedAt;
+
+    char errMsg[ASS_EXTEND_ERR_LEN];
+} AssExtendWorker;
+
+uint8_t AssExtendQueue_init(AssExtendQueue *, fdsa_ptrVector *dialogs);
+
+void AssExtendQueue_fin(AssExtendQueue *);
+
+uint8_t AssExtendWorker_init(AssExtendWorker *,
+                             const subfx_ass_meta *,
+                             AssExtendQueue *);
+
+void AssExtendWorker_fin(AssExtendWorker *);
+
+// ThreadFunc, takes dialogs from the queue until it is empty
+void AssExtendWorker_run(void *worker);
+
+/**
+ * Fills text_stripped, sizes, positions, textChunked, syls, words and
+ * chars of a dialog. i, duration, mid_time and styleref must be set.
+ */
+uint8_t AssExtendWorker_dialog(AssExtendWorker *, subfx_ass_dialog *);
+
+#ifdef __cplusplus
+}
+#endif
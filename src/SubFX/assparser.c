@@ -17,37 +17,41 @@
 *    <http://www.gnu.org/licenses/>.
 */
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "arena.h"
 #include "ass/data.h"
 #include "ass.h"
+#include "assextend.h"
 #include "assparser.h"
-#include "assparserregex.h"
+#include "asstokenizer.h"
 #include "common.h"
 #include "global.h"
-#include "misc.h"
-#include "regex.h"
+#include "mappedfile.h"
 
-#define SUBSTRING_LEN 8192
-static PCRE2_UCHAR subStr[SUBSTRING_LEN];
-static PCRE2_SIZE subStrLen = SUBSTRING_LEN;
-
-static Regex subfx_assParser_regex[REGEX_COUNT] = {0};
+static void noFree(void *in)
+{
+    // dialogs are in the parser's arena
+    UNUSED(in);
+}
 
-static void destoryDialogs(void *in)
+static void destoryDialogVectors(subfx_ass_dialog *dialog)
 {
-    if (!in) return;
+    if (!dialog) return;
 
     fDSA *fdsa = getFDSA();
-    subfx_ass_dialog *dialog = (subfx_ass_dialog *)in;
-
     if (dialog->textChunked) fdsa->ptrVector.destory(dialog->textChunked);
     if (dialog->syls) fdsa->ptrVector.destory(dialog->syls);
     if (dialog->words) fdsa->ptrVector.destory(dialog->words);
     if (dialog->chars) fdsa->ptrVector.destory(dialog->chars);
-    free(in);
+
+    dialog->textChunked = NULL;
+    dialog->syls = NULL;
+    dialog->words = NULL;
+    dialog->chars = NULL;
 }
 
 static void myFree(void *in)
@@ -70,103 +74,40 @@ subfx_exitstate subfx_assParser_init(subfx_assParser_api *ret)
 {
     if (!ret) return subfx_failed;
 
-    subfx_assParser_fin();
-
-    if (subfx_assParser_parseLineRegexInit())
-    {
-        subfx_assParser_fin();
-        return subfx_failed;
-    }
-
     ret->create = subfx_assParser_create;
     ret->destory = subfx_assParser_destory;
     ret->dialogIsExtended = subfx_assParser_dialogIsExtended;
     ret->extendDialogs = subfx_assParser_extendDialogs;
+    ret->extendDialogs2 = subfx_assParser_extendDialogs2;
+    ret->fontCacheStats = subfx_assParser_fontCacheStats;
 
     return subfx_success;
 }
 
-void subfx_assParser_fin()
-{
-    int index;
-    for (index = 0; index < REGEX_COUNT; ++index)
-    {
-        RegexData_fin(&subfx_assParser_regex[index]);
-    }
-
-    memset(subfx_assParser_regex, 0, REGEX_COUNT * sizeof(Regex));
-}
-
-uint8_t subfx_assParser_parseLineRegexInit()
+subfx_assParser *subfx_assParser_create(const char *fileName,
+                                        const char *warningOut,
+                                        char *errMsg)
 {
-    subfx_assParser_fin();
-    if (RegexData_init(&subfx_assParser_regex[REGEX_ASS_SECION_MARK],
-                       REGEX_STR_ASS_SECION_MARK))
-    {
-        return 1;
-    }
-
-    if (RegexData_init(&subfx_assParser_regex[REGEX_WRAP_STYLE],
-                       REGEX_STR_WRAP_STYLE))
-    {
-        return 1;
-    }
-
-    if (RegexData_init(&subfx_assParser_regex[REGEX_SCALED_BORDER_AND_SHADOW],
-                       REGEX_STR_SCALED_BORDER_AND_SHADOW))
-    {
-        return 1;
-    }
-
-    if (RegexData_init(&subfx_assParser_regex[REGEX_PLAY_RES_X],
-                       REGEX_STR_PLAY_RES_X))
-    {
-        return 1;
-    }
-
-    if (RegexData_init(&subfx_assParser_regex[REGEX_PLAY_RES_Y],
-                       REGEX_STR_PLAY_RES_Y))
-    {
-        return 1;
-    }
-
-    if (RegexData_init(&subfx_assParser_regex[REGEX_YCBCR_MATRIX],
-                       REGEX_STR_YCBCR_MATRIX))
-    {
-        return 1;
-    }
-
-    if (RegexData_init(&subfx_assParser_regex[REGEX_V4_STYLES],
-                       REGEX_STR_V4_STYLES))
-    {
-        return 1;
-    }
-
-    if (RegexData_init(&subfx_assParser_regex[REGEX_EVENTS],
-                       REGEX_STR_EVENTS))
+    AssParser *ret = calloc(1, sizeof(AssParser));
+    if (!ret)
     {
-        return 1;
+        return NULL;
     }
 
-    return 0;
-}
+    Arena_init(&ret->arena, 0);
 
-subfx_assParser *subfx_assParser_create(const char *fileName,
-                                        const char *warningOut,
-                                        char *errMsg)
-{
-    FILE *assFile;
-    assFile = fopen(fileName, "r");
-    if (!assFile)
+    if (MappedFile_init(&ret->file, fileName))
     {
         subfx_pError(errMsg, "assParser_create: CANNOT open file.");
+        free(ret);
         return NULL;
     }
 
-    AssParser *ret = calloc(1, sizeof(AssParser));
-    if (!ret)
+    if (!ret->file.size)
     {
-        fclose(assFile);
+        subfx_pError(errMsg, "assParser_create: Is input "
+                             "an empty file?");
+        subfx_assParser_destory((subfx_assParser *)ret);
         return NULL;
     }
 
@@ -181,23 +122,20 @@ subfx_assParser *subfx_assParser_create(const char *fileName,
 
     if (!ret->logger)
     {
-        fclose(assFile);
         subfx_assParser_destory((subfx_assParser *)ret);
         return NULL;
     }
 
     fDSA *fdsa = getFDSA();
-    ret->dialogs = fdsa->ptrVector.create(destoryDialogs);
+    ret->dialogs = fdsa->ptrVector.create(noFree);
     if (!ret->dialogs)
     {
-        fclose(assFile);
         subfx_assParser_destory((subfx_assParser *)ret);
         return NULL;
     }
 
     if (fdsa->ptrVector.reserve(ret->dialogs, 1000) == fdsa_failed)
     {
-        fclose(assFile);
         subfx_assParser_destory((subfx_assParser *)ret);
         return NULL;
     }
@@ -205,56 +143,27 @@ subfx_assParser *subfx_assParser_create(const char *fileName,
     ret->styles = fdsa->ptrMap.create(myStrcmp, myFree, myFree);
     if (!ret->styles)
     {
-        fclose(assFile);
         subfx_assParser_destory((subfx_assParser *)ret);
         return NULL;
     }
 
     subfx_ass_meta_init(&ret->meta);
-    char tmpString[65536];
-    uint8_t flag = 1;
+    subfx_ass_style_init(&ret->defaultStyle);
     uint8_t flags[] = {0, 0, 0, 0};
-    subfx_exitstate exitstate;
-    while(1)
-    {
-        exitstate = subfx_misc_getLine(tmpString, 65536, assFile, NULL);
-        if (exitstate == subfx_eof) break;
-        else if (exitstate == subfx_failed)
-        {
-            fclose(assFile);
-            subfx_assParser_destory((subfx_assParser *)ret);
-            return NULL;
-        }
-
-        if (flag)
-        {
-            // for safety
-            size_t len = strlen(tmpString);
-            if (!len) // len == 0
-            {
-                subfx_pError(errMsg, "assParser_create: Is input "
-                                     "an empty file?");
-                fclose(assFile);
-                subfx_assParser_destory((subfx_assParser *)ret);
-                return NULL;
-            }
-
-            flag = 0;
-            subfx_assParser_checkBom(ret,
-                                     (uint8_t *)tmpString,
-                                     &len);
-        }
+    size_t offset = 0;
+    const char *line;
+    size_t lineLen;
 
-        if (subfx_assParser_parseLine(ret, tmpString, flags, errMsg))
+    subfx_assParser_checkBom(ret, &offset);
+    while (MappedFile_nextLine(&ret->file, &offset, &line, &lineLen))
+    {
+        if (subfx_assParser_parseLine(ret, line, lineLen, flags, errMsg))
         {
-            fclose(assFile);
             subfx_assParser_destory((subfx_assParser *)ret);
             return NULL;
         }
     }
 
-    fclose(assFile);
-
     size_t size;
     // check ass file is valid or not
     if (fdsa->ptrVector.size(ret->dialogs, &size) == fdsa_failed)
@@ -338,21 +247,45 @@ subfx_exitstate subfx_assParser_destory(subfx_assParser *in)
     fDSA *fdsa = getFDSA();
     AssParser *parser = (AssParser *)in;
 
-    if (parser->dialogs) fdsa->ptrVector.destory(parser->dialogs);
+    if (parser->dialogs)
+    {
+        size_t size, i;
+        if (fdsa->ptrVector.size(parser->dialogs, &size) == fdsa_success)
+        {
+            for (i = 0; i < size; ++i)
+            {
+                destoryDialogVectors(fdsa->ptrVector.at(parser->dialogs, i));
+            }
+        }
+
+        fdsa->ptrVector.destory(parser->dialogs);
+    }
+
     if (parser->logger) subfx_logger_destroy(parser->logger);
     if (parser->styles) fdsa->ptrMap.destory(parser->styles);
+    MappedFile_fin(&parser->file);
+
+    // every string and dialog is released here in one shot
+    Arena_fin(&parser->arena);
 
     free(parser);
     return subfx_success;
 }
 
 subfx_exitstate subfx_assParser_extendDialogs(subfx_assParser *in, char *errMsg)
+{
+    return subfx_assParser_extendDialogs2(in, 0, errMsg);
+}
+
+subfx_exitstate subfx_assParser_extendDialogs2(subfx_assParser *in,
+                                               uint32_t threads,
+                                               char *errMsg)
 {
     if (!in) return subfx_failed;
     AssParser *parser = (AssParser *)in;
     if (parser->dialogParsed) return subfx_success;
 
-    return subfx_assParser_parseDialogs(parser, errMsg);
+    return subfx_assParser_parseDialogs(parser, threads, errMsg);
 }
 
 subfx_exitstate subfx_assParser_dialogIsExtended(subfx_assParser *in,
@@ -364,9 +297,21 @@ subfx_exitstate subfx_assParser_dialogIsExtended(subfx_assParser *in,
     return subfx_success;
 }
 
-void subfx_assParser_checkBom(AssParser *parser, uint8_t *in, size_t *inLen)
+subfx_exitstate subfx_assParser_fontCacheStats(subfx_assParser *in,
+                                               size_t *hits,
+                                               size_t *misses)
 {
-    if (*inLen < 3) return;
+    if (!in || !hits || !misses) return subfx_failed;
+    AssParser *parser = (AssParser *)in;
+    *hits = parser->fontCacheHits;
+    *misses = parser->fontCacheMisses;
+    return subfx_success;
+}
+
+void subfx_assParser_checkBom(AssParser *parser, size_t *offset)
+{
+    const uint8_t *in = (const uint8_t *)parser->file.data;
+    if (parser->file.size < 3) return;
 
     // utf-8 bom
     if (in[0] != 0xef ||
@@ -377,492 +322,397 @@ void subfx_assParser_checkBom(AssParser *parser, uint8_t *in, size_t *inLen)
     }
 
     subfx_logger_writeErr(parser->logger, "Warning: Remove utf-8 bom.\n");
-    memmove(in, in + 3, *inLen - 2); // one more for '\0'
-    *inLen -= 3;
+    *offset = 3;
 }
 
-uint8_t subfx_assParser_parseLine(AssParser *parser,
-                                  const char *line,
-                                  uint8_t *flags,
-                                  char *errMsg)
+static bool parseNonNegative(const AssField *field, double *out)
 {
-    fDSA *fdsa = getFDSA();
-    int pcreRet;
-    if (!RegexData_match(&subfx_assParser_regex[REGEX_ASS_SECION_MARK],
-                         line,
-                         &pcreRet))
-    {
-        // ass section mark
-        // [XXX]
-        // if (res == "Script Info")
-        if (!strcmp(line, "[Script Info]"))
-        {
-            if (flags[Script_Info])
-            {
-                subfx_pError(errMsg, "parseLine: Input is not a valid ass file.");
-                return 1;
-            }
+    return (AssTokenizer_toDouble(field, out) && *out >= 0.);
+}
 
-            parser->section = Script_Info;
-            ++flags[Script_Info];
-        }
-        else if (!strcmp(line, "[V4+ Styles]"))
-        {
-            if (flags[V4_Styles])
-            {
-                subfx_pError(errMsg,
-                             "parseLine: Input is not a valid ass file.");
-                return 1;
-            }
+static bool parseFlag(const AssField *field, int8_t *out)
+{
+    int64_t value;
+    if (!AssTokenizer_toInt(field, &value) || value < -1 || value > 1)
+    {
+        return false;
+    }
 
-            parser->section = V4_Styles;
-            ++flags[V4_Styles];
-        }
-        else if (!strcmp(line, "[Events]"))
-        {
-            if (flags[Events])
-            {
-                subfx_pError(errMsg,
-                             "parseLine: Input is not a valid ass file.");
-                return 1;
-            }
+    *out = (int8_t)value;
+    return true;
+}
 
-            parser->section = Events;
-            ++flags[Events];
-        }
+static bool parseColorAlpha(const AssField *field,
+                            char *color,
+                            char *alpha,
+                            char *errMsg)
+{
+    uint8_t rgba[4];
+    if (!AssTokenizer_toColorAlpha(field, rgba))
+    {
+        return false;
+    }
 
-        return 0;
+    if (subfx_ass_colorAlphaToString(rgba, 3, color, errMsg) == subfx_failed)
+    {
+        return false;
     }
 
-    size_t lineLen = strlen(line);
-    switch (parser->section)
+    return (subfx_ass_colorAlphaToString(rgba + 3, 1, alpha, errMsg) !=
+            subfx_failed);
+}
+
+// return false if the line is not a valid style
+static bool parseStyleFields(const AssField *fields,
+                             subfx_ass_style *style,
+                             char *errMsg)
+{
+    int64_t value;
+    if (!AssTokenizer_toInt(&fields[22], &value) || value < 0 ||
+        value > INT32_MAX)
     {
-    case Script_Info:
+        return false;
+    }
+
+    style->encoding = (int)value;
+    if (style->encoding <= 255)
     {
-        if (RegexData_match(&subfx_assParser_regex[REGEX_WRAP_STYLE],
-                            line,
-                            &pcreRet))
+        AssTokenizer_copy(&fields[1], style->fontname, SUBFX_FONT_NAME_LEN);
+
+        if (!AssTokenizer_toInt(&fields[2], &value) || value < 0 ||
+            value > INT32_MAX)
         {
-            if (sscanf(line, "WrapStyle: %s", &parser->meta.wrap_style) != 1)
-            {
-                subfx_pError(errMsg,
-                             "parseLine: Syntax error in\n "
-                             "\"Script info\" -> \"WrapStyle\"");
-                return 1;
-            }
+            return false;
         }
-        else if (RegexData_match(
-                     &subfx_assParser_regex[REGEX_SCALED_BORDER_AND_SHADOW],
-                     line,
-                     &pcreRet))
+
+        style->fontsize = (int)value;
+
+        // fields[3~6] are not here
+        if (!parseFlag(&fields[7], &style->bold) ||
+            !parseFlag(&fields[8], &style->italic) ||
+            !parseFlag(&fields[9], &style->underline) ||
+            !parseFlag(&fields[10], &style->strikeout))
         {
-            // std::string res(line+ 23);
-            parser->meta.scaled_border_and_shadow =
-                    (!strcmp(line + 23, "Yes") ||
-                     !strcmp(line + 23, "yes"));
+            return false;
         }
-        else if (RegexData_match(
-                     &subfx_assParser_regex[REGEX_PLAY_RES_X],
-                     line,
-                     &pcreRet))
-        {
-            if (sscanf(line, "PlayResX: %hd", &parser->meta.play_res_x) != 1)
-            {
-                subfx_pError(errMsg,
-                             "parseLine: Syntax error in\n"
-                             "\"Script info\" -> \"PlayResX\"");
-                return 1;
-            }
-        }
-        else if (RegexData_match(
-                     &subfx_assParser_regex[REGEX_PLAY_RES_Y],
-                     line,
-                     &pcreRet))
+
+        if (!parseNonNegative(&fields[11], &style->scale_x) ||
+            !parseNonNegative(&fields[12], &style->scale_y) ||
+            !AssTokenizer_toDouble(&fields[13], &style->spaceing) ||
+            !AssTokenizer_toDouble(&fields[14], &style->angle))
         {
-            if (sscanf(line, "PlayResY: %hd", &parser->meta.play_res_y) != 1)
-            {
-                subfx_pError(errMsg,
-                             "parseLine: Syntax error in\n"
-                             "\"Script info\" -> \"PlayResY\"");
-                return 1;
-            }
+            return false;
         }
-        else if (RegexData_match(
-                     &subfx_assParser_regex[REGEX_YCBCR_MATRIX],
-                     line,
-                     &pcreRet))
+
+        if (!AssTokenizer_toInt(&fields[15], &value) ||
+            (value != 1 && value != 3))
         {
-            memcpy(parser->meta.colorMatrix, line + 14, lineLen - 14);
-            parser->meta.colorMatrix[lineLen - 14] = '\0';
+            return false;
         }
-        break;
-    }
-    case V4_Styles:
-    {
-        /*
-        boost::u32regex reg(boost::make_u32regex(
-            "^Style: (.*),(.*),(\\d+),(&H[0-9A-F]{8}),(&H[0-9A-F]{8}),"
-            "(&H[0-9A-F]{8}),(&H[0-9A-F]{8}),(-?[01]),(-?[01]),(-?[01]),"
-            "(-?[01]),(\\d+\\.?\\d*),(\\d+\\.?\\d*),(-?\\d+\\.?\\d*),"
-            "(-?\\d+\\.?\\d*),([13]),(\\d+\\.?\\d*),(\\d+\\.?\\d*),([1-9]),"
-            "(\\d+\\.?\\d*),(\\d+\\.?\\d*),(\\d+\\.?\\d*),(\\d+)$"));
-        boost::smatch match;
-        */
-
-        if (!RegexData_match(
-                &subfx_assParser_regex[REGEX_V4_STYLES],
-                line,
-                &pcreRet))
+
+        style->bolder_style = (uint8_t)value;
+
+        if (!parseNonNegative(&fields[16], &style->outline) ||
+            !parseNonNegative(&fields[17], &style->shadow))
         {
-            break;
+            return false;
         }
 
-        subfx_ass_style *style = calloc(1, sizeof(subfx_ass_style));
-        if (!style)
+        if (!AssTokenizer_toInt(&fields[18], &value) || value < 1 ||
+            value > 9)
         {
-            return 1;
+            return false;
         }
 
-        subfx_ass_style_init(style);
-
-
-        break;
-
-        /*
+        style->alignment = (uint8_t)value;
 
-        if(boost::u32regex_search(line, match, reg))
+        if (!parseNonNegative(&fields[19], &style->margin_l) ||
+            !parseNonNegative(&fields[20], &style->margin_r) ||
+            !parseNonNegative(&fields[21], &style->margin_v))
         {
-            try
-            {
-                style->encoding =
-                        lexical_cast<int>(match[static_cast<int>(match.size()) - 1]);
-            }
-            catch (...)
-            {
-                subfx_pError(errMsg, "parseLine: Error in parsing "
-                                            "style's encoding.");
-                free(style);
-                return 1;
-            }
-
-            if (style->encoding <= 255)
-            {
-                try
-                {
-                    memcpy(style->fontname,
-                           match[2].str().c_str(),
-                           match[2].str().length());
-
-                    style->fontsize = lexical_cast<int>(match[3]);
-
-                    // match[4~7] are not here
-
-                    // boost will throw error when the number is negative.
-                    std::string tmpString = match[8];
-                    sscanf(tmpString.c_str(), "%" SCNd8, &(style->bold));
-
-                    tmpString = match[9];
-                    sscanf(tmpString.c_str(), "%" SCNd8, &(style->italic));
-
-                    tmpString = match[10];
-                    sscanf(tmpString.c_str(), "%" SCNd8, &(style->underline));
+            return false;
+        }
+    }
 
-                    tmpString = match[11];
-                    sscanf(tmpString.c_str(), "%" SCNd8, &(style->strikeout));
+    return (parseColorAlpha(&fields[3], style->color1, style->alpha1, errMsg) &&
+            parseColorAlpha(&fields[4], style->color2, style->alpha2, errMsg) &&
+            parseColorAlpha(&fields[5], style->color3, style->alpha3, errMsg) &&
+            parseColorAlpha(&fields[6], style->color4, style->alpha4, errMsg));
+}
 
-                    tmpString = match[12];
-                    sscanf(tmpString.c_str(), "%lf", &(style->scale_x));
+static uint8_t parseStyle(AssParser *parser,
+                          const AssField *value,
+                          char *errMsg)
+{
+    AssField fields[ASS_STYLE_FIELDS];
+    if (AssTokenizer_split(value, fields, ASS_STYLE_FIELDS) !=
+        ASS_STYLE_FIELDS)
+    {
+        subfx_logger_writeErr(parser->logger,
+                              "Warning: Skip invalid style line.\n");
+        return 0;
+    }
 
-                    tmpString = match[13];
-                    sscanf(tmpString.c_str(), "%lf", &(style->scale_y));
+    subfx_ass_style *style = calloc(1, sizeof(subfx_ass_style));
+    if (!style)
+    {
+        return 1;
+    }
 
-                    tmpString = match[14];
-                    sscanf(tmpString.c_str(), "%lf", &(style->spaceing));
+    subfx_ass_style_init(style);
+    if (!parseStyleFields(fields, style, errMsg))
+    {
+        subfx_logger_writeErr(parser->logger,
+                              "Warning: Skip invalid style line.\n");
+        free(style);
+        return 0;
+    }
 
-                    tmpString = match[15];
-                    sscanf(tmpString.c_str(), "%lf", &(style->angle));
+    char *key = calloc(fields[0].len + 1, sizeof(char));
+    if (!key)
+    {
+        free(style);
+        return 1;
+    }
 
-                    style->bolder_style = lexical_cast<uint8_t>(match[16]);
+    memcpy(key, fields[0].str, fields[0].len);
+    key[fields[0].len] = '\0';
 
-                    tmpString = match[17];
-                    sscanf(tmpString.c_str(), "%lf", &(style->outline));
+    fDSA *fdsa = getFDSA();
+    if (fdsa->ptrMap.insertNode(parser->styles, key, style) == fdsa_failed)
+    {
+        free(key);
+        free(style);
+        return 1;
+    }
 
-                    tmpString = match[18];
-                    sscanf(tmpString.c_str(), "%lf", &(style->shadow));
+    return 0;
+}
 
-                    style->alignment = lexical_cast<uint8_t>(match[19]);
+// return false if the line is not a valid dialog
+static bool parseDialogFields(const AssField *fields,
+                              subfx_ass_dialog *dialog)
+{
+    int64_t value;
+    if (!AssTokenizer_toInt(&fields[0], &value) || value < 0 ||
+        value > UINT32_MAX)
+    {
+        return false;
+    }
 
-                    tmpString = match[20];
-                    sscanf(tmpString.c_str(), "%lf", &(style->margin_l));
+    dialog->layer = (uint32_t)value;
 
-                    tmpString = match[21];
-                    sscanf(tmpString.c_str(), "%lf", &(style->margin_r));
+    if (!AssTokenizer_toMs(&fields[1], &dialog->start_time) ||
+        !AssTokenizer_toMs(&fields[2], &dialog->end_time))
+    {
+        return false;
+    }
 
-                    tmpString = match[22];
-                    sscanf(tmpString.c_str(), "%lf", &(style->margin_v));
-                }
-                catch (...)
-                {
-                    subfx_pError(errMsg, "parseLine: Error when parsing"
-                                                " style.");
-                    free(style);
-                    return 1;
-                }
-            }
+    // style's name can not be empty
+    if (!fields[3].len)
+    {
+        return false;
+    }
 
-            std::string tmpString;
-            char buf1[64], buf2[64];
-            uint8_t buf1Size;
-
-            // stringToColorAlpha may throw exception
-            // but ignore here
-            // color1 and alpha1
-            tmpString = match[4];
-            if (subfx_ass_stringToColorAlpha(tmpString.c_str(),
-                                             buf1,
-                                             &buf1Size,
-                                             errMsg) == subfx_failed)
-            {
-                free(style);
-                return 1;
-            }
+    if (!parseNonNegative(&fields[5], &dialog->margin_l) ||
+        !parseNonNegative(&fields[6], &dialog->margin_r) ||
+        !parseNonNegative(&fields[7], &dialog->margin_v))
+    {
+        return false;
+    }
 
-            if (subfx_ass_colorAlphaToString(
-                        reinterpret_cast<uint8_t *>(buf1),
-                        3,
-                        buf2,
-                        errMsg) == subfx_failed)
-            {
-                free(style);
-                return 1;
-            }
+    AssTokenizer_copy(&fields[3], dialog->style, sizeof(dialog->style));
+    AssTokenizer_copy(&fields[4], dialog->actor, sizeof(dialog->actor));
+    AssTokenizer_copy(&fields[8], dialog->effect, sizeof(dialog->effect));
+    return true;
+}
 
-            memcpy(style->color1, buf2, strlen(buf2) + 1); // one more for '\0'
+static uint8_t parseDialog(AssParser *parser,
+                           const AssField *value,
+                           bool comment)
+{
+    AssField fields[ASS_EVENT_FIELDS];
+    if (AssTokenizer_split(value, fields, ASS_EVENT_FIELDS) !=
+        ASS_EVENT_FIELDS)
+    {
+        subfx_logger_writeErr(parser->logger,
+                              "Warning: Skip invalid dialog line.\n");
+        return 0;
+    }
 
-            buf1[0] = buf1[3];
-            if (subfx_ass_colorAlphaToString(
-                        reinterpret_cast<uint8_t *>(buf1),
-                        1,
-                        buf2,
-                        errMsg) == subfx_failed)
-            {
-                free(style);
-                return 1;
-            }
+    // validate on the stack first, so that invalid lines
+    // do not leave anything in the arena
+    subfx_ass_dialog tmp;
+    memset(&tmp, 0, sizeof(subfx_ass_dialog));
+    if (!parseDialogFields(fields, &tmp))
+    {
+        subfx_logger_writeErr(parser->logger,
+                              "Warning: Skip invalid dialog line.\n");
+        return 0;
+    }
 
-            memcpy(style->alpha1, buf2, strlen(buf2) + 1); // one more for '\0'
+    tmp.comment = comment;
+    tmp.text_len = fields[9].len;
+    tmp.text = Arena_strndup(&parser->arena, fields[9].str, fields[9].len);
+    if (!tmp.text)
+    {
+        return 1;
+    }
 
-            // color2 and alpha2
-            tmpString = match[5];
-            if (subfx_ass_stringToColorAlpha(tmpString.c_str(),
-                                             buf1,
-                                             &buf1Size,
-                                             errMsg) == subfx_failed)
-            {
-                free(style);
-                return 1;
-            }
+    subfx_ass_dialog *dialog = Arena_alloc(&parser->arena,
+                                           sizeof(subfx_ass_dialog));
+    if (!dialog)
+    {
+        return 1;
+    }
 
-            if (subfx_ass_colorAlphaToString(
-                        reinterpret_cast<uint8_t *>(buf1),
-                        3,
-                        buf2,
-                        errMsg) == subfx_failed)
-            {
-                free(style);
-                return 1;
-            }
+    memcpy(dialog, &tmp, sizeof(subfx_ass_dialog));
 
-            memcpy(style->color2, buf2, strlen(buf2) + 1); // one more for '\0'
+    fDSA *fdsa = getFDSA();
+    if (fdsa->ptrVector.pushBack(parser->dialogs, dialog) == fdsa_failed)
+    {
+        return 1;
+    }
 
-            buf1[0] = buf1[3];
-            if (subfx_ass_colorAlphaToString(
-                        reinterpret_cast<uint8_t *>(buf1),
-                        1,
-                        buf2,
-                        errMsg) == subfx_failed)
-            {
-                free(style);
-                return 1;
-            }
+    return 0;
+}
 
-            memcpy(style->alpha2, buf2, strlen(buf2) + 1); // one more for '\0'
+static uint8_t parseSection(AssParser *parser,
+                            const AssField *name,
+                            uint8_t *flags,
+                            char *errMsg)
+{
+    PARSER_SECTION section;
+    if (AssTokenizer_equals(name, "Script Info"))
+    {
+        section = Script_Info;
+    }
+    else if (AssTokenizer_equals(name, "V4+ Styles"))
+    {
+        section = V4_Styles;
+    }
+    else if (AssTokenizer_equals(name, "Events"))
+    {
+        section = Events;
+    }
+    else
+    {
+        // unknown sections, e.g. [Fonts], are ignored
+        // and the current section is kept as before
+        return 0;
+    }
 
-            // color3 and alpha3
-            tmpString = match[6];
-            if (subfx_ass_stringToColorAlpha(tmpString.c_str(),
-                                             buf1,
-                                             &buf1Size,
-                                             errMsg) == subfx_failed)
-            {
-                free(style);
-                return 1;
-            }
+    if (flags[section])
+    {
+        subfx_pError(errMsg, "parseLine: Input is not a valid ass file.");
+        return 1;
+    }
 
-            if (subfx_ass_colorAlphaToString(
-                        reinterpret_cast<uint8_t *>(buf1),
-                        3,
-                        buf2,
-                        errMsg) == subfx_failed)
-            {
-                free(style);
-                return 1;
-            }
+    parser->section = section;
+    ++flags[section];
+    return 0;
+}
 
-            memcpy(style->color3, buf2, strlen(buf2) + 1); // one more for '\0'
+uint8_t subfx_assParser_parseLine(AssParser *parser,
+                                  const char *line,
+                                  size_t lineLen,
+                                  uint8_t *flags,
+                                  char *errMsg)
+{
+    AssField value;
+    ASS_LINE_TYPE type = AssTokenizer_classify(line, lineLen, &value);
+    if (type == AssLine_Section)
+    {
+        return parseSection(parser, &value, flags, errMsg);
+    }
 
-            buf1[0] = buf1[3];
-            if (subfx_ass_colorAlphaToString(
-                        reinterpret_cast<uint8_t *>(buf1),
-                        1,
-                        buf2,
-                        errMsg) == subfx_failed)
+    int64_t number;
+    switch (parser->section)
+    {
+    case Script_Info:
+    {
+        switch (type)
+        {
+        case AssLine_WrapStyle:
+        {
+            // WrapStyle is one digit
+            if (value.len != 1 || !AssTokenizer_toInt(&value, &number))
             {
-                free(style);
-                return 1;
+                break;
             }
 
-            memcpy(style->alpha3, buf2, strlen(buf2) + 1); // one more for '\0'
-
-            // color4 and alpha4
-            tmpString = match[7];
-            if (subfx_ass_stringToColorAlpha(tmpString.c_str(),
-                                             buf1,
-                                             &buf1Size,
-                                             errMsg) == subfx_failed)
+            parser->meta.wrap_style = (uint8_t)number;
+            break;
+        }
+        case AssLine_ScaledBorderAndShadow:
+        {
+            if (AssTokenizer_equals(&value, "Yes") ||
+                AssTokenizer_equals(&value, "yes"))
             {
-                free(style);
-                return 1;
+                parser->meta.scaled_border_and_shadow = true;
             }
-
-            if (subfx_ass_colorAlphaToString(
-                        reinterpret_cast<uint8_t *>(buf1),
-                        3,
-                        buf2,
-                        errMsg) == subfx_failed)
+            else if (AssTokenizer_equals(&value, "No") ||
+                     AssTokenizer_equals(&value, "no"))
             {
-                free(style);
-                return 1;
+                parser->meta.scaled_border_and_shadow = false;
             }
-
-            memcpy(style->color4, buf2, strlen(buf2) + 1); // one more for '\0'
-
-            buf1[0] = buf1[3];
-            if (subfx_ass_colorAlphaToString(
-                        reinterpret_cast<uint8_t *>(buf1),
-                        1,
-                        buf2,
-                        errMsg) == subfx_failed)
+            break;
+        }
+        case AssLine_PlayResX:
+        {
+            if (!AssTokenizer_toInt(&value, &number) ||
+                number < 0 || number > UINT16_MAX)
             {
-                free(style);
+                subfx_pError(errMsg,
+                             "parseLine: Syntax error in\n"
+                             "\"Script info\" -> \"PlayResX\"");
                 return 1;
             }
 
-            memcpy(style->alpha4, buf2, strlen(buf2) + 1); // one more for '\0'
-
-            tmpString = match[1];
-            char *key = reinterpret_cast<char *>
-                    (calloc(tmpString.length() + 1, sizeof(char)));
-            if (!key)
+            parser->meta.play_res_x = (uint16_t)number;
+            break;
+        }
+        case AssLine_PlayResY:
+        {
+            if (!AssTokenizer_toInt(&value, &number) ||
+                number < 0 || number > UINT16_MAX)
             {
-                free(style);
+                subfx_pError(errMsg,
+                             "parseLine: Syntax error in\n"
+                             "\"Script info\" -> \"PlayResY\"");
                 return 1;
             }
 
-            memcpy(key, tmpString.c_str(), tmpString.length());
-            key[tmpString.length()] = '\0';
-
-            if (fdsa->ptrMap.insertNode(parser->styles, key, style) == fdsa_failed)
-            {
-                free(key);
-                free(style);
-                return 1;
-            }
+            parser->meta.play_res_y = (uint16_t)number;
+            break;
+        }
+        case AssLine_YCbCrMatrix:
+        {
+            AssTokenizer_copy(&value,
+                              parser->meta.colorMatrix,
+                              sizeof(parser->meta.colorMatrix));
+            break;
+        }
+        default:
+        {
+            break;
+        }
+        } // end switch (type)
+        break;
+    }
+    case V4_Styles:
+    {
+        if (type == AssLine_Style)
+        {
+            return parseStyle(parser, &value, errMsg);
         }
         break;
-        */
     }
     case Events:
     {
-        boost::u32regex reg(boost::make_u32regex("^(.+): (\\d+),"
-                                                 "(\\d:\\d\\d:\\d\\d\\.\\d\\d),"
-                                                 "(\\d:\\d\\d:\\d\\d\\.\\d\\d),"
-                                                 "(.+),(.*),(\\d+\\.?\\d*),"
-                                                 "(\\d+\\.?\\d*),(\\d+\\.?\\d*),"
-                                                 "(|.*),(.*)$"));
-        boost::smatch match;
-        if(boost::u32regex_search(line, match, reg))
+        if (type == AssLine_Dialogue || type == AssLine_Comment)
         {
-            subfx_ass_dialog *dialog = reinterpret_cast<subfx_ass_dialog *>
-                    (calloc(1, sizeof(subfx_ass_dialog)));
-            if (!dialog)
-            {
-                return 1;
-            }
-
-            try
-            {
-                std::string tmpString = match[1];
-                dialog->comment = (tmpString == "Comment");
-
-                tmpString = match[2];
-                dialog->layer = lexical_cast<uint32_t>(tmpString);
-
-                tmpString = match[3];
-                if (subfx_ass_stringToMs(tmpString.c_str(),
-                                         &dialog->start_time,
-                                         errMsg) == subfx_failed)
-                {
-                    free(dialog);
-                    return 1;
-                }
-
-                tmpString = match[4];
-                if (subfx_ass_stringToMs(tmpString.c_str(),
-                                         &dialog->end_time,
-                                         errMsg) == subfx_failed)
-                {
-                    free(dialog);
-                    return 1;
-                }
-
-                tmpString = match[5];
-                memcpy(dialog->style, tmpString.c_str(), tmpString.length());
-                dialog->style[tmpString.length()] = '\0';
-
-                tmpString = match[6];
-                memcpy(dialog->actor, tmpString.c_str(), tmpString.length());
-                dialog->actor[tmpString.length()] = '\0';
-
-                tmpString = match[7];
-                sscanf(tmpString.c_str(), "%lf", &(dialog->margin_l));
-
-                tmpString = match[8];
-                sscanf(tmpString.c_str(), "%lf", &(dialog->margin_r));
-
-                tmpString = match[9];
-                sscanf(tmpString.c_str(), "%lf", &(dialog->margin_v));
-
-                tmpString = match[10];
-                memcpy(dialog->effect, tmpString.c_str(), tmpString.length());
-                dialog->effect[tmpString.length()] = '\0';
-
-                tmpString = match[11];
-                memcpy(dialog->text, tmpString.c_str(), tmpString.length());
-                dialog->text[tmpString.length()] = '\0';
-
-                if (fdsa->ptrVector.pushBack(parser->dialogs, dialog) == fdsa_failed)
-                {
-                    free(dialog);
-                    return 1;
-                }
-            }
-            catch (const bad_lexical_cast &)
-            {
-                subfx_pError(errMsg, "parseLine: Error when parsing dialog");
-                free(dialog);
-                return 1;
-            }
+            return parseDialog(parser, &value, (type == AssLine_Comment));
         }
         break;
     }
@@ -870,15 +720,78 @@ uint8_t subfx_assParser_parseLine(AssParser *parser,
     {
         break;
     }
+    } // end switch (parser->section)
+
+    return 0;
+}
+
+static int compareDialogs(const void *lhs, const void *rhs)
+{
+    const subfx_ass_dialog *a = *(const subfx_ass_dialog * const *)lhs;
+    const subfx_ass_dialog *b = *(const subfx_ass_dialog * const *)rhs;
+
+    // qsort() is not stable, the original order breaks the tie
+    if (a->start_time != b->start_time)
+    {
+        return (a->start_time < b->start_time) ? -1 : 1;
+    }
+
+    return (a->i < b->i) ? -1 : (a->i > b->i);
+}
+
+static uint8_t sortDialogs(AssParser *parser, size_t dialogsSize)
+{
+    fDSA *fdsa = getFDSA();
+    subfx_ass_dialog **buf = malloc(dialogsSize * sizeof(subfx_ass_dialog *));
+    if (!buf)
+    {
+        return 1;
+    }
+
+    size_t i;
+    for (i = 0; i < dialogsSize; ++i)
+    {
+        buf[i] = fdsa->ptrVector.at(parser->dialogs, i);
+    }
+
+    qsort(buf, dialogsSize, sizeof(subfx_ass_dialog *), compareDialogs);
+
+    fdsa_ptrVector *sorted = fdsa->ptrVector.create(noFree);
+    if (!sorted)
+    {
+        free(buf);
+        return 1;
+    }
+
+    if (fdsa->ptrVector.reserve(sorted, dialogsSize) == fdsa_failed)
+    {
+        fdsa->ptrVector.destory(sorted);
+        free(buf);
+        return 1;
     }
 
+    for (i = 0; i < dialogsSize; ++i)
+    {
+        if (fdsa->ptrVector.pushBack(sorted, buf[i]) == fdsa_failed)
+        {
+            fdsa->ptrVector.destory(sorted);
+            free(buf);
+            return 1;
+        }
+    }
+
+    // the dialogs are owned by the arena,
+    // so the old vector only releases its own buffer
+    fdsa->ptrVector.destory(parser->dialogs);
+    parser->dialogs = sorted;
+    free(buf);
     return 0;
 }
 
 subfx_exitstate subfx_assParser_parseDialogs(AssParser *parser,
+                                             uint32_t threads,
                                              char *errMsg)
 {
-    double space_width(0.);
     size_t dialogsSize;
     fDSA *fdsa = getFDSA();
     if (fdsa->ptrVector.size(parser->dialogs, &dialogsSize) == fdsa_failed)
@@ -888,12 +801,13 @@ subfx_exitstate subfx_assParser_parseDialogs(AssParser *parser,
        return subfx_failed;
     }
 
-    for (size_t i = 0; i < dialogsSize; ++i)
+    // the style map and the logger are not thread-safe,
+    // so the styles are looked up before the workers start
+    size_t i;
+    char buf[128];
+    for (i = 0; i < dialogsSize; ++i)
     {
-        subfx_ass_dialog *dialog(
-                    reinterpret_cast<subfx_ass_dialog *>
-                    (fdsa->ptrVector.at(parser->dialogs, i)));
-
+        subfx_ass_dialog *dialog = fdsa->ptrVector.at(parser->dialogs, i);
         if (!dialog)
         {
             subfx_pError(errMsg,
@@ -901,754 +815,184 @@ subfx_exitstate subfx_assParser_parseDialogs(AssParser *parser,
             return subfx_failed;
         }
 
-        dialog->i = static_cast<uint32_t>(i);
+        dialog->i = (uint32_t)i;
         dialog->duration = dialog->end_time - dialog->start_time;
         dialog->mid_time = dialog->start_time + (dialog->duration >> 1);
-        dialog->styleref = reinterpret_cast
-                <subfx_ass_style *>
-                (fdsa->ptrMap.at(parser->styles, dialog->style));
+        dialog->styleref = fdsa->ptrMap.at(parser->styles, dialog->style);
         if (!dialog->styleref)
         {
-            std::string out("Waring: dialog " + std::to_string(dialog->i));
-            out += " fallback to default style.\n";
-            subfx_logger_writeErr(parser->logger, out.c_str());
-            dialog->styleref = reinterpret_cast<subfx_ass_style *>
-                    (calloc(1, sizeof(subfx_ass_style)));
-
-            if (!dialog->styleref)
-            {
-                subfx_pError(errMsg,
-                             "AssParser::parseDialogs: "
-                             "Fail to add default style.");
-                return subfx_failed;
-            }
+            snprintf(buf, sizeof(buf),
+                     "Warning: dialog %u fallback to default style.\n",
+                     dialog->i);
+            subfx_logger_writeErr(parser->logger, buf);
+            dialog->styleref = &parser->defaultStyle;
         }
+    }
 
-        dialog->text_stripped = regex_replace(
-            &dialog->text,
-            boost::regex("\\{[^\\{\\}]+\\}"),
-            ""
-        );
-
-        auto textsize(textSize(dialog->text_stripped, dialog->styleref));
-
-        dialog->width = textsize->width;
-        dialog->height = textsize->height;
-        dialog->ascent = textsize->ascent;
-        dialog->descent = textsize->descent;
-        dialog->internal_leading = textsize->internal_leading;
-        dialog->external_leading = textsize->external_leading;
-
-        // Horizontal position
-        if (((dialog->styleref->alignment - 1) % 3) == 0)
-        {
-            dialog->left = (dialog->margin_l != 0. ?
-                        dialog->margin_l :
-                        dialog->styleref->margin_l);
-            dialog->center = dialog->left + (dialog->width / 2.);
-            dialog->right = dialog->left + dialog->width;
-            dialog->x = dialog->left;
-        }
-        else if (((dialog->styleref->alignment - 2) % 3) == 0)
-        {
-            dialog->left = static_cast<double>(metaData->play_res_x >> 1) -
-                    (dialog->width / 2.);
-            dialog->center = dialog->left + (dialog->width / 2.);
-            dialog->right = dialog->left + dialog->width;
-            dialog->x = dialog->center;
-        }
-        else
-        {
-            dialog->left = metaData->play_res_x - (dialog->margin_r != 0. ?
-                        dialog->margin_r :
-                        dialog->styleref->margin_r) - dialog->width;
-            dialog->center = dialog->left + (dialog->width / 2.);
-            dialog->right = dialog->left + dialog->width;
-            dialog->x = dialog->right;
-        }
+    if (!threads)
+    {
+        threads = Thread_hardwareConcurrency();
+    }
 
-        // Vertical position
-        if (dialog->styleref->alignment > 6)
-        {
-            dialog->top = (dialog->margin_v != 0. ?
-                        dialog->margin_v :
-                        dialog->styleref->margin_v);
-            dialog->middle = dialog->top + (dialog->height / 2.);
-            dialog->bottom = dialog->top + dialog->height;
-            dialog->y = dialog->top;
-        }
-        else if (dialog->styleref->alignment > 3)
-        {
-            dialog->top = static_cast<double>(metaData->play_res_y >> 1) -
-                    (dialog->height / 2.);
-            dialog->middle = dialog->top + (dialog->height / 2.);
-            dialog->bottom = dialog->top + dialog->height;
-            dialog->y = dialog->middle;
-        }
-        else
-        {
-            dialog->top = metaData->play_res_y - (dialog->margin_v != 0. ?
-                        dialog->margin_v :
-                        dialog->styleref->margin_v) - dialog->height;
-            dialog->middle = dialog->top + (dialog->height / 2.);
-            dialog->bottom = dialog->top + dialog->height;
-            dialog->y = dialog->bottom;
-        }
+    if (threads > dialogsSize)
+    {
+        threads = (uint32_t)dialogsSize;
+    }
 
-        std::string tmpString(" ");
-        textsize = textSize(tmpString, dialog->styleref);
+    AssExtendQueue queue;
+    if (AssExtendQueue_init(&queue, parser->dialogs))
+    {
+        subfx_pError(errMsg,
+                     "AssParser::parseDialogs: Fail to create the queue.");
+        return subfx_failed;
+    }
 
-        space_width = textsize->width;
-        textsize = nullptr;
+    AssExtendWorker *workers = calloc(threads, sizeof(AssExtendWorker));
+    if (!workers)
+    {
+        AssExtendQueue_fin(&queue);
+        subfx_pError(errMsg,
+                     "AssParser::parseDialogs: Fail to allocate memory.");
+        return subfx_failed;
+    }
 
-        // Add dialog text chunks
-        dialog->textChunked.reserve(50);
-        tmpString = dialog->text;
-        boost::u32regex u32reg(boost::make_u32regex("\\{([^\\{\\}]+)\\}([^\\{]*)"));
-        boost::smatch match;
-        while (boost::u32regex_search(tmpString, match, u32reg))
+    uint32_t index;
+    for (index = 0; index < threads; ++index)
+    {
+        if (AssExtendWorker_init(&workers[index], &parser->meta, &queue))
         {
-            std::shared_ptr<AssTextChunked>
-                    textChunked(std::make_shared<AssTextChunked>());
-
-            if (match.prefix() != "")
+            uint32_t j;
+            for (j = 0; j < index; ++j)
             {
-                textChunked->tags = "";
-                textChunked->text = match.prefix();
-                tmpString = match.str() + match.suffix();
-                dialog->textChunked.push_back(textChunked);
-                continue;
+                AssExtendWorker_fin(&workers[j]);
             }
 
-            textChunked->tags = match[1];
-            textChunked->text = match[2];
-            dialog->textChunked.push_back(textChunked);
-            tmpString = match.suffix();
+            free(workers);
+            AssExtendQueue_fin(&queue);
+            subfx_pError(errMsg,
+                         "AssParser::parseDialogs: Fail to create workers.");
+            return subfx_failed;
         }
+    }
 
-        // Add dialog sylables
-        dialog->syls.reserve(50);
-        uint64_t lastTime(0);
-        u32reg = boost::make_u32regex("\\\\[kK][of]?(\\d+)");
-        boost::u32regex u32regs(boost::make_u32regex("(\\s*)(\\S*)(\\s*)"));
-        for (size_t index = 0; index < dialog->textChunked.size(); ++index)
-        {
-            if (boost::u32regex_search(dialog->textChunked.at(index)->tags,
-                                       match, u32reg))
-            {
-                std::shared_ptr<AssSyl> syl(std::make_shared<AssSyl>());
-                uint64_t kdur(0);
-                tmpString = match[1];
-                try
-                {
-                    kdur = lexical_cast<uint64_t>(tmpString);
-                }
-                catch (...)
-                {
-                    dialog->syls.clear();
-                    throw std::invalid_argument("parseDialogs: Error when "
-                                                "getting syl's duration.");
-                }
-
-                syl->i = static_cast<uint32_t>(index);
-                syl->start_time = lastTime;
-                syl->mid_time = lastTime + kdur * 5; // kdur * 10 / 2
-                syl->duration = kdur * 10;
-                syl->end_time = lastTime + syl->duration;
-                syl->tags = match.prefix() + match.suffix();
-
-                if (boost::u32regex_search(
-                        dialog->textChunked.at(index)->text,
-                        match,
-                        u32regs)
-                )
-                {
-                    syl->text = match[2];
-
-                    tmpString = match[1];
-                    syl->prespace =
-                            PROJ_NAMESPACE::Utils::Utf8::stringLen(tmpString);
-
-                    tmpString = match[3];
-                    syl->postspace =
-                            PROJ_NAMESPACE::Utils::Utf8::stringLen(tmpString);
-                }
-                else
-                {
-                    syl->prespace = 0;
-                    syl->postspace = 0;
-                    syl->text = dialog->textChunked.at(index)->text;
-                }
-
-                textsize = textSize(syl->text, dialog->styleref);
-
-                syl->width = textsize->width;
-                syl->height = textsize->height;
-                syl->ascent = textsize->ascent;
-                syl->descent = textsize->descent;
-                syl->external_leading = textsize->external_leading;
-                syl->internal_leading = textsize->internal_leading;
-
-                textsize = nullptr;
-                lastTime = syl->end_time;
-                dialog->syls.push_back(syl);
-            }
-            else
-            {
-                dialog->syls.clear();
-                break;
-            }
-        } //end for index
-
-        // Calculate sylable positions with all sylables data already available
-        if (dialog->syls.size() > 0)
-        {
-            if (dialog->syls.at(0)->width != 0.)
-            {
-                if (dialog->styleref->alignment > 6 ||
-                    dialog->styleref->alignment < 4)
-                {
-                    double cur_x(dialog->left);
-                    for (size_t index = 0; index < dialog->syls.size(); ++index)
-                    {
-                        std::shared_ptr<AssSyl> syl(dialog->syls.at(index));
-
-                        // Horizontal position
-                        cur_x += (syl->prespace * space_width);
-                        syl->left = cur_x;
-                        syl->center = syl->left + (syl->width / 2.);
-                        syl->right = syl->left + syl->width;
-
-                        if (((dialog->styleref->alignment - 1) % 3) == 0)
-                        {
-                            syl->x = syl->left;
-                        }
-                        else
-                        {
-                            if (((dialog->styleref->alignment - 2) % 3) == 0)
-                            {
-                                syl->x = syl->center;
-                            }
-                            else
-                            {
-                                syl->x = syl->right;
-                            }
-                        }
-
-                        cur_x += (syl->width + (syl->postspace * space_width));
-
-                        // Vertical position
-                        syl->top = dialog->top;
-                        syl->middle = dialog->middle;
-                        syl->bottom = syl->bottom;
-                        syl->y = dialog->y;
-                    } //end for index
-                }
-                else
-                {
-                    double max_width(0.), sum_height(0.);
-                    for (size_t index = 0; index < dialog->syls.size(); ++index)
-                    {
-                        std::shared_ptr<AssSyl> syl(dialog->syls.at(index));
-                        max_width = std::max(max_width, syl->width);
-                        sum_height += syl->height;
-                    } //end for index
-
-                    double cur_y(static_cast<double>(metaData->play_res_y >> 1) -
-                                 (sum_height / 2.));
-                    double x_fix(0.);
-                    for (size_t index = 0; index < dialog->syls.size(); ++index)
-                    {
-                        std::shared_ptr<AssSyl> syl(dialog->syls.at(index));
-                        x_fix = ((max_width - syl->width) / 2.);
-                        if (dialog->styleref->alignment == 4)
-                        {
-                            syl->left = dialog->left + x_fix;
-                            syl->center = syl->left + (syl->width / 2.);
-                            syl->right = syl->left + syl->width;
-                            syl->x = syl->left;
-                        }
-                        else if (dialog->styleref->alignment == 5)
-                        {
-                            syl->left = static_cast<double>(
-                                        metaData->play_res_x >> 1) -
-                                    (syl->width / 2.);
-                            syl->center = syl->left + (syl->width / 2.);
-                            syl->right = syl->left + syl->width;
-                            syl->x = syl->center;
-                        }
-                        else
-                        {
-                            syl->left = dialog->right - syl->width - x_fix;
-                            syl->center = syl->left + (syl->width / 2.);
-                            syl->right = syl->left + syl->width;
-                            syl->x = syl->right;
-                        } //end if
-
-                        // Vertical position
-                        syl->top = cur_y;
-                        syl->middle = syl->top + (syl->height / 2.);
-                        syl->bottom = syl->top + syl->height;
-                        syl->y = syl->middle;
-                        cur_y += syl->height;
-                    } //end for index
-                }
-                // end if (dialog->styleref->alignment > 6 ||
-                //         dialog->styleref->alignment < 4)
-            } // end if (dialog->syls.at(0)->width != 0.f)
-        } // end if (dialog->syls.size() > 0)
-
-        // Add dialog words
-        u32reg = boost::make_u32regex("(\\s*)(\\S+)(\\s*)");
-        dialog->words.reserve(50);
-        tmpString = dialog->text_stripped;
-        uint32_t wordIndex(0);
-        bool result(false);
-        while (true)
+    // the calling thread is worker 0, if a thread can not be started
+    // the others just take more dialogs from the queue
+    uint32_t started = 1;
+    for (index = 1; index < threads; ++index)
+    {
+        if (Thread_create(&workers[index].thread,
+                          AssExtendWorker_run,
+                          &workers[index]))
         {
-#if (defined _MSC_VER) || (defined __APPLE__)
-            try
-            {
-                result = boost::u32regex_search(tmpString, match, u32reg);
-            }
-            catch (std::out_of_range &)
-            {
-                break;
-            }
-#else
-            result = boost::u32regex_search(tmpString, match, u32reg);
-#endif
-            if (!result)
-            {
-                break;
-            }
-
-            std::shared_ptr<AssWord> word(std::make_shared<AssWord>());
-
-            word->text = match[2];
-            textsize = textSize(word->text, dialog->styleref);
-
-            tmpString = match[1];
-            word->prespace =
-                    PROJ_NAMESPACE::Utils::Utf8::stringLen(tmpString);
-
-            tmpString = match[3];
-            word->postspace =
-                    PROJ_NAMESPACE::Utils::Utf8::stringLen(tmpString);
-
-            word->i = wordIndex;
-            word->start_time = dialog->start_time;
-            word->mid_time = dialog->mid_time;
-            word->end_time = dialog->end_time;
-            word->duration = dialog->duration;
+            break;
+        }
 
-            word->width = textsize->width;
-            word->height = textsize->height;
-            word->ascent = textsize->ascent;
-            word->descent = textsize->descent;
-            word->internal_leading = textsize->internal_leading;
-            word->external_leading = textsize->external_leading;
+        ++started;
+    }
 
-            textsize = nullptr;
-            dialog->words.push_back(word);
-            tmpString = match.suffix();
-            ++wordIndex;
-        } //end while(true)
+    AssExtendWorker_run(&workers[0]);
+    for (index = 1; index < started; ++index)
+    {
+        Thread_join(&workers[index].thread);
+    }
 
-        // Calculate word positions with all words data already available
-        if (dialog->words.size() > 0)
-        {
-            if (dialog->words.at(0)->width != 0.)
-            {
-                if (dialog->styleref->alignment > 6 ||
-                    dialog->styleref->alignment < 4)
-                {
-                    double cur_x(dialog->left);
-                    for (size_t index = 0; index < dialog->words.size(); ++index)
-                    {
-                        std::shared_ptr<AssWord> word(dialog->words.at(index));
-
-                        // Horizontal position
-                        cur_x += (word->prespace * space_width);
-                        word->left = cur_x;
-                        word->center = word->left + (word->width / 2.);
-                        word->right = word->left + word->width;
-
-                        if (((dialog->styleref->alignment - 1) % 3) == 0)
-                        {
-                            word->x = word->left;
-                        }
-                        else
-                        {
-                            if (((dialog->styleref->alignment - 2) % 3) == 0)
-                            {
-                                word->x = word->center;
-                            }
-                            else
-                            {
-                                word->x = word->right;
-                            }
-                        }
-
-                        cur_x += (word->width + (word->postspace * space_width));
-
-                        // Vertical position
-                        word->top = dialog->top;
-                        word->middle = dialog->middle;
-                        word->bottom = dialog->bottom;
-                        word->y = dialog->y;
-                    } //end for index
-                }
-                else
-                {
-                    double max_width(0.), sum_height(0.);
-                    for (size_t index = 0; index < dialog->words.size(); ++index)
-                    {
-                        std::shared_ptr<AssWord> word(dialog->words.at(index));
-                        max_width = std::max(max_width, word->width);
-                        sum_height += word->height;
-                    } //end for index;
-
-                    double cur_y(static_cast<double>(metaData->play_res_y >> 1) -
-                                 (sum_height / 2.));
-                    double x_fix(0.);
-                    for (size_t index = 0; index < dialog->words.size(); ++index)
-                    {
-                        std::shared_ptr<AssWord> word(dialog->words.at(index));
-
-                        // Horizontal position
-                        x_fix = ((max_width - word->width) / 2.);
-                        if (dialog->styleref->alignment == 4)
-                        {
-                            word->left = dialog->left + x_fix;
-                            word->center = word->left + (word->width / 2.);
-                            word->right = word->left + word->width;
-                            word->x = word->left;
-                        }
-                        else if (dialog->styleref->alignment == 5)
-                        {
-                            word->left = static_cast<double>(
-                                        metaData->play_res_x >> 1) -
-                                    (word->width / 2.);
-                            word->center = word->left + (word->width / 2.);
-                            word->right = word->left + word->width;
-                            word->x = word->center;
-                        }
-                        else // dialog->styleref->alignment == 6
-                        {
-                            word->left = dialog->right - word->width - x_fix;
-                            word->center = word->left + (word->width / 2.);
-                            word->right = word->left + word->width;
-                            word->x = word->right;
-                        }
-
-                        // Vertical position
-                        word->top = cur_y;
-                        word->middle = word->top + (word->height / 2.);
-                        word->bottom = word->top + word->height;
-                        cur_y += word->height;
-                    } // end for index
-                }
-                // end if (dialog->styleref->alignment > 6 ||
-                //         dialog->styleref->alignment < 4)
-            } //end if (dialog->words.at(0)->width != 0.f)
-        } // end if (dialog->words.size() > 0)
-
-        // Add dialog characters
-        dialog->chars.reserve(50);
-        std::vector<std::string> charText(
-                    PROJ_NAMESPACE::Utils::Utf8::stringSplit(
-                        dialog->text_stripped));
-        for (size_t cIndex = 0; cIndex < charText.size(); ++cIndex)
-        {
-            std::shared_ptr<AssChar> assChar(std::make_shared<AssChar>());
-            assChar->i = static_cast<uint32_t>(cIndex);
-            assChar->start_time = dialog->start_time;
-            assChar->mid_time = dialog->mid_time;
-            assChar->end_time = dialog->end_time;
-            assChar->duration = dialog->duration;
-            assChar->text = charText.at(cIndex);
-
-            uint32_t charIndex(0);
-            for (size_t index = 0; index < dialog->syls.size(); ++index)
-            {
-                std::shared_ptr<AssSyl> syl(dialog->syls.at(index));
-                uint32_t maxLoop(syl->prespace +
-                                 PROJ_NAMESPACE::Utils::Utf8::stringLen(
-                                     syl->text) +
-                                 syl->postspace);
-                for (size_t sIndex = 0; sIndex < maxLoop; ++sIndex)
-                {
-                    if (charIndex == assChar->i)
-                    {
-                        assChar->syl_i = static_cast<int>(syl->i);
-                        assChar->start_time = syl->start_time;
-                        assChar->mid_time = syl->mid_time;
-                        assChar->end_time = syl->end_time;
-                        assChar->duration = syl->duration;
-                        goto syl_reference_found;
-                    }
-                    ++charIndex;
-                } // end for sIndex
-            } // end for index
-
-syl_reference_found:
-            charIndex = 0;
-            for (size_t index = 0; index < dialog->words.size(); ++index)
-            {
-                std::shared_ptr<AssWord> word(dialog->words.at(index));
-                uint32_t maxLoop(word->prespace +
-                                 PROJ_NAMESPACE::Utils::Utf8::stringLen(
-                                     word->text) +
-                                 word->postspace);
-                for (size_t wIndex = 0; wIndex < maxLoop; ++wIndex)
-                {
-                    if (charIndex == assChar->i)
-                    {
-                        assChar->word_i = static_cast<int>(word->i);
-                        goto word_reference_found;
-                    }
-                    ++charIndex;
-                } // end for wIndex;
-            } // end for index
-
-word_reference_found:
-            textsize = textSize(assChar->text, dialog->styleref);
-
-            assChar->width = textsize->width;
-            assChar->height = textsize->height;
-            assChar->ascent = textsize->ascent;
-            assChar->descent = textsize->descent;
-            assChar->internal_leading = textsize->internal_leading;
-            assChar->external_leading = textsize->external_leading;
-
-            textsize = nullptr;
-            dialog->chars.push_back(assChar);
-        } //end for cIndex
-
-        // Calculate character positions with all characters data already available
-        if (dialog->chars.size() > 0)
-        {
-            if (dialog->chars.at(0)->width != 0.)
-            {
-                if (dialog->styleref->alignment > 6 ||
-                    dialog->styleref->alignment < 4)
-                {
-                    double cur_x(dialog->left);
-                    for (size_t index = 0; index < dialog->chars.size(); ++index)
-                    {
-                        std::shared_ptr<AssChar> assChar(dialog->chars.at(index));
-
-                        // Horizontal position
-                        assChar->left = cur_x;
-                        assChar->center = assChar->left + (assChar->width / 2.);
-                        assChar->right = assChar->left + assChar->width;
-
-                        if (((dialog->styleref->alignment - 1) % 3) == 0)
-                        {
-                            assChar->x = assChar->left;
-                        }
-                        else
-                        {
-                            if (((dialog->styleref->alignment - 2) % 3) == 0)
-                            {
-                                assChar->x = assChar->center;
-                            }
-                            else
-                            {
-                                assChar->x = assChar->right;
-                            }
-                        }
-
-                        cur_x += assChar->width;
-
-                        // Vertical position
-                        assChar->top = dialog->top;
-                        assChar->middle = dialog->middle;
-                        assChar->bottom = dialog->bottom;
-                        assChar->y = dialog->y;
-                    } // end for index
-                }
-                else
-                {
-                    double max_width(0.), sum_height(0.);
-                    for (size_t index = 0; index < dialog->chars.size(); ++index)
-                    {
-                        std::shared_ptr<AssChar> assChar(dialog->chars.at(index));
-                        max_width = std::max(max_width, assChar->width);
-                        sum_height += assChar->height;
-                    } // end for index
-
-                    double cur_y(static_cast<double>(metaData->play_res_y >> 1) -
-                                 (sum_height / 2.));
-                    double x_fix(0.);
-                    for (size_t index = 0; index < dialog->chars.size(); ++index)
-                    {
-                        std::shared_ptr<AssChar> assChar(dialog->chars.at(index));
-
-                        // Horizontal position
-                        x_fix = ((max_width - assChar->width) / 2);
-                        if (dialog->styleref->alignment == 4)
-                        {
-                            assChar->left = dialog->left + x_fix;
-                            assChar->center = assChar->left + (assChar->width / 2.);
-                            assChar->right = assChar->left + assChar->width;
-                            assChar->x = assChar->left;
-                        }
-                        else if (dialog->styleref->alignment == 5)
-                        {
-                            assChar->left = static_cast<double>(
-                                        metaData->play_res_x >> 1) -
-                                    (assChar->width / 2.);
-                            assChar->center = assChar->left + (assChar->width / 2.);
-                            assChar->right = assChar->left + assChar->width;
-                            assChar->x = assChar->center;
-                        }
-                        else // dialog->styleref->alignment == 6
-                        {
-                            assChar->left = dialog->right - assChar->width - x_fix;
-                            assChar->center = assChar->left + (assChar->width / 2.);
-                            assChar->right = assChar->left + assChar->width;
-                            assChar->y = assChar->right;
-                        }
-
-                        // Vertical position
-                        assChar->top = cur_y;
-                        assChar->middle = assChar->top + (assChar->height /2.);
-                        assChar->bottom = assChar->top + assChar->height;
-                        assChar->y = assChar->middle;
-                        cur_y += assChar->height;
-                    } // end for index
-                }
-                // end if (dialog->styleref->alignment > 6 ||
-                //         dialog->styleref->alignment < 4)
-            } //end if (dialog->chars.at(0)->width != 0)
-        } //end if (dialog->chars.size() > 0)
-    } //end for i
+    AssExtendQueue_fin(&queue);
 
-    // sort dialogs
-    sort(dialogData.begin(), dialogData.end(),
-        [](const std::shared_ptr<AssDialog> &a, const std::shared_ptr<AssDialog> &b)
+    // report the first dialog that fails, whatever the scheduling is
+    AssExtendWorker *failed = NULL;
+    for (index = 0; index < started; ++index)
+    {
+        if (workers[index].failedAt != SIZE_MAX &&
+            (!failed || workers[index].failedAt < failed->failedAt))
         {
-            return (a->start_time < b->start_time);
+            failed = &workers[index];
         }
-    );
-
-    for (size_t i = 0; i < dialogData.size(); ++i)
-    {
-        std::shared_ptr<AssDialog> dialog(dialogData.at(i));
-        dialog->leadin = (i == 0 ?
-                          1000.1 :
-                          (dialog->start_time - dialogData.at(i - 1)->end_time));
-        dialog->leadout = (i == (dialogData.size() - 1) ?
-                           1000.1 :
-                           (dialogData.at(i + 1)->start_time - dialog->end_time));
     }
 
-    // here maybe have a better solution
-    for (size_t i = 0; i < dialogData.size(); ++i)
+    if (failed)
     {
-        auto dialog(dialogData.at(i));
-        if (dialog->syls.size())
+        subfx_pError(errMsg, failed->errMsg);
+        for (i = 0; i < dialogsSize; ++i)
         {
-            sylReady = true;
-        }
+            subfx_ass_dialog *dialog = fdsa->ptrVector.at(parser->dialogs, i);
+            destoryDialogVectors(dialog);
 
-        if (dialog->words.size())
-        {
-            wordReady = true;
+            // it is in the arena of a worker, which is freed unmerged
+            dialog->text_stripped = NULL;
+            dialog->text_stripped_len = 0;
         }
-
-        if (dialog->chars.size())
+    }
+    else
+    {
+        for (index = 0; index < threads; ++index)
         {
-            charReady = true;
+            Arena_merge(&parser->arena, &workers[index].arena);
         }
     }
 
-    dialogParsed = true;
-    return subfx_success;
-}
-
-/*
-
-#include <stdexcept>
-#include <iostream>
-#include <algorithm>
-#include <stdexcept>
-
-#include <cstdio>
-#include <cinttypes>
-
-#ifndef SCNd8
-#define SCNd8 "hhd"
-#endif
-#ifndef SCNu8
-#define SCNu8 "hhu"
-#endif
-
-using namespace PROJ_NAMESPACE::Yutils;
-
-void AssParser::extendDialogs() THROW
-{
-    if (dialogParsed)
+    for (index = 0; index < threads; ++index)
     {
-        return;
+        parser->fontCacheHits += workers[index].fonts.hits;
+        parser->fontCacheMisses += workers[index].fonts.misses;
+        AssExtendWorker_fin(&workers[index]);
     }
 
-    parseDialogs();
-}
-
-// private member functions
-
-void AssParser::parseDialogs() THROW
-{
-
-}
-
-std::shared_ptr<AssParser::TEXT_SIZE>
-AssParser::textSize(std::string &text,
-                    std::shared_ptr<AssStyle> &style)
-{
-    auto font(FontHandle::create(style->fontname,
-                                 style->bold,
-                                 style->italic,
-                                 style->underline,
-                                 style->strikeout,
-                                 style->fontsize,
-                                 style->scale_x / 100.,
-                                 style->scale_y / 100.,
-                                 style->spaceing));
-    if (font == nullptr)
+    free(workers);
+    if (failed)
     {
-        throw std::runtime_error("textSize: Fail to create FontHandle");
+        return subfx_failed;
     }
 
-    auto tmpMap(font->text_extents(text));
-    if (tmpMap.empty())
+    // sort dialogs
+    if (sortDialogs(parser, dialogsSize))
     {
-        throw std::runtime_error("textSize: Fail to get text properties");
+        subfx_pError(errMsg,
+                     "AssParser::parseDialogs: Fail to sort dialogs.");
+        for (i = 0; i < dialogsSize; ++i)
+        {
+            destoryDialogVectors(fdsa->ptrVector.at(parser->dialogs, i));
+        }
+
+        return subfx_failed;
     }
 
-    TEXT_SIZE *ret(new (std::nothrow) TEXT_SIZE);
-    if (!ret)
+    subfx_ass_dialog *dialog, *prev, *next;
+    size_t size;
+    for (i = 0; i < dialogsSize; ++i)
     {
-        throw std::runtime_error("textSize: Fail to allocate memory.");
-    }
+        dialog = fdsa->ptrVector.at(parser->dialogs, i);
+        prev = i ? fdsa->ptrVector.at(parser->dialogs, i - 1) : NULL;
+        next = (i == (dialogsSize - 1)) ?
+                    NULL : fdsa->ptrVector.at(parser->dialogs, i + 1);
+
+        dialog->leadin = (!prev ?
+                          1000.1 :
+                          ((double)dialog->start_time -
+                           (double)prev->end_time));
+        dialog->leadout = (!next ?
+                           1000.1 :
+                           ((double)next->start_time -
+                            (double)dialog->end_time));
 
-    ret->width = tmpMap["width"];
-    ret->height = tmpMap["height"];
+        if (fdsa->ptrVector.size(dialog->syls, &size) == fdsa_success &&
+            size)
+        {
+            parser->sylReady = true;
+        }
 
-    tmpMap = font->metrics();
-    if (tmpMap.empty())
-    {
-        delete ret;
-        throw std::runtime_error("textSize: Fail to get font metrics");
+        if (fdsa->ptrVector.size(dialog->words, &size) == fdsa_success &&
+            size)
+        {
+            parser->wordReady = true;
+        }
+
+        if (fdsa->ptrVector.size(dialog->chars, &size) == fdsa_success &&
+            size)
+        {
+            parser->charReady = true;
+        }
     }
 
-    ret->ascent = tmpMap["ascent"];
-    ret->descent = tmpMap["descent"];
-    ret->internal_leading = tmpMap["internal_leading"];
-    ret->external_leading = tmpMap["external_leading"];
-    return std::shared_ptr<AssParser::TEXT_SIZE>(ret);
+    parser->dialogParsed = true;
+    return subfx_success;
 }
-*/
@@ -20,7 +20,9 @@
 #pragma once
 
 #include "include/internal/assparser.h"
+#include "arena.h"
 #include "logger.h"
+#include "mappedfile.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -55,17 +57,34 @@ typedef struct AssParser
 
     subfx_logger *logger;
 
+    // the whole input file, lines are parsed in place
+    MappedFile file;
+
+    // dialogs and their strings live here,
+    // see subfx_assParser_destory()
+    Arena arena;
+
     PARSER_SECTION section;
 
+    // for dialogs whose style is not in styles
+    subfx_ass_style defaultStyle;
+
     bool dialogParsed;
 
-} AssParser;
+    bool sylReady;
 
-subfx_exitstate subfx_assParser_init(subfx_assParser_api *);
+    bool wordReady;
+
+    bool charReady;
 
-void subfx_assParser_fin();
+    // font handle cache of extendDialogs(), summed over all workers
+    size_t fontCacheHits;
 
-uint8_t subfx_assParser_parseLineRegexInit();
+    size_t fontCacheMisses;
+
+} AssParser;
+
+subfx_exitstate subfx_assParser_init(subfx_assParser_api *);
 
 subfx_assParser *subfx_assParser_create(const char *fileName,
                                         const char *warningOut,
@@ -76,17 +95,27 @@ subfx_exitstate subfx_assParser_destory(subfx_assParser *parser);
 subfx_exitstate subfx_assParser_extendDialogs(subfx_assParser *parser,
                                               char *errMsg);
 
+subfx_exitstate subfx_assParser_extendDialogs2(subfx_assParser *parser,
+                                               uint32_t threads,
+                                               char *errMsg);
+
+subfx_exitstate subfx_assParser_fontCacheStats(subfx_assParser *parser,
+                                               size_t *hits,
+                                               size_t *misses);
+
 subfx_exitstate subfx_assParser_dialogIsExtended(subfx_assParser *parser,
                                                  bool *out);
 
-void subfx_assParser_checkBom(AssParser *, uint8_t *, size_t *);
+void subfx_assParser_checkBom(AssParser *, size_t *);
 
 uint8_t subfx_assParser_parseLine(AssParser *,
                                   const char *,
+                                  size_t,
                                   uint8_t *,
                                   char *);
 
 subfx_exitstate subfx_assParser_parseDialogs(AssParser *,
+                                             uint32_t,
                                              char *);
 
 #ifdef __cplusplus
@@ -19,6 +19,10 @@
 
 #pragma once
 
+// The patterns used by subfx_assParser_parseLine before AssTokenizer,
+// they are kept for the comparison in SubFX/bench/asstokenizer.
+// The patterns for extending dialogs are at the end of this file.
+
 #define REGEX_COUNT 8
 
 #define REGEX_ASS_SECION_MARK 0
@@ -64,4 +68,28 @@
     "(\\d+\\.?\\d*),(\\d+\\.?\\d*)," \
     "(|.*),(.*)$"
 
+// for extending dialogs, every worker compiles its own copy
+#define REGEX_EXTEND_COUNT 5
+
+// {tags}
+#define REGEX_EXTEND_TAGS 0
+#define REGEX_STR_EXTEND_TAGS \
+    "\\{[^\\{\\}]+\\}"
+
+// {tags}text
+#define REGEX_EXTEND_TEXT_CHUNK 1
+#define REGEX_STR_EXTEND_TEXT_CHUNK \
+    "\\{([^\\{\\}]+)\\}([^\\{]*)"
+
+// \k, \K, \kf, \ko
+#define REGEX_EXTEND_K_TAG 2
+#define REGEX_STR_EXTEND_K_TAG \
+    "\\\\[kK][of]?(\\d+)"
+
+#define REGEX_EXTEND_SYL_TEXT 3
+#define REGEX_STR_EXTEND_SYL_TEXT \
+    "(\\s*)(\\S*)(\\s*)"
 
+#define REGEX_EXTEND_WORD 4
+#define REGEX_STR_EXTEND_WORD \
+    "(\\s*)(\\S+)(\\s*)"
@@ -0,0 +1,354 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "asstokenizer.h"
+
+#define IS_DIGIT(c) ((unsigned)((c) - '0') < 10u)
+
+// every power of ten up to 1e22 is exact in double
+static const double pow10Table[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// "Key:" followed by optional spaces
+static bool matchKey(const char *line,
+                     size_t lineLen,
+                     const char *key,
+                     size_t keyLen,
+                     AssField *value)
+{
+    if (lineLen < keyLen || memcmp(line, key, keyLen))
+    {
+        return false;
+    }
+
+    size_t pos = keyLen;
+    while (pos < lineLen && line[pos] == ' ')
+    {
+        ++pos;
+    }
+
+    value->str = line + pos;
+    value->len = lineLen - pos;
+    return true;
+}
+
+#define MATCH_KEY(literal) \
+    matchKey(line, lineLen, literal, sizeof(literal) - 1, value)
+
+ASS_LINE_TYPE AssTokenizer_classify(const char *line,
+                                    size_t lineLen,
+                                    AssField *value)
+{
+    if (!line || !lineLen || !value)
+    {
+        return AssLine_Unknown;
+    }
+
+    // dispatch on the first byte, then compare the whole key once
+    switch (line[0])
+    {
+    case '[':
+    {
+        if (lineLen < 2 || line[lineLen - 1] != ']')
+        {
+            return AssLine_Unknown;
+        }
+
+        value->str = line + 1;
+        value->len = lineLen - 2;
+        return AssLine_Section;
+    }
+    case 'D':
+    {
+        return MATCH_KEY("Dialogue:") ? AssLine_Dialogue : AssLine_Unknown;
+    }
+    case 'C':
+    {
+        return MATCH_KEY("Comment:") ? AssLine_Comment : AssLine_Unknown;
+    }
+    case 'S':
+    {
+        if (MATCH_KEY("Style:"))
+        {
+            return AssLine_Style;
+        }
+
+        return MATCH_KEY("ScaledBorderAndShadow:") ?
+                    AssLine_ScaledBorderAndShadow : AssLine_Unknown;
+    }
+    case 'P':
+    {
+        if (MATCH_KEY("PlayResX:"))
+        {
+            return AssLine_PlayResX;
+        }
+
+        return MATCH_KEY("PlayResY:") ? AssLine_PlayResY : AssLine_Unknown;
+    }
+    case 'W':
+    {
+        return MATCH_KEY("WrapStyle:") ? AssLine_WrapStyle : AssLine_Unknown;
+    }
+    case 'Y':
+    {
+        return MATCH_KEY("YCbCr Matrix:") ?
+                    AssLine_YCbCrMatrix : AssLine_Unknown;
+    }
+    default:
+    {
+        return AssLine_Unknown;
+    }
+    } // end switch
+}
+
+size_t AssTokenizer_split(const AssField *value,
+                          AssField *fields,
+                          size_t maxFields)
+{
+    if (!value || !fields || !maxFields)
+    {
+        return 0;
+    }
+
+    const char *begin = value->str;
+    const char *end = value->str + value->len;
+    const char *comma;
+    size_t count = 0;
+    while (count < (maxFields - 1))
+    {
+        comma = memchr(begin, ',', (size_t)(end - begin));
+        if (!comma)
+        {
+            break;
+        }
+
+        fields[count].str = begin;
+        fields[count].len = (size_t)(comma - begin);
+        ++count;
+        begin = comma + 1;
+    }
+
+    // the last one takes the rest of the line
+    fields[count].str = begin;
+    fields[count].len = (size_t)(end - begin);
+    return count + 1;
+}
+
+bool AssTokenizer_equals(const AssField *field, const char *str)
+{
+    if (!field || !str) return false;
+
+    size_t len = strlen(str);
+    return (field->len == len && !memcmp(field->str, str, len));
+}
+
+bool AssTokenizer_toInt(const AssField *field, int64_t *out)
+{
+    if (!field || !out || !field->len) return false;
+
+    const char *p = field->str;
+    const char *end = field->str + field->len;
+    bool negative = false;
+    if (*p == '-')
+    {
+        negative = true;
+        ++p;
+    }
+
+    // 18 digits never overflow int64_t
+    if (p == end || (end - p) > 18)
+    {
+        return false;
+    }
+
+    int64_t ret = 0;
+    for (; p < end; ++p)
+    {
+        if (!IS_DIGIT(*p))
+        {
+            return false;
+        }
+
+        ret = ret * 10 + (*p - '0');
+    }
+
+    *out = negative ? -ret : ret;
+    return true;
+}
+
+bool AssTokenizer_toDouble(const AssField *field, double *out)
+{
+    if (!field || !out || !field->len) return false;
+
+    const char *p = field->str;
+    const char *end = field->str + field->len;
+    bool negative = false;
+    if (*p == '-')
+    {
+        negative = true;
+        ++p;
+    }
+
+    if (p == end || !IS_DIGIT(*p))
+    {
+        return false;
+    }
+
+    uint64_t mantissa = 0;
+    size_t digits = 0;
+    size_t fraction = 0;
+    for (; p < end && IS_DIGIT(*p); ++p)
+    {
+        mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+        ++digits;
+    }
+
+    if (p < end)
+    {
+        if (*p != '.')
+        {
+            return false;
+        }
+
+        for (++p; p < end; ++p)
+        {
+            if (!IS_DIGIT(*p))
+            {
+                return false;
+            }
+
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            ++digits;
+            ++fraction;
+        }
+    }
+
+    // both operands are exact, so the division is correctly rounded
+    // and gives the same result as strtod()
+    if (digits <= 15 && fraction <= 22)
+    {
+        double ret = (double)mantissa / pow10Table[fraction];
+        *out = negative ? -ret : ret;
+        return true;
+    }
+
+    // the syntax is checked above, and the field is always followed by
+    // ',' or the line break, so strtod() stops at the end of the field
+    char *strtodEnd;
+    *out = strtod(field->str, &strtodEnd);
+    return (strtodEnd == end);
+}
+
+bool AssTokenizer_toMs(const AssField *field, uint64_t *out)
+{
+    if (!field || !out) return false;
+
+    const char *p = field->str;
+    const char *end = field->str + field->len;
+
+    // H:MM:SS.XX needs at least 10 bytes
+    if (field->len < 10 || field->len > 16)
+    {
+        return false;
+    }
+
+    uint64_t hr = 0;
+    for (; p < end && IS_DIGIT(*p); ++p)
+    {
+        hr = hr * 10 + (uint64_t)(*p - '0');
+    }
+
+    // the rest is exactly ":MM:SS.XX"
+    if (p == field->str || (end - p) != 9)
+    {
+        return false;
+    }
+
+    if (p[0] != ':' || !IS_DIGIT(p[1]) || !IS_DIGIT(p[2]) ||
+        p[3] != ':' || !IS_DIGIT(p[4]) || !IS_DIGIT(p[5]) ||
+        p[6] != '.' || !IS_DIGIT(p[7]) || !IS_DIGIT(p[8]))
+    {
+        return false;
+    }
+
+    uint64_t min = (uint64_t)((p[1] - '0') * 10 + (p[2] - '0'));
+    uint64_t sec = (uint64_t)((p[4] - '0') * 10 + (p[5] - '0'));
+    uint64_t centisec = (uint64_t)((p[7] - '0') * 10 + (p[8] - '0'));
+
+    *out = hr * 3600000 + min * 60000 + sec * 1000 + centisec * 10;
+    return true;
+}
+
+static int hexValue(char c)
+{
+    if (IS_DIGIT(c)) return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool AssTokenizer_toColorAlpha(const AssField *field, uint8_t *out)
+{
+    if (!field || !out) return false;
+    if (field->len != 10 || field->str[0] != '&' || field->str[1] != 'H')
+    {
+        return false;
+    }
+
+    // &HAABBGGRR
+    uint8_t tmp[4];
+    int high, low;
+    size_t index;
+    for (index = 0; index < 4; ++index)
+    {
+        high = hexValue(field->str[2 + (index << 1)]);
+        low = hexValue(field->str[3 + (index << 1)]);
+        if (high < 0 || low < 0)
+        {
+            return false;
+        }
+
+        tmp[index] = (uint8_t)((high << 4) | low);
+    }
+
+    out[0] = tmp[3]; // r
+    out[1] = tmp[2]; // g
+    out[2] = tmp[1]; // b
+    out[3] = tmp[0]; // a
+    return true;
+}
+
+void AssTokenizer_copy(const AssField *field, char *dst, size_t dstSize)
+{
+    if (!field || !dst || !dstSize) return;
+
+    size_t len = field->len;
+    if (len >= dstSize)
+    {
+        len = dstSize - 1;
+    }
+
+    memcpy(dst, field->str, len);
+    dst[len] = '\0';
+}
@@ -0,0 +1,95 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define ASS_STYLE_FIELDS 23
+#define ASS_EVENT_FIELDS 10
+
+typedef enum ASS_LINE_TYPE
+{
+    AssLine_Unknown,
+    AssLine_Section, // [XXX]
+    AssLine_WrapStyle,
+    AssLine_ScaledBorderAndShadow,
+    AssLine_PlayResX,
+    AssLine_PlayResY,
+    AssLine_YCbCrMatrix,
+    AssLine_Style,
+    AssLine_Dialogue,
+    AssLine_Comment
+} ASS_LINE_TYPE;
+
+/**
+ * A field inside a line, it is NOT '\0' terminated.
+ */
+typedef struct AssField
+{
+    const char *str;
+    size_t len;
+} AssField;
+
+/**
+ * Classifies a line by its leading bytes.
+ * @param value For key-value lines, it is the text after "Key: ".
+ *              For section marks, it is the text between the brackets.
+ */
+ASS_LINE_TYPE AssTokenizer_classify(const char *line,
+                                    size_t lineLen,
+                                    AssField *value);
+
+/**
+ * Splits value into at most maxFields comma-separated fields in place.
+ * The last field takes the rest of the line, commas included,
+ * which is what the "Text" field of events needs.
+ * @return how many fields are found.
+ */
+size_t AssTokenizer_split(const AssField *value,
+                          AssField *fields,
+                          size_t maxFields);
+
+bool AssTokenizer_equals(const AssField *field, const char *str);
+
+// -?\d+
+bool AssTokenizer_toInt(const AssField *field, int64_t *out);
+
+// -?\d+\.?\d*
+bool AssTokenizer_toDouble(const AssField *field, double *out);
+
+// H:MM:SS.XX
+bool AssTokenizer_toMs(const AssField *field, uint64_t *out);
+
+// &HAABBGGRR, output is {r, g, b, a}
+bool AssTokenizer_toColorAlpha(const AssField *field, uint8_t *out);
+
+// copy the field to a '\0' terminated buffer, truncate if it is too long
+void AssTokenizer_copy(const AssField *field, char *dst, size_t dstSize);
+
+#ifdef __cplusplus
+}
+#endif
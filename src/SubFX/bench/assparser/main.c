@@ -0,0 +1,160 @@
+/*
+ * This file is part of SubFX,
+ * Copyright (c) 2020-2021 fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Measures the memory and the time that the parser needs
+// for a synthetic karaoke script or an existing one.
+// usage: benchAssParser [number of dialogs] [path of the temporary file]
+//        benchAssParser script.ass
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SubFX.h"
+#include "SubFX/bench/bench.h"
+
+static int writeScript(const char *fileName, size_t dialogs)
+{
+    FILE *f = fopen(fileName, "wb");
+    if (!f) return 1;
+
+    fputs("[Script Info]\n"
+          "ScriptType: v4.00+\n"
+          "PlayResX: 1920\n"
+          "PlayResY: 1080\n"
+          "\n"
+          "[V4+ Styles]\n"
+          "Format: Name, Fontname, Fontsize, PrimaryColour, "
+          "SecondaryColour, OutlineColour, BackColour, Bold, Italic, "
+          "Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, "
+          "BorderStyle, Outline, Shadow, Alignment, MarginL, MarginR, "
+          "MarginV, Encoding\n"
+          "Style: Default,Arial,48,&H00FFFFFF,&H000000FF,&H00000000,"
+          "&H80000000,0,0,0,0,100,100,0,0,1,2,0,8,10,10,20,1\n"
+          "\n"
+          "[Events]\n"
+          "Format: Layer, Start, End, Style, Name, MarginL, MarginR, "
+          "MarginV, Effect, Text\n", f);
+
+    size_t i;
+    for (i = 0; i < dialogs; ++i)
+    {
+        fprintf(f,
+                "Dialogue: 0,0:%02zu:%02zu.00,0:%02zu:%02zu.50,Default,,"
+                "0,0,0,,{\\k20}Ka{\\k15}ra{\\k30}o{\\k25}ke "
+                "{\\k20}li{\\k20}ne %zu\n",
+                (i / 60) % 60, i % 60, (i / 60) % 60, i % 60, i);
+    }
+
+    return fclose(f) ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    // a number makes a synthetic script, anything else is an existing one
+    const char *arg = (argc > 1) ? argv[1] : "10000";
+    char *end = NULL;
+    size_t dialogs = (size_t)strtoull(arg, &end, 10);
+    int synthetic = (*end == '\0');
+    const char *fileName = synthetic ?
+                ((argc > 2) ? argv[2] : "benchAssParser.ass") : arg;
+    if (synthetic && !dialogs)
+    {
+        puts("usage: benchAssParser [number of dialogs | script.ass] [path]");
+        return 1;
+    }
+
+    if (synthetic && writeScript(fileName, dialogs))
+    {
+        puts("Fail to write the script.");
+        return 1;
+    }
+
+    SubFX api;
+    if (SubFX_init(&api) == subfx_failed)
+    {
+        puts("Failed in SubFX_init()");
+        if (synthetic) remove(fileName);
+        return 1;
+    }
+
+    char errMsg[1024];
+    size_t rssBefore = benchRss();
+    size_t peakBefore = benchPeakRss();
+    double start = benchNow();
+    subfx_assParser *parser = api.assParser.create(fileName, NULL, errMsg);
+    double elapsed = benchNow() - start;
+    size_t rssAfter = benchRss();
+    size_t peakAfter = benchPeakRss();
+    if (!parser)
+    {
+        puts(errMsg);
+        SubFX_fin(&api);
+        if (synthetic) remove(fileName);
+        return 1;
+    }
+
+    if (api.fdsa->ptrVector.size(parser->dialogs, &dialogs) == fdsa_failed ||
+        !dialogs)
+    {
+        puts("No dialog in the script.");
+        api.assParser.destory(parser);
+        SubFX_fin(&api);
+        if (synthetic) remove(fileName);
+        return 1;
+    }
+
+    // syls, words and chars are allocated here
+    start = benchNow();
+    int extended = (api.assParser.extendDialogs(parser, errMsg) ==
+                    subfx_success);
+    double extendElapsed = benchNow() - start;
+    size_t peakExtended = benchPeakRss();
+    if (!extended)
+    {
+        puts(errMsg);
+    }
+
+    printf("dialogs:             %zu\n", dialogs);
+    printf("sizeof(dialog):      %zu bytes\n", sizeof(subfx_ass_dialog));
+    printf("create:              %.3f ms\n", elapsed * 1000.);
+    printf("RSS before create:   %zu KiB\n", rssBefore >> 10);
+    printf("RSS after create:    %zu KiB\n", rssAfter >> 10);
+    printf("RSS per dialog:      %.1f bytes\n",
+           (rssAfter > rssBefore) ?
+               (double)(rssAfter - rssBefore) / (double)dialogs : 0.);
+    printf("peak before create:  %zu KiB\n", peakBefore >> 10);
+    printf("peak after create:   %zu KiB\n", peakAfter >> 10);
+    if (extended)
+    {
+        printf("extend:              %.3f ms\n", extendElapsed * 1000.);
+        printf("peak after extend:   %zu KiB\n", peakExtended >> 10);
+        printf("peak per dialog:     %.1f bytes\n",
+               (peakExtended > peakBefore) ?
+                   (double)(peakExtended - peakBefore) / (double)dialogs : 0.);
+    }
+
+    api.assParser.destory(parser);
+    SubFX_fin(&api);
+    if (synthetic) remove(fileName);
+    return extended ? 0 : 1;
+}
@@ -0,0 +1,370 @@
+/*
+ * This file is part of SubFX,
+ * Copyright (c) 2020-2021 fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Compares lines per second of the hand-written tokenizer with
+// the PCRE2 patterns that subfx_assParser_parseLine used before.
+// usage: benchAssTokenizer [number of dialogs] [rounds]
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SubFX/asstokenizer.h"
+#include "SubFX/assparserregex.h"
+#include "SubFX/regex.h"
+#include "SubFX/bench/bench.h"
+
+#define STYLE_COUNT 20
+
+typedef enum SECTION
+{
+    Idle,
+    Script_Info,
+    V4_Styles,
+    Events
+} SECTION;
+
+static char *createScript(size_t dialogs, size_t *size, size_t *lines)
+{
+    size_t cap = 4096 + (STYLE_COUNT + dialogs) * 256;
+    char *ret = malloc(cap);
+    if (!ret) return NULL;
+
+    size_t len = 0;
+    size_t count = 0;
+#define APPEND(...) \
+    len += (size_t)snprintf(ret + len, cap - len, __VA_ARGS__); \
+    ++count;
+
+    APPEND("[Script Info]\n");
+    APPEND("ScriptType: v4.00+\n");
+    APPEND("WrapStyle: 0\n");
+    APPEND("ScaledBorderAndShadow: yes\n");
+    APPEND("PlayResX: 1920\n");
+    APPEND("PlayResY: 1080\n");
+    APPEND("YCbCr Matrix: TV.709\n");
+    APPEND("\n");
+    APPEND("[V4+ Styles]\n");
+    APPEND("Format: Name, Fontname, Fontsize, PrimaryColour, "
+           "SecondaryColour, OutlineColour, BackColour, Bold, Italic, "
+           "Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, "
+           "BorderStyle, Outline, Shadow, Alignment, MarginL, MarginR, "
+           "MarginV, Encoding\n");
+
+    size_t i;
+    for (i = 0; i < STYLE_COUNT; ++i)
+    {
+        APPEND("Style: Style%zu,Source Han Sans,%zu,&H00FFFFFF,&H000000FF,"
+               "&H00000000,&H80000000,-1,0,0,0,100,100,0.5,0,1,2.5,0,%zu,"
+               "10,10,%zu,1\n",
+               i, 40 + i, (i % 9) + 1, 20 + i);
+    }
+
+    APPEND("\n");
+    APPEND("[Events]\n");
+    APPEND("Format: Layer, Start, End, Style, Name, MarginL, MarginR, "
+           "MarginV, Effect, Text\n");
+
+    for (i = 0; i < dialogs; ++i)
+    {
+        APPEND("%s: %zu,0:%02zu:%02zu.%02zu,0:%02zu:%02zu.%02zu,Style%zu,"
+               ",0,0,0,karaoke,{\\k20}Ka{\\k15}ra{\\k30}o{\\k25}ke, "
+               "line %zu\n",
+               (i % 10) ? "Dialogue" : "Comment",
+               i % 4,
+               (i / 60) % 60, i % 60, i % 100,
+               ((i + 3) / 60) % 60, (i + 3) % 60, i % 100,
+               i % STYLE_COUNT,
+               i);
+    }
+#undef APPEND
+
+    *size = len;
+    *lines = count;
+    return ret;
+}
+
+static bool nextLine(const char *buf,
+                     size_t size,
+                     size_t *offset,
+                     const char **line,
+                     size_t *lineLen)
+{
+    if (*offset >= size) return false;
+
+    const char *begin = buf + *offset;
+    const char *end = memchr(begin, '\n', size - *offset);
+    *line = begin;
+    *lineLen = end ? (size_t)(end - begin) : (size - *offset);
+    *offset += (*lineLen + 1);
+    return true;
+}
+
+static uint8_t regexInit(Regex *regex)
+{
+    static const char *patterns[REGEX_COUNT] =
+    {
+        REGEX_STR_ASS_SECION_MARK,
+        REGEX_STR_WRAP_STYLE,
+        REGEX_STR_SCALED_BORDER_AND_SHADOW,
+        REGEX_STR_PLAY_RES_X,
+        REGEX_STR_PLAY_RES_Y,
+        REGEX_STR_YCBCR_MATRIX,
+        REGEX_STR_V4_STYLES,
+        REGEX_STR_EVENTS
+    };
+
+    int i;
+    for (i = 0; i < REGEX_COUNT; ++i)
+    {
+        if (RegexData_init(&regex[i], patterns[i]))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// the old dispatch: match patterns one by one,
+// the conversion of the captured groups is NOT counted
+static uint64_t runRegex(Regex *regex, const char *buf, size_t size)
+{
+    SECTION section = Idle;
+    size_t offset = 0;
+    const char *line;
+    size_t lineLen;
+    int pcreRet;
+    uint64_t matched = 0;
+    int i;
+    while (nextLine(buf, size, &offset, &line, &lineLen))
+    {
+        if (RegexData_matchLen(&regex[REGEX_ASS_SECION_MARK],
+                               line, lineLen, &pcreRet))
+        {
+            if (lineLen == 13 && !memcmp(line, "[Script Info]", 13))
+            {
+                section = Script_Info;
+            }
+            else if (lineLen == 12 && !memcmp(line, "[V4+ Styles]", 12))
+            {
+                section = V4_Styles;
+            }
+            else if (lineLen == 8 && !memcmp(line, "[Events]", 8))
+            {
+                section = Events;
+            }
+
+            continue;
+        }
+
+        switch (section)
+        {
+        case Script_Info:
+        {
+            for (i = REGEX_WRAP_STYLE; i <= REGEX_YCBCR_MATRIX; ++i)
+            {
+                if (RegexData_matchLen(&regex[i], line, lineLen, &pcreRet))
+                {
+                    ++matched;
+                    break;
+                }
+            }
+            break;
+        }
+        case V4_Styles:
+        {
+            if (RegexData_matchLen(&regex[REGEX_V4_STYLES],
+                                   line, lineLen, &pcreRet))
+            {
+                ++matched;
+            }
+            break;
+        }
+        case Events:
+        {
+            if (RegexData_matchLen(&regex[REGEX_EVENTS],
+                                   line, lineLen, &pcreRet))
+            {
+                ++matched;
+            }
+            break;
+        }
+        default:
+        {
+            break;
+        }
+        } // end switch
+    }
+
+    return matched;
+}
+
+// classify, split and convert every field
+static uint64_t runTokenizer(const char *buf, size_t size)
+{
+    size_t offset = 0;
+    const char *line;
+    size_t lineLen;
+    uint64_t matched = 0;
+    AssField value;
+    AssField fields[ASS_STYLE_FIELDS];
+    int64_t number;
+    uint64_t ms;
+    double real;
+    uint8_t color[4];
+    size_t i;
+    bool ok;
+    while (nextLine(buf, size, &offset, &line, &lineLen))
+    {
+        switch (AssTokenizer_classify(line, lineLen, &value))
+        {
+        case AssLine_WrapStyle:
+        case AssLine_PlayResX:
+        case AssLine_PlayResY:
+        {
+            matched += AssTokenizer_toInt(&value, &number);
+            break;
+        }
+        case AssLine_ScaledBorderAndShadow:
+        case AssLine_YCbCrMatrix:
+        {
+            ++matched;
+            break;
+        }
+        case AssLine_Style:
+        {
+            if (AssTokenizer_split(&value, fields, ASS_STYLE_FIELDS) !=
+                ASS_STYLE_FIELDS)
+            {
+                break;
+            }
+
+            ok = AssTokenizer_toInt(&fields[2], &number);
+            for (i = 3; i < 7; ++i)
+            {
+                ok = ok && AssTokenizer_toColorAlpha(&fields[i], color);
+            }
+
+            for (i = 7; i < 11; ++i)
+            {
+                ok = ok && AssTokenizer_toInt(&fields[i], &number);
+            }
+
+            for (i = 11; i < 22; ++i)
+            {
+                ok = ok && AssTokenizer_toDouble(&fields[i], &real);
+            }
+
+            matched += (ok && AssTokenizer_toInt(&fields[22], &number));
+            break;
+        }
+        case AssLine_Dialogue:
+        case AssLine_Comment:
+        {
+            if (AssTokenizer_split(&value, fields, ASS_EVENT_FIELDS) !=
+                ASS_EVENT_FIELDS)
+            {
+                break;
+            }
+
+            ok = AssTokenizer_toInt(&fields[0], &number) &&
+                 AssTokenizer_toMs(&fields[1], &ms) &&
+                 AssTokenizer_toMs(&fields[2], &ms) &&
+                 AssTokenizer_toDouble(&fields[5], &real) &&
+                 AssTokenizer_toDouble(&fields[6], &real) &&
+                 AssTokenizer_toDouble(&fields[7], &real);
+            matched += ok;
+            break;
+        }
+        default:
+        {
+            break;
+        }
+        } // end switch
+    }
+
+    return matched;
+}
+
+int main(int argc, char **argv)
+{
+    size_t dialogs = (argc > 1) ? (size_t)strtoull(argv[1], NULL, 10) : 100000;
+    int rounds = (argc > 2) ? atoi(argv[2]) : 5;
+    if (!dialogs || rounds <= 0)
+    {
+        puts("usage: benchAssTokenizer [number of dialogs] [rounds]");
+        return 1;
+    }
+
+    size_t size, lines;
+    char *buf = createScript(dialogs, &size, &lines);
+    if (!buf)
+    {
+        puts("Fail to allocate memory.");
+        return 1;
+    }
+
+    Regex regex[REGEX_COUNT];
+    memset(regex, 0, sizeof(regex));
+    if (regexInit(regex))
+    {
+        puts("Fail to initialize regex.");
+        free(buf);
+        return 1;
+    }
+
+    double bestRegex = 1e30, bestTokenizer = 1e30;
+    uint64_t regexMatched = 0, tokenizerMatched = 0;
+    double start, elapsed;
+    int round, i;
+    for (round = 0; round < rounds; ++round)
+    {
+        start = benchNow();
+        regexMatched = runRegex(regex, buf, size);
+        elapsed = benchNow() - start;
+        if (elapsed < bestRegex) bestRegex = elapsed;
+
+        start = benchNow();
+        tokenizerMatched = runTokenizer(buf, size);
+        elapsed = benchNow() - start;
+        if (elapsed < bestTokenizer) bestTokenizer = elapsed;
+    }
+
+    printf("lines: %zu, bytes: %zu, best of %d rounds\n",
+           lines, size, rounds);
+    printf("regex:     %12.0f lines/s (%" PRIu64 " matched)\n",
+           (double)lines / bestRegex, regexMatched);
+    printf("tokenizer: %12.0f lines/s (%" PRIu64 " matched)\n",
+           (double)lines / bestTokenizer, tokenizerMatched);
+    printf("speedup:   %12.2fx\n", bestRegex / bestTokenizer);
+
+    for (i = 0; i < REGEX_COUNT; ++i)
+    {
+        RegexData_fin(&regex[i]);
+    }
+
+    free(buf);
+    return (regexMatched == tokenizerMatched) ? 0 : 1;
+}
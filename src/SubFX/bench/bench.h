@@ -0,0 +1,109 @@
+/*
+ * This file is part of SubFX,
+ * Copyright (c) 2020-2021 fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include "windows.h"
+#include "psapi.h"
+#else
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+// monotonic clock in seconds
+static inline double benchNow()
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+// resident set size of this process in bytes
+static inline size_t benchRss()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(),
+                              &counters,
+                              sizeof(counters)))
+    {
+        return 0;
+    }
+
+    return (size_t)counters.WorkingSetSize;
+#elif defined __linux__
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+
+    unsigned long size, resident;
+    int ret = fscanf(f, "%lu %lu", &size, &resident);
+    fclose(f);
+    if (ret != 2) return 0;
+
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+#else
+    // peak only, ru_maxrss is in bytes on macOS
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage)) return 0;
+
+    return (size_t)usage.ru_maxrss;
+#endif
+}
+
+// peak resident set size of this process in bytes
+static inline size_t benchPeakRss()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(),
+                              &counters,
+                              sizeof(counters)))
+    {
+        return 0;
+    }
+
+    return (size_t)counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage)) return 0;
+
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;
+#else
+    // KiB on Linux and the BSDs
+    return (size_t)usage.ru_maxrss << 10;
+#endif
+#endif
+}
@@ -0,0 +1,151 @@
+/*
+ * This file is part of SubFX,
+ * Copyright (c) 2020-2021 fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Formats shape-like coordinates with the old calloc + sprintf way and
+// with each formatter of subfx_misc_api, and checks they all agree.
+// usage: benchDoubleToString [count]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SubFX.h"
+#include "SubFX/bench/bench.h"
+
+// how subfx_misc_doubleToString used to work
+static char *oldDoubleToString(double input)
+{
+    double *buffer = calloc(500, sizeof(double));
+    if (!buffer)
+    {
+        return NULL;
+    }
+
+    sprintf((char *)(buffer), "%.3lf", input);
+    return (char *)(buffer);
+}
+
+static void report(const char *name, size_t count, double elapsed,
+                   size_t bytes)
+{
+    printf("%-16s %10zu numbers %9.3f ms %7.1f ns/number %10zu bytes\n",
+           name, count, elapsed * 1000.,
+           elapsed * 1e9 / (double)count, bytes);
+}
+
+int main(int argc, char **argv)
+{
+    size_t count = (argc > 1) ? (size_t)strtoull(argv[1], NULL, 10) : 0;
+    if (!count) count = 1000000;
+
+    SubFX api;
+    if (SubFX_init(&api) == subfx_failed)
+    {
+        puts("Failed in SubFX_init()");
+        return 1;
+    }
+
+    // what shapes are made of: rounded to 3 decimals, mostly small
+    double *values = malloc(count * sizeof(double));
+    char *batch = malloc(count * 32 + 1);
+    if (!values || !batch)
+    {
+        puts("Out of memory");
+        free(values);
+        free(batch);
+        SubFX_fin(&api);
+        return 1;
+    }
+
+    srand(42);
+    size_t i;
+    for (i = 0; i < count; ++i)
+    {
+        double value = ((double)rand() / RAND_MAX - .5) *
+                       pow(10., (double)(rand() % 5));
+        values[i] = floor(value * 1000. + .5) / 1000.;
+    }
+
+    int ret = 0;
+    size_t bytes = 0;
+    char *string;
+    double start = benchNow();
+    for (i = 0; i < count; ++i)
+    {
+        string = oldDoubleToString(values[i]);
+        bytes += strlen(string);
+        free(string);
+    }
+
+    report("calloc+sprintf", count, benchNow() - start, bytes);
+
+    bytes = 0;
+    start = benchNow();
+    for (i = 0; i < count; ++i)
+    {
+        string = api.misc.doubleToString(values[i]);
+        bytes += strlen(string);
+        free(string);
+    }
+
+    report("doubleToString", count, benchNow() - start, bytes);
+
+    char buffer[32];
+    bytes = 0;
+    start = benchNow();
+    for (i = 0; i < count; ++i)
+    {
+        bytes += api.misc.doubleToString2(values[i], buffer, sizeof(buffer));
+    }
+
+    report("doubleToString2", count, benchNow() - start, bytes);
+
+    start = benchNow();
+    bytes = api.misc.doublesToString(values, count, batch, count * 32 + 1);
+    report("doublesToString", count, benchNow() - start, bytes);
+
+    // every formatter has to give what sprintf gives
+    char expected[32];
+    char *p = batch;
+    for (i = 0; i < count; ++i)
+    {
+        size_t len = (size_t)sprintf(expected, "%.3lf", values[i]);
+        api.misc.doubleToString2(values[i], buffer, sizeof(buffer));
+        if (strcmp(expected, buffer) ||
+            strncmp(expected, p, len) ||
+            (p[len] != ' ' && p[len] != '\0'))
+        {
+            printf("mismatch: %s\n", expected);
+            ret = 1;
+            break;
+        }
+
+        p += len + 1;
+    }
+
+    free(values);
+    free(batch);
+    SubFX_fin(&api);
+    return ret;
+}
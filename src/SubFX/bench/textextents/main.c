@@ -0,0 +1,204 @@
+/*
+ * This file is part of SubFX,
+ * Copyright (c) 2020-2021 fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Measures every dialog, syl, word and char of a karaoke script
+// the way extendDialogs does, with each cache mode of FontHandle.
+// usage: benchTextExtents <ass file> [rounds]
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SubFX.h"
+#include "SubFX/bench/bench.h"
+
+typedef struct Mode
+{
+    const char *name;
+
+    uint8_t mode;
+} Mode;
+
+static const Mode modes[] =
+{
+    {"none", subfx_fonthandle_cache_none},
+    {"extents", subfx_fonthandle_cache_extents},
+    {"extents+advances",
+     subfx_fonthandle_cache_extents | subfx_fonthandle_cache_advances}
+};
+
+static int measureVector(SubFX *api,
+                         subfx_fontHandle *handle,
+                         fdsa_ptrVector *vector,
+                         size_t *count,
+                         double *checksum)
+{
+    size_t size, i;
+    if (api->fdsa->ptrVector.size(vector, &size) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    // syls, words and chars all start with subfx_ass_symbol
+    const subfx_ass_char *symbol;
+    double extents[2];
+    for (i = 0; i < size; ++i)
+    {
+        symbol = api->fdsa->ptrVector.at(vector, i);
+        if (api->fontHandle.text_extents2(handle,
+                                          symbol->text,
+                                          symbol->text_len,
+                                          extents) == subfx_failed)
+        {
+            return 1;
+        }
+
+        *checksum += extents[subfx_fonthandle_text_extents_width];
+        ++(*count);
+    }
+
+    return 0;
+}
+
+static int runMode(SubFX *api,
+                   subfx_assParser *parser,
+                   const Mode *mode,
+                   size_t rounds)
+{
+    size_t dialogs, i, round, count = 0;
+    if (api->fdsa->ptrVector.size(parser->dialogs, &dialogs) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    char errMsg[1024];
+    subfx_ass_dialog *dialog = api->fdsa->ptrVector.at(parser->dialogs, 0);
+    const subfx_ass_style *style = dialog->styleref;
+    subfx_fontHandle *handle = api->fontHandle.create(style->fontname,
+                                                      style->bold,
+                                                      style->italic,
+                                                      style->underline,
+                                                      style->strikeout,
+                                                      style->fontsize,
+                                                      style->scale_x / 100.,
+                                                      style->scale_y / 100.,
+                                                      style->spaceing,
+                                                      errMsg);
+    if (!handle)
+    {
+        puts(errMsg);
+        return 1;
+    }
+
+    api->fontHandle.setCacheMode(handle, mode->mode);
+
+    double checksum = 0., extents[2];
+    double start = benchNow();
+    for (round = 0; round < rounds; ++round)
+    {
+        for (i = 0; i < dialogs; ++i)
+        {
+            dialog = api->fdsa->ptrVector.at(parser->dialogs, i);
+            if (api->fontHandle.text_extents2(handle,
+                                              dialog->text_stripped,
+                                              dialog->text_stripped_len,
+                                              extents) == subfx_failed ||
+                measureVector(api, handle, dialog->syls,
+                              &count, &checksum) ||
+                measureVector(api, handle, dialog->words,
+                              &count, &checksum) ||
+                measureVector(api, handle, dialog->chars,
+                              &count, &checksum))
+            {
+                puts("Fail to get text extents");
+                api->fontHandle.destory(handle);
+                return 1;
+            }
+
+            checksum += extents[subfx_fonthandle_text_extents_width];
+            ++count;
+        }
+    }
+
+    double elapsed = benchNow() - start;
+    size_t hits, misses;
+    api->fontHandle.cacheStats(handle, &hits, &misses);
+    printf("%-17s %10zu texts %9.3f ms %10.0f texts/s "
+           "hits %zu misses %zu checksum %.3f\n",
+           mode->name, count, elapsed * 1000.,
+           (double)count / elapsed, hits, misses, checksum);
+
+    api->fontHandle.destory(handle);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        puts("usage: benchTextExtents <ass file> [rounds]");
+        return 1;
+    }
+
+    size_t rounds = (argc > 2) ? (size_t)strtoull(argv[2], NULL, 10) : 1;
+    if (!rounds) rounds = 1;
+
+    SubFX api;
+    if (SubFX_init(&api) == subfx_failed)
+    {
+        puts("Failed in SubFX_init()");
+        return 1;
+    }
+
+    char errMsg[1024];
+    subfx_assParser *parser = api.assParser.create(argv[1], NULL, errMsg);
+    if (!parser)
+    {
+        puts(errMsg);
+        SubFX_fin(&api);
+        return 1;
+    }
+
+    // one thread, so the extension does not disturb the timing below
+    if (api.assParser.extendDialogs2(parser, 1, errMsg) == subfx_failed)
+    {
+        puts(errMsg);
+        api.assParser.destory(parser);
+        SubFX_fin(&api);
+        return 1;
+    }
+
+    int ret = 0;
+    size_t i;
+    for (i = 0; i < (sizeof(modes) / sizeof(Mode)); ++i)
+    {
+        if (runMode(&api, parser, &modes[i], rounds))
+        {
+            ret = 1;
+            break;
+        }
+    }
+
+    api.assParser.destory(parser);
+    SubFX_fin(&api);
+    return ret;
+}
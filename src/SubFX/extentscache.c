@@ -0,0 +1,187 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "extentscache.h"
+
+#define INITIAL_CAPACITY 256
+
+uint8_t ExtentsCache_init(ExtentsCache *in)
+{
+    if (!in) return 1;
+
+    memset(in, 0, sizeof(ExtentsCache));
+    in->entries = calloc(INITIAL_CAPACITY, sizeof(ExtentsCacheEntry));
+    if (!in->entries)
+    {
+        return 1;
+    }
+
+    in->capacity = INITIAL_CAPACITY;
+    Arena_init(&in->arena, 0);
+    return 0;
+}
+
+void ExtentsCache_fin(ExtentsCache *in)
+{
+    if (!in) return;
+
+    free(in->entries);
+    Arena_fin(&in->arena);
+    memset(in, 0, sizeof(ExtentsCache));
+}
+
+uint64_t ExtentsCache_hash(const char *text, size_t len)
+{
+    uint64_t ret = 14695981039346656037ULL;
+    size_t i;
+    for (i = 0; i < len; ++i)
+    {
+        ret ^= (uint8_t)text[i];
+        ret *= 1099511628211ULL;
+    }
+
+    return ret;
+}
+
+static ExtentsCacheEntry *findSlot(ExtentsCacheEntry *entries,
+                                   size_t capacity,
+                                   const char *text,
+                                   size_t len,
+                                   uint64_t hash)
+{
+    size_t mask = capacity - 1;
+    size_t index = (size_t)hash & mask;
+    ExtentsCacheEntry *entry;
+    while (1)
+    {
+        entry = &entries[index];
+        if (!entry->text)
+        {
+            return entry;
+        }
+
+        if (entry->hash == hash &&
+            entry->len == len &&
+            !memcmp(entry->text, text, len))
+        {
+            return entry;
+        }
+
+        index = (index + 1) & mask;
+    }
+}
+
+const double *ExtentsCache_find(ExtentsCache *in,
+                                const char *text,
+                                size_t len,
+                                uint64_t hash)
+{
+    if (!in || !text) return NULL;
+
+    ExtentsCacheEntry *entry = findSlot(in->entries, in->capacity,
+                                        text, len, hash);
+    if (!entry->text)
+    {
+        ++in->misses;
+        return NULL;
+    }
+
+    ++in->hits;
+    return entry->value;
+}
+
+static uint8_t grow(ExtentsCache *in)
+{
+    size_t capacity = in->capacity << 1;
+    ExtentsCacheEntry *entries = calloc(capacity, sizeof(ExtentsCacheEntry));
+    if (!entries)
+    {
+        return 1;
+    }
+
+    size_t i;
+    ExtentsCacheEntry *slot;
+    for (i = 0; i < in->capacity; ++i)
+    {
+        if (!in->entries[i].text) continue;
+
+        slot = findSlot(entries, capacity,
+                        in->entries[i].text,
+                        in->entries[i].len,
+                        in->entries[i].hash);
+        *slot = in->entries[i];
+    }
+
+    free(in->entries);
+    in->entries = entries;
+    in->capacity = capacity;
+    return 0;
+}
+
+static void clear(ExtentsCache *in)
+{
+    memset(in->entries, 0, in->capacity * sizeof(ExtentsCacheEntry));
+    in->size = 0;
+    Arena_fin(&in->arena);
+    Arena_init(&in->arena, 0);
+}
+
+uint8_t ExtentsCache_insert(ExtentsCache *in,
+                            const char *text,
+                            size_t len,
+                            uint64_t hash,
+                            const double *value)
+{
+    if (!in || !text || !value) return 1;
+
+    if (in->size >= ExtentsCache_maxSize)
+    {
+        clear(in);
+    }
+
+    // keep the load factor under 1/2
+    if (((in->size + 1) << 1) > in->capacity && grow(in))
+    {
+        return 1;
+    }
+
+    ExtentsCacheEntry *entry = findSlot(in->entries, in->capacity,
+                                        text, len, hash);
+    if (!entry->text)
+    {
+        char *key = Arena_strndup(&in->arena, text, len);
+        if (!key)
+        {
+            return 1;
+        }
+
+        entry->hash = hash;
+        entry->text = key;
+        entry->len = len;
+        ++in->size;
+    }
+
+    memcpy(entry->value, value, EXTENTS_CACHE_VALUES * sizeof(double));
+    return 0;
+}
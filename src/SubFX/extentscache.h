@@ -0,0 +1,94 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "arena.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Memoizes up to EXTENTS_CACHE_VALUES doubles per string,
+ * e.g. the extents of a text.
+ * It is an open addressing hash table, the keys are copied into its
+ * own arena. When it has ExtentsCache_maxSize entries, it is cleared
+ * instead of growing, so a long script can not make it grow forever.
+ */
+#define EXTENTS_CACHE_VALUES 3
+
+typedef struct ExtentsCacheEntry
+{
+    uint64_t hash;
+
+    // NULL if the slot is empty
+    const char *text;
+
+    size_t len;
+
+    double value[EXTENTS_CACHE_VALUES];
+} ExtentsCacheEntry;
+
+typedef struct ExtentsCache
+{
+    ExtentsCacheEntry *entries;
+
+    // always a power of 2
+    size_t capacity;
+
+    size_t size;
+
+    Arena arena;
+
+    size_t hits;
+
+    size_t misses;
+} ExtentsCache;
+
+#define ExtentsCache_maxSize 65536
+
+uint8_t ExtentsCache_init(ExtentsCache *);
+
+void ExtentsCache_fin(ExtentsCache *);
+
+// 64-bit FNV-1a
+uint64_t ExtentsCache_hash(const char *text, size_t len);
+
+// @return NULL if the text is not in the cache.
+const double *ExtentsCache_find(ExtentsCache *,
+                                const char *text,
+                                size_t len,
+                                uint64_t hash);
+
+// value must have EXTENTS_CACHE_VALUES doubles
+uint8_t ExtentsCache_insert(ExtentsCache *,
+                            const char *text,
+                            size_t len,
+                            uint64_t hash,
+                            const double *value);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,151 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "fontcache.h"
+
+uint8_t FontCache_init(FontCache *in)
+{
+    if (!in) return 1;
+
+    memset(in, 0, sizeof(FontCache));
+    return 0;
+}
+
+void FontCache_fin(FontCache *in)
+{
+    if (!in) return;
+
+    size_t i;
+    for (i = 0; i < in->size; ++i)
+    {
+        subfx_fontHandle_destroy(in->entries[i].handle);
+    }
+
+    free(in->entries);
+    memset(in, 0, sizeof(FontCache));
+}
+
+static bool entryIsEqual(const FontCacheEntry *entry,
+                         const FontCacheEntry *key)
+{
+    // compare the cheap fields first
+    return (entry->size == key->size &&
+            entry->bold == key->bold &&
+            entry->italic == key->italic &&
+            entry->underline == key->underline &&
+            entry->strikeout == key->strikeout &&
+            entry->xscale == key->xscale &&
+            entry->yscale == key->yscale &&
+            entry->hspace == key->hspace &&
+            !strcmp(entry->family, key->family));
+}
+
+static uint8_t reserve(FontCache *in)
+{
+    if (in->size < in->capacity) return 0;
+
+    size_t capacity = in->capacity ? (in->capacity << 1) : 8;
+    FontCacheEntry *entries = realloc(in->entries,
+                                      capacity * sizeof(FontCacheEntry));
+    if (!entries)
+    {
+        return 1;
+    }
+
+    in->entries = entries;
+    in->capacity = capacity;
+    return 0;
+}
+
+FontCacheEntry *FontCache_get(FontCache *in,
+                              const subfx_ass_style *style,
+                              char *errMsg)
+{
+    if (!in || !style) return NULL;
+
+    FontCacheEntry key;
+    memcpy(key.family, style->fontname, SUBFX_FONT_NAME_LEN);
+    key.family[SUBFX_FONT_NAME_LEN - 1] = '\0';
+    key.bold = style->bold;
+    key.italic = style->italic;
+    key.underline = style->underline;
+    key.strikeout = style->strikeout;
+    key.size = style->fontsize;
+    key.xscale = style->scale_x / 100.;
+    key.yscale = style->scale_y / 100.;
+    key.hspace = style->spaceing;
+
+    // a script has only a few styles, a linear search is enough
+    size_t i;
+    for (i = 0; i < in->size; ++i)
+    {
+        if (entryIsEqual(&in->entries[i], &key))
+        {
+            ++in->hits;
+            return &in->entries[i];
+        }
+    }
+
+    ++in->misses;
+    if (reserve(in))
+    {
+        subfx_pError(errMsg, "FontCache_get: Fail to allocate memory.");
+        return NULL;
+    }
+
+    key.handle = subfx_fontHandle_create(key.family,
+                                         key.bold,
+                                         key.italic,
+                                         key.underline,
+                                         key.strikeout,
+                                         key.size,
+                                         key.xscale,
+                                         key.yscale,
+                                         key.hspace,
+                                         errMsg);
+    if (!key.handle)
+    {
+        return NULL;
+    }
+
+    // karaoke measures the same syls and chars again and again
+    subfx_fontHandle_setCacheMode(key.handle,
+                                  subfx_fonthandle_cache_extents |
+                                  subfx_fonthandle_cache_advances);
+
+    double *metrics = subfx_fontHandle_metrics(key.handle);
+    if (!metrics)
+    {
+        subfx_pError(errMsg, "FontCache_get: Fail to get font metrics");
+        subfx_fontHandle_destroy(key.handle);
+        return NULL;
+    }
+
+    memcpy(key.metrics, metrics, 5 * sizeof(double));
+    free(metrics);
+
+    in->entries[in->size] = key;
+    return &in->entries[in->size++];
+}
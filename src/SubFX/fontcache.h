@@ -0,0 +1,99 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ass/data.h"
+#include "fonthandle.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * A font handle and the metrics of a style.
+ * The metrics are indexed by subfx_fonthandle_metrics_XXX.
+ */
+typedef struct FontCacheEntry
+{
+    char family[SUBFX_FONT_NAME_LEN];
+
+    bool bold;
+
+    bool italic;
+
+    bool underline;
+
+    bool strikeout;
+
+    int32_t size;
+
+    double xscale;
+
+    double yscale;
+
+    double hspace;
+
+    subfx_fontHandle *handle;
+
+    double metrics[5];
+} FontCacheEntry;
+
+/**
+ * Font handles keyed by the font-related fields of a style.
+ * A subfx_fontHandle keeps a Pango layout that is modified on every
+ * measurement, so a cache must not be shared between threads.
+ * Give every thread its own one.
+ */
+typedef struct FontCache
+{
+    FontCacheEntry *entries;
+
+    size_t size;
+
+    size_t capacity;
+
+    size_t hits;
+
+    size_t misses;
+} FontCache;
+
+uint8_t FontCache_init(FontCache *);
+
+// destroys all font handles in the cache
+void FontCache_fin(FontCache *);
+
+/**
+ * Gets the entry of the style, creates the font handle on the first call.
+ * The returned pointer is valid until the next call.
+ * @return If failed, it will return NULL.
+ */
+FontCacheEntry *FontCache_get(FontCache *,
+                              const subfx_ass_style *,
+                              char *errMsg);
+
+#ifdef __cplusplus
+}
+#endif
@@ -17,6 +17,8 @@
 *    <http://www.gnu.org/licenses/>.
 */
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef _WIN32
@@ -26,13 +28,16 @@
 #endif
 
 #include "common.h"
+#include "extentscache.h"
 #include "fonthandle.h"
-#include "global.h"
-#include "misc.h"
-#include "smath.h"
+#include "glyphcache.h"
+#include "shapepath.h"
+#include "strbuf.h"
 
 #define FONT_PRECISION 64
 
+#define GLYPH_CACHE_BUDGET (4 << 20)
+
 typedef struct subfx_fontHandle
 {
 #ifdef _WIN32
@@ -42,8 +47,6 @@ typedef struct subfx_fontHandle
 
     HGDIOBJ old_font;
 
-    double hspace;
-
     int upscale;
 #else
     cairo_surface_t *surface;
@@ -53,15 +56,48 @@ typedef struct subfx_fontHandle
     PangoLayout *layout;
 
     double fonthack_scale;
+
+    // per character {width, ascent, descent} in pango units
+    ExtentsCache advances;
+
+    // two characters, value[0] is 1 if their widths add up
+    ExtentsCache pairs;
+
+    // (font, glyph id) -> outline, see setGlyphCacheBudget()
+    GlyphCache glyphs;
+
+    // outline that did not fit into glyphs
+    subfx_shapePath glyphScratch;
+
+    // one glyph at 0, 0 to get an outline from pango
+    PangoGlyphString *glyphString;
+
+    // underline or strikeout
+    bool decorated;
 #endif
 
+    double hspace;
+
     double xscale;
 
     double yscale;
 
     double downscale;
+
+    uint8_t cacheMode;
+
+    // text -> {width, height}
+    ExtentsCache extents;
 } subfx_fontHandle;
 
+#ifndef _WIN32
+// the glyph cache holds a reference to the font of every outline
+static void releaseFont(const void *font)
+{
+    g_object_unref((gpointer)font);
+}
+#endif
+
 subfx_exitstate subfx_fontHandle_init(subfx_fontHandle_api *ret)
 {
     if (!ret)
@@ -73,7 +109,16 @@ subfx_exitstate subfx_fontHandle_init(subfx_fontHandle_api *ret)
     ret->destory = subfx_fontHandle_destroy;
     ret->metrics = subfx_fontHandle_metrics;
     ret->text_extents = subfx_fontHandle_text_extents;
+    ret->text_extents2 = subfx_fontHandle_text_extents2;
+    ret->setCacheMode = subfx_fontHandle_setCacheMode;
+    ret->cacheStats = subfx_fontHandle_cacheStats;
+    ret->setGlyphCacheBudget = subfx_fontHandle_setGlyphCacheBudget;
+    ret->glyphCacheStats = subfx_fontHandle_glyphCacheStats;
     ret->text_to_shape = subfx_fontHandle_text_to_shape;
+    ret->text_to_shape2 = subfx_fontHandle_text_to_shape2;
+    ret->text_to_path = subfx_fontHandle_text_to_path;
+    ret->path_to_shape = subfx_fontHandle_path_to_shape;
+    ret->destoryPath = subfx_fontHandle_destroyPath;
 
     return subfx_success;
 }
@@ -104,8 +149,16 @@ subfx_fontHandle *subfx_fontHandle_create(const char *family,
 
     ret->xscale = xscale;
     ret->yscale = yscale;
-#ifdef _WIN32
     ret->hspace = hspace;
+    ret->cacheMode = subfx_fonthandle_cache_extents |
+                     subfx_fonthandle_cache_glyphs;
+    if (ExtentsCache_init(&ret->extents))
+    {
+        subfx_fontHandle_destroy(ret);
+        return NULL;
+    }
+
+#ifdef _WIN32
     ret->upscale = FONT_PRECISION;
     ret->downscale = (1.f / (double)ret->upscale);
     ret->dc = NULL;
@@ -117,6 +170,7 @@ subfx_fontHandle *subfx_fontHandle_create(const char *family,
         subfx_fontHandle_destroy(ret);
         subfx_pError(errMsg,
                      "FontHandle->create: family name too long");
+        return NULL;
     }
 
     ret->dc = CreateCompatibleDC(NULL);
@@ -168,11 +222,22 @@ subfx_fontHandle *subfx_fontHandle_create(const char *family,
 
     ret->old_font = SelectObject(ret->dc, ret->font);
 #else
-    int upscale(FONT_PRECISION);
+    int upscale = FONT_PRECISION;
     ret->downscale = (1. / (double)upscale);
-    ret->surface = NULL;
-    ret->context = NULL;
-    ret->layout = NULL;
+    ret->decorated = underline || strikeout;
+    ret->glyphString = pango_glyph_string_new();
+    if (ExtentsCache_init(&ret->advances) ||
+        ExtentsCache_init(&ret->pairs) ||
+        GlyphCache_init(&ret->glyphs, GLYPH_CACHE_BUDGET, releaseFont) ||
+        !ret->glyphString)
+    {
+        subfx_fontHandle_destroy(ret);
+        return NULL;
+    }
+
+    pango_glyph_string_set_size(ret->glyphString, 1);
+    memset(ret->glyphString->glyphs, 0, sizeof(PangoGlyphInfo));
+    ret->glyphString->glyphs[0].attr.is_cluster_start = 1;
 
     // This is almost copypasta from Youka/Yutils
     ret->surface = cairo_image_surface_create(CAIRO_FORMAT_A8, 1, 1);
@@ -185,7 +250,6 @@ subfx_fontHandle *subfx_fontHandle_create(const char *family,
     ret->context = cairo_create(ret->surface);
     if (!ret->context)
     {
-        cairo_surface_destroy(ret->surface);
         subfx_fontHandle_destroy(ret);
         return NULL;
     }
@@ -193,19 +257,14 @@ subfx_fontHandle *subfx_fontHandle_create(const char *family,
     ret->layout = pango_cairo_create_layout(ret->context);
     if (!ret->layout)
     {
-        cairo_destroy(ret->context);
-        cairo_surface_destroy(ret->surface);
         subfx_fontHandle_destroy(ret);
         return NULL;
     }
 
     //set font to layout
-    PangoFontDescription *font_desc(pango_font_description_new());
+    PangoFontDescription *font_desc = pango_font_description_new();
     if (!font_desc)
     {
-        g_object_unref(ret->layout);
-        cairo_destroy(ret->context);
-        cairo_surface_destroy(ret->surface);
         subfx_fontHandle_destroy(ret);
         return NULL;
     }
@@ -221,13 +280,10 @@ subfx_fontHandle *subfx_fontHandle_create(const char *family,
                                              size * PANGO_SCALE * upscale);
     pango_layout_set_font_description(ret->layout, font_desc);
 
-    PangoAttrList *attr(pango_attr_list_new());
+    PangoAttrList *attr = pango_attr_list_new();
     if (!attr)
     {
         pango_font_description_free(font_desc);
-        g_object_unref(ret->layout);
-        cairo_destroy(ret->context);
-        cairo_surface_destroy(ret->surface);
         subfx_fontHandle_destroy(ret);
         return NULL;
     }
@@ -240,26 +296,23 @@ subfx_fontHandle *subfx_fontHandle_create(const char *family,
                            pango_attr_strikethrough_new(strikeout));
     pango_attr_list_insert(attr,
                            pango_attr_letter_spacing_new(
-                           static_cast<int>(hspace) * PANGO_SCALE * upscale));
+                           (int)hspace * PANGO_SCALE * upscale));
     pango_layout_set_attributes(ret->layout, attr);
 
-    PangoFontMetrics *metrics(pango_context_get_metrics(
-                              pango_layout_get_context(ret->layout),
-                              pango_layout_get_font_description(ret->layout),
-                              NULL));
+    PangoFontMetrics *metrics = pango_context_get_metrics(
+                                pango_layout_get_context(ret->layout),
+                                pango_layout_get_font_description(ret->layout),
+                                NULL);
     if (!metrics)
     {
         pango_attr_list_unref(attr);
         pango_font_description_free(font_desc);
-        g_object_unref(ret->layout);
-        cairo_destroy(ret->context);
-        cairo_surface_destroy(ret->surface);
         subfx_fontHandle_destroy(ret);
         return NULL;
     }
 
-    double ascent((double)pango_font_metrics_get_ascent(metrics));
-    double descent((double)pango_font_metrics_get_descent(metrics));
+    double ascent = (double)pango_font_metrics_get_ascent(metrics);
+    double descent = (double)pango_font_metrics_get_descent(metrics);
 
     ret->fonthack_scale = size /
                          ((ascent + descent) /
@@ -283,11 +336,17 @@ subfx_exitstate subfx_fontHandle_destroy(subfx_fontHandle *handle)
     DeleteObject(handle->font);
     DeleteDC(handle->dc);
 #else
-    g_object_unref(handle->layout);
-    cairo_destroy(handle->context);
-    cairo_surface_destroy(handle->surface);
+    if (handle->layout) g_object_unref(handle->layout);
+    if (handle->context) cairo_destroy(handle->context);
+    if (handle->surface) cairo_surface_destroy(handle->surface);
+    ExtentsCache_fin(&handle->advances);
+    ExtentsCache_fin(&handle->pairs);
+    GlyphCache_fin(&handle->glyphs);
+    ShapePath_fin(&handle->glyphScratch);
+    if (handle->glyphString) pango_glyph_string_free(handle->glyphString);
 #endif
 
+    ExtentsCache_fin(&handle->extents);
     free(handle);
     return subfx_success;
 }
@@ -347,11 +406,11 @@ double *subfx_fontHandle_metrics(subfx_fontHandle *handle)
 
     free(fontMetrics);
 #else
-    PangoFontMetrics *fontMetrics(pango_context_get_metrics(
+    PangoFontMetrics *fontMetrics = pango_context_get_metrics(
         pango_layout_get_context(handle->layout),
         pango_layout_get_font_description(handle->layout),
         NULL
-    ));
+    );
 
     if (!fontMetrics)
     {
@@ -397,7 +456,7 @@ double *subfx_fontHandle_metrics(subfx_fontHandle *handle)
 double *subfx_fontHandle_text_extents(subfx_fontHandle *handle,
                                       const char *text)
 {
-    if (!handle)
+    if (!handle || !text)
     {
         return NULL;
     }
@@ -408,110 +467,435 @@ double *subfx_fontHandle_text_extents(subfx_fontHandle *handle,
         return NULL;
     }
 
-#ifdef _WIN32
-    size_t textLen = strlen(text);
-
-    SIZE *size = calloc(1, sizeof(SIZE));
-    if (!size)
+    if (subfx_fontHandle_text_extents2(handle,
+                                       text,
+                                       strlen(text),
+                                       ret) == subfx_failed)
     {
         free(ret);
         return NULL;
     }
 
+    return ret;
+}
+
+#ifdef _WIN32
+static uint8_t measureText(subfx_fontHandle *handle,
+                           const char *text,
+                           size_t textLen,
+                           double *out)
+{
+    SIZE size;
     if (GetTextExtentPoint32A(handle->dc, text,
-                              (int)textLen, size) == 0)
+                              (int)textLen, &size) == 0)
     {
-        free(size);
-        free(ret);
-        return NULL;
+        return 1;
     }
 
-    ret[subfx_fonthandle_text_extents_width] =
-            (size->cx * handle->downscale +
+    out[subfx_fonthandle_text_extents_width] =
+            (size.cx * handle->downscale +
              handle->hspace * textLen) *
              handle->xscale;
 
-    ret[subfx_fonthandle_text_extents_height] =
-            size->cy *
+    out[subfx_fonthandle_text_extents_height] =
+            size.cy *
             handle->downscale *
             handle->yscale;
 
-    free(size);
+    return 0;
+}
 #else
-    pango_layout_set_text(handle->layout, text, -1);
-    PangoRectangle *rect = calloc(1, sizeof(PangoRectangle));
-    if (!rect)
+// logical extents of the layout in pango units
+static void layoutExtents(subfx_fontHandle *handle,
+                          const char *text,
+                          size_t textLen,
+                          PangoRectangle *rect)
+{
+    pango_layout_set_text(handle->layout, text, (int)textLen);
+    pango_layout_get_extents(handle->layout, NULL, rect);
+}
+
+// Characters that are one glyph each, are not reordered and carry
+// no combining marks: Latin, CJK symbols, kana, ideographs and
+// full-width forms. Anything else goes through the full layout.
+static bool isSimpleCodepoint(uint32_t cp)
+{
+    return ((cp >= 0x20 && cp < 0x7f) ||
+            (cp >= 0xa0 && cp < 0x250) ||
+            (cp >= 0x3000 && cp < 0x3100) ||
+            (cp >= 0x4e00 && cp < 0xa000) ||
+            (cp >= 0xff01 && cp < 0xff61));
+}
+
+// Characters that fonts join with their neighbours by default
+// (liga, clig and calt), and not only with the next one, e.g. "ffi"
+// or "->" in coding fonts. Checking pairs can not catch that,
+// so text with any of them goes through the full layout.
+static bool isShapingSensitive(uint32_t cp)
+{
+    return (cp == 'f' ||
+            cp == 0x17f || // long s
+            (cp >= 0x21 && cp < 0x30) ||
+            (cp >= 0x3a && cp < 0x41) ||
+            (cp >= 0x5b && cp < 0x61) ||
+            (cp >= 0x7b && cp < 0x7f));
+}
+
+// @return 0 if the UTF-8 sequence is invalid
+static size_t decodeUtf8(const char *str, size_t remain, uint32_t *cp)
+{
+    const uint8_t *in = (const uint8_t *)str;
+    size_t len, i;
+    if (in[0] < 0x80)
+    {
+        *cp = in[0];
+        return 1;
+    }
+    else if ((in[0] & 0xe0) == 0xc0)
+    {
+        *cp = in[0] & 0x1f;
+        len = 2;
+    }
+    else if ((in[0] & 0xf0) == 0xe0)
+    {
+        *cp = in[0] & 0x0f;
+        len = 3;
+    }
+    else
+    {
+        return 0;
+    }
+
+    if (len > remain) return 0;
+
+    for (i = 1; i < len; ++i)
+    {
+        if ((in[i] & 0xc0) != 0x80) return 0;
+        *cp = (*cp << 6) | (in[i] & 0x3f);
+    }
+
+    return len;
+}
+
+// {width, ascent, descent} of one character, width is -1 if it
+// can not be added up, e.g. the glyph does not start at x = 0
+static const double *charAdvance(subfx_fontHandle *handle,
+                                 const char *text,
+                                 size_t len)
+{
+    uint64_t hash = ExtentsCache_hash(text, len);
+    const double *ret = ExtentsCache_find(&handle->advances,
+                                          text, len, hash);
+    if (ret)
+    {
+        return ret;
+    }
+
+    PangoRectangle rect;
+    layoutExtents(handle, text, len, &rect);
+
+    double value[EXTENTS_CACHE_VALUES];
+    double baseline = (double)pango_layout_get_baseline(handle->layout);
+    value[0] = (rect.x || rect.y) ? -1. : (double)rect.width;
+    value[1] = baseline;
+    value[2] = (double)rect.height - baseline;
+    if (ExtentsCache_insert(&handle->advances, text, len, hash, value))
     {
-        free(ret);
         return NULL;
     }
 
-    pango_layout_get_pixel_extents(handle->layout, NULL, rect);
-    ret[subfx_fonthandle_text_extents_width] =
-            rect->width *
+    return ExtentsCache_find(&handle->advances, text, len, hash);
+}
+
+// whether kerning or a ligature changes the width of two characters
+static bool pairIsAdditive(subfx_fontHandle *handle,
+                           const char *text,
+                           size_t len,
+                           double width)
+{
+    uint64_t hash = ExtentsCache_hash(text, len);
+    const double *cached = ExtentsCache_find(&handle->pairs,
+                                             text, len, hash);
+    if (cached)
+    {
+        return (cached[0] != 0.);
+    }
+
+    PangoRectangle rect;
+    layoutExtents(handle, text, len, &rect);
+
+    double value[EXTENTS_CACHE_VALUES] = {0., 0., 0.};
+    value[0] = ((double)rect.width == width) ? 1. : 0.;
+    ExtentsCache_insert(&handle->pairs, text, len, hash, value);
+    return (value[0] != 0.);
+}
+
+// Adds up the cached advances of the characters, it is exact only if
+// every adjacent pair is additive and nothing is shaped across more
+// than two characters. Otherwise it returns false.
+static bool fastExtents(subfx_fontHandle *handle,
+                        const char *text,
+                        size_t textLen,
+                        PangoRectangle *rect)
+{
+    // letter spacing is not always applied to the last character
+    if (!textLen || handle->hspace != 0.)
+    {
+        return false;
+    }
+
+    double width = 0., ascent = 0., descent = 0., prevWidth = 0.;
+    size_t pos = 0, prevPos = 0, prevLen = 0, len;
+    uint32_t cp;
+    const double *advance;
+    while (pos < textLen)
+    {
+        len = decodeUtf8(text + pos, textLen - pos, &cp);
+        if (!len || !isSimpleCodepoint(cp) ||
+            (textLen > len && isShapingSensitive(cp)))
+        {
+            return false;
+        }
+
+        advance = charAdvance(handle, text + pos, len);
+        if (!advance || advance[0] < 0.)
+        {
+            return false;
+        }
+
+        if (prevLen &&
+            !pairIsAdditive(handle, text + prevPos, prevLen + len,
+                            prevWidth + advance[0]))
+        {
+            return false;
+        }
+
+        width += advance[0];
+        if (advance[1] > ascent) ascent = advance[1];
+        if (advance[2] > descent) descent = advance[2];
+
+        prevWidth = advance[0];
+        prevPos = pos;
+        prevLen = len;
+        pos += len;
+    }
+
+    // a single line is as tall as its highest ascent plus
+    // its lowest descent, even if the characters come from
+    // different fonts
+    rect->x = 0;
+    rect->y = 0;
+    rect->width = (int)width;
+    rect->height = (int)(ascent + descent);
+    return true;
+}
+
+static uint8_t measureText(subfx_fontHandle *handle,
+                           const char *text,
+                           size_t textLen,
+                           double *out)
+{
+    PangoRectangle rect;
+    if (!(handle->cacheMode & subfx_fonthandle_cache_advances) ||
+        !fastExtents(handle, text, textLen, &rect))
+    {
+        layoutExtents(handle, text, textLen, &rect);
+    }
+
+    // the same rounding as pango_layout_get_pixel_extents()
+    pango_extents_to_pixels(&rect, NULL);
+    out[subfx_fonthandle_text_extents_width] =
+            rect.width *
             handle->downscale *
             handle->xscale *
             handle->fonthack_scale;
 
-    ret[subfx_fonthandle_text_extents_height] =
-            rect->height *
+    out[subfx_fonthandle_text_extents_height] =
+            rect.height *
             handle->downscale *
             handle->yscale *
             handle->fonthack_scale;
 
-    free(rect);
+    return 0;
+}
 #endif
 
-    return ret;
+subfx_exitstate subfx_fontHandle_text_extents2(subfx_fontHandle *handle,
+                                               const char *text,
+                                               size_t textLen,
+                                               double *out)
+{
+    if (!handle || !text || !out)
+    {
+        return subfx_failed;
+    }
+
+    bool useCache = (handle->cacheMode & subfx_fonthandle_cache_extents);
+    uint64_t hash = 0;
+    if (useCache)
+    {
+        hash = ExtentsCache_hash(text, textLen);
+        const double *cached = ExtentsCache_find(&handle->extents,
+                                                 text, textLen, hash);
+        if (cached)
+        {
+            out[subfx_fonthandle_text_extents_width] = cached[0];
+            out[subfx_fonthandle_text_extents_height] = cached[1];
+            return subfx_success;
+        }
+    }
+
+    double value[EXTENTS_CACHE_VALUES] = {0., 0., 0.};
+    if (measureText(handle, text, textLen, value))
+    {
+        return subfx_failed;
+    }
+
+    // a full cache only means the next call measures again
+    if (useCache)
+    {
+        ExtentsCache_insert(&handle->extents, text, textLen, hash, value);
+    }
+
+    out[subfx_fonthandle_text_extents_width] = value[0];
+    out[subfx_fonthandle_text_extents_height] = value[1];
+    return subfx_success;
+}
+
+subfx_exitstate subfx_fontHandle_setCacheMode(subfx_fontHandle *handle,
+                                              uint8_t mode)
+{
+    if (!handle) return subfx_failed;
+
+    handle->cacheMode = mode;
+    return subfx_success;
+}
+
+subfx_exitstate subfx_fontHandle_cacheStats(subfx_fontHandle *handle,
+                                            size_t *hits,
+                                            size_t *misses)
+{
+    if (!handle || !hits || !misses) return subfx_failed;
+
+    *hits = handle->extents.hits;
+    *misses = handle->extents.misses;
+    return subfx_success;
+}
+
+subfx_exitstate
+subfx_fontHandle_setGlyphCacheBudget(subfx_fontHandle *handle,
+                                     size_t bytes)
+{
+    if (!handle) return subfx_failed;
+
+#ifndef _WIN32
+    GlyphCache_setBudget(&handle->glyphs, bytes);
+#else
+    UNUSED(bytes);
+#endif
+
+    return subfx_success;
 }
 
+subfx_exitstate subfx_fontHandle_glyphCacheStats(subfx_fontHandle *handle,
+                                                 size_t *hits,
+                                                 size_t *misses)
+{
+    if (!handle || !hits || !misses) return subfx_failed;
+
 #ifdef _WIN32
-#define cleanUp \
-    AbortPath(handle->dc); \
-    free(points); \
-    free(types); \
-    if (!charWidths) \
-    { \
-        free(charWidths); \
-    } \
-     \
-    if (fdsa->ptrVector.destory(shape) == fdsa_failed) \
-    { \
-        subfx_pError(errMsg, "text_to_shape: you should" \
-                             " never see this message."); \
-    }
+    *hits = 0;
+    *misses = 0;
 #else
-#define cleanUp \
-    cairo_new_path(handle->context); \
-    cairo_path_destroy(path); \
-    if (fdsa->ptrVector.destory(shape) == fdsa_failed) \
-    { \
-        subfx_pError(errMsg, "text_to_shape: you should" \
-                             " never see this message."); \
-    }
+    *hits = handle->glyphs.hits;
+    *misses = handle->glyphs.misses;
 #endif
 
+    return subfx_success;
+}
+
 char *subfx_fontHandle_text_to_shape(subfx_fontHandle *handle,
                                      const char *text, char *errMsg)
 {
-    fDSA *fdsa = getFDSA();
-    if (!fdsa)
+    return subfx_fontHandle_text_to_shape2(handle, text, NULL, errMsg);
+}
+
+char *subfx_fontHandle_text_to_shape2(subfx_fontHandle *handle,
+                                      const char *text,
+                                      size_t *len,
+                                      char *errMsg)
+{
+    subfx_shapePath *path = subfx_fontHandle_text_to_path(handle, text, errMsg);
+    if (!path)
+    {
+        return NULL;
+    }
+
+    char *ret = subfx_fontHandle_path_to_shape(path, len, errMsg);
+    subfx_fontHandle_destroyPath(path);
+    return ret;
+}
+
+char *subfx_fontHandle_path_to_shape(const subfx_shapePath *path,
+                                     size_t *len,
+                                     char *errMsg)
+{
+    if (!path)
+    {
+        subfx_pError(errMsg, "path_to_shape: invalid input");
+        return NULL;
+    }
+
+    StrBuf buf;
+    if (StrBuf_init(&buf, 0) || ShapePath_toShape(path, &buf))
     {
+        StrBuf_fin(&buf);
+        subfx_pError(errMsg, "path_to_shape: fail to format the path");
         return NULL;
     }
 
-    char *retStr;
-    size_t retSize;
+    return StrBuf_release(&buf, len);
+}
+
+subfx_exitstate subfx_fontHandle_destroyPath(subfx_shapePath *path)
+{
+    if (!path)
+    {
+        return subfx_failed;
+    }
+
+    ShapePath_fin(path);
+    free(path);
+    return subfx_success;
+}
+
 #ifdef _WIN32
+#define cleanUp \
+    AbortPath(handle->dc); \
+    free(points); \
+    free(types); \
+    free(charWidths); \
+    subfx_fontHandle_destroyPath(ret);
+
+subfx_shapePath *subfx_fontHandle_text_to_path(subfx_fontHandle *handle,
+                                               const char *text,
+                                               char *errMsg)
+{
+    if (!handle || !text)
+    {
+        subfx_pError(errMsg, "text_to_path: invalid input");
+        return NULL;
+    }
+
     size_t textLen = strlen(text);
     if (textLen > 8192)
     {
-        subfx_pError(errMsg, "text_to_shape: text is too long");
+        subfx_pError(errMsg, "text_to_path: text is too long");
         return NULL;
     }
 
     INT *charWidths = NULL;
-    if (handle->hspace != 0)
+    if (handle->hspace != 0 && textLen)
     {
         charWidths = calloc(textLen, sizeof(INT));
         if (!charWidths)
@@ -519,59 +903,26 @@ char *subfx_fontHandle_text_to_shape(subfx_fontHandle *handle,
             return NULL;
         }
 
-        SIZE *size = calloc(1, sizeof(SIZE));
-        if (!size)
-        {
-            free(charWidths);
-            return NULL;
-        }
-
+        SIZE size;
         int space = (int)handle->hspace * handle->upscale;
-        for (size_t i = 0; i <= (textLen - 1); ++i)
+        for (size_t i = 0; i < textLen; ++i)
         {
-            if (GetTextExtentPoint32A(handle->dc, text + i, 1, size) == 0)
+            if (GetTextExtentPoint32A(handle->dc, text + i, 1, &size) == 0)
             {
                 free(charWidths);
-                free(size);
                 return NULL;
             }
 
-            charWidths[i] = size->cx + space;
+            charWidths[i] = size.cx + space;
         }
-
-        free(size);
     } // end if (hspace != 0)
 
-    if (BeginPath(handle->dc) == 0)
-    {
-        if (!charWidths)
-        {
-            free(charWidths);
-        }
-
-        AbortPath(handle->dc);
-        return NULL;
-    }
-
-    if (ExtTextOutA(handle->dc, 0, 0, 0x0, NULL, text,
-                    (UINT)textLen, charWidths) == 0)
-    {
-        if (!charWidths)
-        {
-            free(charWidths);
-        }
-
-        AbortPath(handle->dc);
-        return NULL;
-    }
-
-    if (EndPath(handle->dc) == 0)
+    if (BeginPath(handle->dc) == 0 ||
+        ExtTextOutA(handle->dc, 0, 0, 0x0, NULL, text,
+                    (UINT)textLen, charWidths) == 0 ||
+        EndPath(handle->dc) == 0)
     {
-        if (!charWidths)
-        {
-            free(charWidths);
-        }
-
+        free(charWidths);
         AbortPath(handle->dc);
         return NULL;
     }
@@ -579,341 +930,67 @@ char *subfx_fontHandle_text_to_shape(subfx_fontHandle *handle,
     int points_n = GetPath(handle->dc, NULL, NULL, 0);
     if (points_n <= 0)
     {
-        if (!charWidths)
-        {
-            free(charWidths);
-        }
-
+        free(charWidths);
         AbortPath(handle->dc);
         return NULL;
     }
 
     POINT *points = calloc(points_n, sizeof(POINT));
-    if (!points)
-    {
-        if (!charWidths)
-        {
-            free(charWidths);
-        }
-
-        AbortPath(handle->dc);
-        return NULL;
-    }
-
     BYTE *types = calloc(points_n, sizeof(BYTE));
-    if (!types)
+    subfx_shapePath *ret = malloc(sizeof(subfx_shapePath));
+    if (!points || !types || !ret || ShapePath_init(ret, (size_t)points_n))
     {
-        if (!charWidths)
-        {
-            free(charWidths);
-        }
-
+        free(charWidths);
         free(points);
+        free(types);
+        free(ret);
         AbortPath(handle->dc);
         return NULL;
     }
 
     GetPath(handle->dc, points, types, points_n);
 
-    fdsa_ptrVector *shape = fdsa->ptrVector.create(free);
-    if (!shape)
+    int i = 0;
+    BYTE cur_type = 0xff;
+    double xscale = handle->downscale * handle->xscale;
+    double yscale = handle->downscale * handle->yscale;
+    double coords[6];
+    uint8_t res;
+    while (i < points_n)
     {
-        if (!charWidths)
-        {
-            free(charWidths);
-        }
-
-        free(points);
-        free(types);
-        AbortPath(handle->dc);
-        return NULL;
-    }
-
-    // may be larger or smaller?
-    if (fdsa->ptrVector.reserve(shape, 2048) == fdsa_failed)
-    {
-        if (!charWidths)
-        {
-            free(charWidths);
-        }
-
-        free(points);
-        free(types);
-        AbortPath(handle->dc);
-        return NULL;
-    }
-
-    int i = 0;
-    BYTE last_type = 0xff, cur_type = 0xff;
-    POINT cur_point;
-    double tmpDouble = 0.f;
-    while (i < points_n)
-    {
-        cur_type = types[i];
-        cur_point = points[i];
+        cur_type = types[i];
+        res = 0;
 
         switch (cur_type)
         {
         case PT_MOVETO:
-            if (last_type != PT_MOVETO)
-            {
-                retStr = calloc(2, sizeof(char));
-                if (!retStr)
-                {
-                    cleanUp;
-                    return NULL;
-                }
-
-                memcpy(retStr, "m", 2);
-                if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-                {
-                    cleanUp;
-                    free(retStr);
-                    return NULL;
-                }
-
-                last_type = cur_type;
-            }
-
-            tmpDouble =
-                    subfx_math_round(
-                        cur_point.x *
-                        handle->downscale *
-                        handle->xscale, FP_PRECISION);
-
-            retStr = subfx_misc_doubleToString(tmpDouble);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
-
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
-
-            tmpDouble = subfx_math_round(
-                        cur_point.y *
-                        handle->downscale *
-                        handle->yscale, FP_PRECISION);
-
-            retStr = subfx_misc_doubleToString(tmpDouble);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
-
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
-
+            coords[0] = points[i].x * xscale;
+            coords[1] = points[i].y * yscale;
+            res = ShapePath_append(ret, subfx_shapePath_move, coords);
             ++i;
             break;
         case PT_LINETO:
         case (PT_LINETO + PT_CLOSEFIGURE):
-            if (last_type != PT_LINETO)
-            {
-                retStr = calloc(2, sizeof(char));
-                if (!retStr)
-                {
-                    cleanUp;
-                    return NULL;
-                }
-
-                memcpy(retStr, "l", 2);
-                if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-                {
-                    cleanUp;
-                    free(retStr);
-                    return NULL;
-                }
-
-                last_type = cur_type;
-            }
-
-            tmpDouble = subfx_math_round(
-                        cur_point.x *
-                        handle->downscale *
-                        handle->xscale, FP_PRECISION);
-
-            retStr = subfx_misc_doubleToString(tmpDouble);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
-
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
-
-            tmpDouble = subfx_math_round(
-                        cur_point.y *
-                        handle->downscale *
-                        handle->yscale, FP_PRECISION);
-
-            retStr = subfx_misc_doubleToString(tmpDouble);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
-
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
-
+            coords[0] = points[i].x * xscale;
+            coords[1] = points[i].y * yscale;
+            res = ShapePath_append(ret, subfx_shapePath_line, coords);
             ++i;
             break;
         case PT_BEZIERTO:
         case (PT_BEZIERTO + PT_CLOSEFIGURE):
-            if (last_type != PT_BEZIERTO)
-            {
-                retStr = calloc(2, sizeof(char));
-                if (!retStr)
-                {
-                    cleanUp;
-                    return NULL;
-                }
-
-                memcpy(retStr, "b", 2);
-                if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-                {
-                    cleanUp;
-                    free(retStr);
-                    return NULL;
-                }
-
-                last_type = cur_type;
-            }
-
-            tmpDouble = subfx_math_round(
-                        cur_point.x *
-                        handle->downscale *
-                        handle->xscale, FP_PRECISION);
-
-            retStr = subfx_misc_doubleToString(tmpDouble);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
-
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
-
-            tmpDouble = subfx_math_round(
-                        cur_point.y *
-                        handle->downscale *
-                        handle->yscale, FP_PRECISION);
-
-            retStr = subfx_misc_doubleToString(tmpDouble);
-            if (!retStr)
+            if (i + 2 >= points_n)
             {
-                cleanUp;
-                return NULL;
-            }
-
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
-
-            tmpDouble = subfx_math_round(
-                    points[i + 1].x *
-                    handle->downscale *
-                    handle->xscale, FP_PRECISION);
-
-            retStr = subfx_misc_doubleToString(tmpDouble);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
-
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
-
-            tmpDouble = subfx_math_round(
-                    points[i + 1].y *
-                    handle->downscale *
-                    handle->yscale, FP_PRECISION);
-
-            retStr = subfx_misc_doubleToString(tmpDouble);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
-
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
+                res = 1;
+                break;
             }
 
-            tmpDouble = subfx_math_round(
-                    points[i + 2].x *
-                    handle->downscale *
-                    handle->xscale, FP_PRECISION);
-
-            retStr = subfx_misc_doubleToString(tmpDouble);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
-
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
-
-            tmpDouble = subfx_math_round(
-                    points[i + 2].y *
-                    handle->downscale *
-                    handle->yscale, FP_PRECISION);
-
-            retStr = subfx_misc_doubleToString(tmpDouble);
-            if (!retStr)
+            for (int j = 0; j < 3; ++j)
             {
-                cleanUp;
-                return NULL;
-            }
-
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
+                coords[j << 1] = points[i + j].x * xscale;
+                coords[(j << 1) + 1] = points[i + j].y * yscale;
             }
 
+            res = ShapePath_append(ret, subfx_shapePath_curve, coords);
             i += 3;
             break;
         default: // invalid type (should never happen, but let us be safe)
@@ -923,20 +1000,13 @@ char *subfx_fontHandle_text_to_shape(subfx_fontHandle *handle,
 
         if ((cur_type & 0x1) == 1) // odd = PT_CLOSEFIGURE
         {
-            retStr = calloc(2, sizeof(char));
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
+            res = res || ShapePath_append(ret, subfx_shapePath_close, NULL);
+        }
 
-            memcpy(retStr, "c", 2);
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
+        if (res)
+        {
+            cleanUp;
+            return NULL;
         }
     } // end while (i < points_n)
 
@@ -944,412 +1014,262 @@ char *subfx_fontHandle_text_to_shape(subfx_fontHandle *handle,
     AbortPath(handle->dc);
     free(points);
     free(types);
-    if (!charWidths)
-    {
-        free(charWidths);
-    }
-#else
-    // Set text path to layout
-    cairo_save(handle->context);
-    cairo_scale(handle->context,
-                handle->downscale *
-                handle->xscale *
-                handle->fonthack_scale,
-                handle->downscale *
-                handle->yscale *
-                handle->fonthack_scale);
-    pango_layout_set_text(handle->layout, text, -1);
-    pango_cairo_layout_path(handle->context, handle->layout);
-    cairo_restore(handle->context);
+    free(charWidths);
 
-    // Convert path to shape
-    cairo_path_t *path(cairo_copy_path(handle->context));
+    return ret;
+}
+#else
+// the path of the context goes into out, the context's path is cleared
+static uint8_t copyPath(subfx_fontHandle *handle, subfx_shapePath *out)
+{
+    cairo_path_t *path = cairo_copy_path(handle->context);
+    cairo_new_path(handle->context);
     if (!path)
     {
-        return NULL;
-    }
-
-    if (path->status != CAIRO_STATUS_SUCCESS)
-    {
-        cairo_new_path(handle->context);
-        cairo_path_destroy(path);
-        return NULL;
-    }
-
-    fdsa_ptrVector *shape = fdsa->ptrVector->create(free);
-    if (!shape)
-    {
-        cairo_new_path(handle->context);
-        cairo_path_destroy(path);
-        return NULL;
+        return 1;
     }
 
-    // may be larger or smaller?
-    if (fdsa->ptrVector.reserve(shape, 2048) == fdsa_failed)
+    // every command takes at least 2 entries of data
+    if (path->status != CAIRO_STATUS_SUCCESS ||
+        ShapePath_init(out, (size_t)(path->num_data >> 1) + 1))
     {
-        cairo_new_path(handle->context);
         cairo_path_destroy(path);
-        return NULL;
+        return 1;
     }
 
-    int i = 0, cur_type = 0, last_type = 99999; // first loop has no last_type
-    double tmpValue = 0.;
+    int i = 0;
+    cairo_path_data_t *data;
+    double coords[6];
+    uint8_t res;
     while (i < path->num_data)
     {
-        cur_type = path->data[i].header.type;
-        switch (cur_type)
+        data = &path->data[i];
+        switch (data->header.type)
         {
         case CAIRO_PATH_MOVE_TO:
-            if (cur_type != last_type)
-            {
-                retStr = calloc(2, sizeof(char));
-                if (!retStr)
-                {
-                    cleanUp;
-                    return NULL;
-                }
-
-                memcpy(retStr, "m", 2);
-                if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-                {
-                    cleanUp;
-                    free(retStr);
-                    return NULL;
-                }
-            }
-
-            tmpValue =
-                    subfx_math_round(
-                        path->data[i + 1].point.x,
-                        FP_PRECISION);
-
-            retStr = subfx_misc_doubleToString(tmpValue);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
-
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
-
-            tmpValue =
-                    subfx_math_round(
-                    path->data[i + 1].point.y,
-                    FP_PRECISION);
-
-            retStr = subfx_misc_doubleToString(tmpValue);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
-
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
-
+            coords[0] = data[1].point.x;
+            coords[1] = data[1].point.y;
+            res = ShapePath_append(out, subfx_shapePath_move, coords);
             break;
         case CAIRO_PATH_LINE_TO:
-            if (cur_type != last_type)
-            {
-                retStr = calloc(2, sizeof(char));
-                if (!retStr)
-                {
-                    cleanUp;
-                    return NULL;
-                }
-
-                memcpy(retStr, "l", 2);
-                if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-                {
-                    cleanUp;
-                    free(retStr);
-                    return NULL;
-                }
-            }
-
-            tmpValue =
-                    subfx_math_round(
-                    path->data[i + 1].point.x,
-                    FP_PRECISION);
-
-            retStr = subfx_misc_doubleToString(tmpValue);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
-
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
-
-            tmpValue =
-                    subfx_math_round(
-                    path->data[i + 1].point.y,
-                    FP_PRECISION);
-
-            retStr = subfx_misc_doubleToString(tmpValue);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
-
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
-
+            coords[0] = data[1].point.x;
+            coords[1] = data[1].point.y;
+            res = ShapePath_append(out, subfx_shapePath_line, coords);
             break;
         case CAIRO_PATH_CURVE_TO:
-            if (cur_type != last_type)
-            {
-                retStr = calloc(2, sizeof(char));
-                if (!retStr)
-                {
-                    cleanUp;
-                    return NULL;
-                }
-
-                memcpy(retStr, "b", 2);
-                if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-                {
-                    cleanUp;
-                    free(retStr);
-                    return NULL;
-                }
-            }
-
-            tmpValue =
-                    subfx_math_round(
-                    path->data[i + 1].point.x,
-                    FP_PRECISION);
-
-            retStr = subfx_misc_doubleToString(tmpValue);
-            if (!retStr)
+            for (int j = 0; j < 3; ++j)
             {
-                cleanUp;
-                return NULL;
+                coords[j << 1] = data[j + 1].point.x;
+                coords[(j << 1) + 1] = data[j + 1].point.y;
             }
 
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
-
-            tmpValue =
-                    subfx_math_round(
-                    path->data[i + 1].point.y,
-                    FP_PRECISION);
+            res = ShapePath_append(out, subfx_shapePath_curve, coords);
+            break;
+        case CAIRO_PATH_CLOSE_PATH:
+            res = ShapePath_append(out, subfx_shapePath_close, NULL);
+            break;
+        default:
+            res = 0;
+            break;
+        }
 
-            retStr = subfx_misc_doubleToString(tmpValue);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
+        if (res)
+        {
+            ShapePath_fin(out);
+            cairo_path_destroy(path);
+            return 1;
+        }
 
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
+        i += data->header.length;
+    }
 
-            tmpValue =
-                    subfx_math_round(
-                    path->data[i + 2].point.x,
-                    FP_PRECISION);
+    cairo_path_destroy(path);
+    return 0;
+}
 
-            retStr = subfx_misc_doubleToString(tmpValue);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
+// outline of one glyph with its origin at 0, 0
+// the result is valid until the next call
+static const subfx_shapePath *glyphOutline(subfx_fontHandle *handle,
+                                           PangoFont *font,
+                                           PangoGlyph glyph)
+{
+    const subfx_shapePath *ret = GlyphCache_find(&handle->glyphs,
+                                                 font,
+                                                 glyph);
+    if (ret)
+    {
+        return ret;
+    }
 
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
+    handle->glyphString->glyphs[0].glyph = glyph;
 
-            tmpValue =
-                    subfx_math_round(
-                    path->data[i + 2].point.y,
-                    FP_PRECISION);
+    // no current point, so the origin is at 0, 0
+    cairo_new_path(handle->context);
+    cairo_save(handle->context);
+    cairo_scale(handle->context,
+                handle->downscale *
+                handle->xscale *
+                handle->fonthack_scale,
+                handle->downscale *
+                handle->yscale *
+                handle->fonthack_scale);
+    pango_cairo_glyph_string_path(handle->context, font, handle->glyphString);
+    cairo_restore(handle->context);
 
-            retStr = subfx_misc_doubleToString(tmpValue);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
+    subfx_shapePath outline;
+    if (copyPath(handle, &outline))
+    {
+        return NULL;
+    }
 
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
+    ret = GlyphCache_insert(&handle->glyphs, font, glyph, &outline);
+    if (ret)
+    {
+        // released by the cache along with the entry
+        g_object_ref(font);
+        return ret;
+    }
 
-            tmpValue =
-                    subfx_math_round(
-                    path->data[i + 3].point.x,
-                    FP_PRECISION);
+    // too large for the budget, keep it only until the next call
+    ShapePath_fin(&handle->glyphScratch);
+    handle->glyphScratch = outline;
+    return &handle->glyphScratch;
+}
 
-            retStr = subfx_misc_doubleToString(tmpValue);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
+/**
+ * Puts the path of text together from glyph outlines, the way
+ * pango_cairo_layout_path() places them.
+ * @return NULL if it can not, e.g. a glyph is missing from the font.
+ */
+static subfx_shapePath *glyphsToPath(subfx_fontHandle *handle,
+                                     const char *text)
+{
+    pango_layout_set_text(handle->layout, text, -1);
+    PangoLayoutIter *iter = pango_layout_get_iter(handle->layout);
+    if (!iter)
+    {
+        return NULL;
+    }
 
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
-            {
-                cleanUp;
-                free(retStr);
-                return NULL;
-            }
+    subfx_shapePath *ret = malloc(sizeof(subfx_shapePath));
+    if (!ret || ShapePath_init(ret, 0))
+    {
+        free(ret);
+        pango_layout_iter_free(iter);
+        return NULL;
+    }
 
-            tmpValue =
-                    subfx_math_round(
-                    path->data[i + 3].point.y,
-                    FP_PRECISION);
+    double xscale = handle->downscale * handle->xscale *
+                    handle->fonthack_scale / (double)PANGO_SCALE;
+    double yscale = handle->downscale * handle->yscale *
+                    handle->fonthack_scale / (double)PANGO_SCALE;
+    bool ok = true;
+    do
+    {
+        // NULL at the end of a line
+        PangoLayoutRun *run = pango_layout_iter_get_run_readonly(iter);
+        if (!run)
+        {
+            continue;
+        }
 
-            retStr = subfx_misc_doubleToString(tmpValue);
-            if (!retStr)
-            {
-                cleanUp;
-                return NULL;
-            }
+        PangoRectangle logical;
+        pango_layout_iter_get_run_extents(iter, NULL, &logical);
+        int baseline = pango_layout_iter_get_baseline(iter);
+        int x = logical.x;
+        PangoFont *font = run->item->analysis.font;
+        for (int i = 0; i < run->glyphs->num_glyphs; ++i)
+        {
+            PangoGlyphInfo *info = &run->glyphs->glyphs[i];
 
-            if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
+            // pango draws a hex box for these
+            if (info->glyph & PANGO_GLYPH_UNKNOWN_FLAG)
             {
-                cleanUp;
-                free(retStr);
-                return NULL;
+                ok = false;
+                break;
             }
 
-            break;
-        case CAIRO_PATH_CLOSE_PATH:
-            if (cur_type != last_type)
+            if (info->glyph != PANGO_GLYPH_EMPTY)
             {
-                retStr = calloc(2, sizeof(char));
-                if (!retStr)
-                {
-                    cleanUp;
-                    return NULL;
-                }
-
-                memcpy(retStr, "c", 2);
-                if (fdsa->ptrVector.pushBack(shape, retStr) == fdsa_failed)
+                const subfx_shapePath *outline = glyphOutline(handle,
+                                                              font,
+                                                              info->glyph);
+                if (!outline ||
+                    ShapePath_appendMoved(ret, outline,
+                                          (x + info->geometry.x_offset) *
+                                          xscale,
+                                          (baseline + info->geometry.y_offset) *
+                                          yscale))
                 {
-                    cleanUp;
-                    free(retStr);
-                    return NULL;
+                    ok = false;
+                    break;
                 }
             }
 
-            break;
-        default:
-            break;
+            x += info->geometry.width;
         }
+    } while (ok && pango_layout_iter_next_run(iter));
 
-        last_type = cur_type;
-        i += path->data[i].header.length;
+    pango_layout_iter_free(iter);
+    if (!ok)
+    {
+        subfx_fontHandle_destroyPath(ret);
+        return NULL;
     }
 
-    cairo_new_path(handle->context);
-    cairo_path_destroy(path);
-#endif
+    return ret;
+}
 
-    // calculate how many buffer we need
-    if (fdsa->ptrVector.size(shape, &retSize) == fdsa_failed)
+subfx_shapePath *subfx_fontHandle_text_to_path(subfx_fontHandle *handle,
+                                               const char *text,
+                                               char *errMsg)
+{
+    if (!handle || !text)
     {
-        subfx_pError(errMsg, "text_to_shape: you should"
-                             " never see this message.");
-        fdsa->ptrVector.destory(shape);
+        subfx_pError(errMsg, "text_to_path: invalid input");
         return NULL;
     }
 
-    size_t length = 0;
-    for (size_t index = 0; index < retSize; ++index)
+    subfx_shapePath *ret;
+
+    // decorations are drawn by the layout, not by the glyphs
+    if ((handle->cacheMode & subfx_fonthandle_cache_glyphs) &&
+        handle->glyphs.budget && !handle->decorated)
     {
-        retStr = fdsa->ptrVector.at(shape, index);
-        if (!retStr)
+        ret = glyphsToPath(handle, text);
+        if (ret)
         {
-            subfx_pError(errMsg, "text_to_shape: you should"
-                                 " never see this message.");
-            fdsa->ptrVector.destory(shape);
-            return NULL;
+            return ret;
         }
-
-        length += strlen(retStr);
     }
 
-    length += (retSize + 1); // for ' ' and '\0'
+    // Set text path to layout
+    cairo_save(handle->context);
+    cairo_scale(handle->context,
+                handle->downscale *
+                handle->xscale *
+                handle->fonthack_scale,
+                handle->downscale *
+                handle->yscale *
+                handle->fonthack_scale);
+    pango_layout_set_text(handle->layout, text, -1);
+    pango_cairo_layout_path(handle->context, handle->layout);
+    cairo_restore(handle->context);
 
-    retStr = calloc(length, sizeof(char));
-    if (!retStr)
+    // Convert path to shape
+    ret = malloc(sizeof(subfx_shapePath));
+    if (!ret)
     {
-        if (fdsa->ptrVector.destory(shape) == fdsa_failed)
-        {
-            subfx_pError(errMsg, "text_to_shape: you should"
-                                 " never see this message.");
-        }
-
+        cairo_new_path(handle->context);
         return NULL;
     }
 
-    char *pStr = retStr;
-    char *tmpStr = NULL;
-    for (size_t index = 0; index < retSize; ++index)
-    {
-        tmpStr = fdsa->ptrVector.at(shape, index);
-        if (!tmpStr)
-        {
-            free(retStr);
-            subfx_pError(errMsg, "text_to_shape: you should"
-                                 " never see this message.");
-            fdsa->ptrVector.destory(shape);
-            return NULL;
-        }
-
-        length = strlen(tmpStr);
-        memcpy(pStr, tmpStr, length);
-        pStr += length;
-
-        memcpy(pStr, " ", 1);
-        ++pStr;
-    }
-
-    pStr[0] = '\0';
-
-    if (fdsa->ptrVector.destory(shape) == fdsa_failed)
+    if (copyPath(handle, ret))
     {
-        subfx_pError(errMsg, "text_to_shape: you should"
-                             " never see this message.");
-        free(retStr);
+        free(ret);
         return NULL;
     }
 
-    return retStr;
+    return ret;
 }
+#endif
@@ -46,9 +46,44 @@ double *subfx_fontHandle_metrics(subfx_fontHandle *);
 double *subfx_fontHandle_text_extents(subfx_fontHandle *fontHandle,
                                       const char *text);
 
+subfx_exitstate subfx_fontHandle_text_extents2(subfx_fontHandle *fontHandle,
+                                               const char *text,
+                                               size_t textLen,
+                                               double *out);
+
+subfx_exitstate subfx_fontHandle_setCacheMode(subfx_fontHandle *fontHandle,
+                                              uint8_t mode);
+
+subfx_exitstate subfx_fontHandle_cacheStats(subfx_fontHandle *fontHandle,
+                                            size_t *hits,
+                                            size_t *misses);
+
+subfx_exitstate
+subfx_fontHandle_setGlyphCacheBudget(subfx_fontHandle *fontHandle,
+                                     size_t bytes);
+
+subfx_exitstate subfx_fontHandle_glyphCacheStats(subfx_fontHandle *fontHandle,
+                                                 size_t *hits,
+                                                 size_t *misses);
+
 char *subfx_fontHandle_text_to_shape(subfx_fontHandle *fontHandle,
                                      const char *text, char *errMsg);
 
+char *subfx_fontHandle_text_to_shape2(subfx_fontHandle *fontHandle,
+                                      const char *text,
+                                      size_t *len,
+                                      char *errMsg);
+
+subfx_shapePath *subfx_fontHandle_text_to_path(subfx_fontHandle *fontHandle,
+                                               const char *text,
+                                               char *errMsg);
+
+char *subfx_fontHandle_path_to_shape(const subfx_shapePath *path,
+                                     size_t *len,
+                                     char *errMsg);
+
+subfx_exitstate subfx_fontHandle_destroyPath(subfx_shapePath *path);
+
 #ifdef __cplusplus
 }
 #endif
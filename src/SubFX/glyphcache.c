@@ -0,0 +1,228 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "glyphcache.h"
+#include "shapepath.h"
+
+#define INITIAL_BUCKETS 256
+
+static size_t bucketOf(const void *font, uint32_t glyph, size_t bucketCount)
+{
+    uint64_t hash = (uint64_t)(uintptr_t)font ^
+                    ((uint64_t)glyph * 0x9E3779B97F4A7C15ULL);
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 32;
+    return (size_t)hash & (bucketCount - 1);
+}
+
+static void unlinkEntry(GlyphCache *in, GlyphCacheEntry *entry)
+{
+    if (entry->prev) entry->prev->next = entry->next;
+    else in->head = entry->next;
+
+    if (entry->next) entry->next->prev = entry->prev;
+    else in->tail = entry->prev;
+
+    entry->prev = NULL;
+    entry->next = NULL;
+}
+
+static void pushFront(GlyphCache *in, GlyphCacheEntry *entry)
+{
+    entry->prev = NULL;
+    entry->next = in->head;
+    if (in->head) in->head->prev = entry;
+    else in->tail = entry;
+
+    in->head = entry;
+}
+
+static void dropEntry(GlyphCache *in, GlyphCacheEntry *entry)
+{
+    GlyphCacheEntry **slot = &in->buckets[bucketOf(entry->font,
+                                                   entry->glyph,
+                                                   in->bucketCount)];
+    while (*slot != entry)
+    {
+        slot = &(*slot)->chain;
+    }
+
+    *slot = entry->chain;
+    unlinkEntry(in, entry);
+
+    in->bytes -= entry->bytes;
+    --in->size;
+    if (in->releaseFont) in->releaseFont(entry->font);
+
+    ShapePath_fin(&entry->path);
+    free(entry);
+}
+
+static void evict(GlyphCache *in, size_t budget)
+{
+    while (in->tail && in->bytes > budget)
+    {
+        dropEntry(in, in->tail);
+    }
+}
+
+// on failure the table simply stays crowded
+static void grow(GlyphCache *in)
+{
+    size_t bucketCount = in->bucketCount << 1;
+    GlyphCacheEntry **buckets = calloc(bucketCount, sizeof(GlyphCacheEntry *));
+    if (!buckets)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < in->bucketCount; ++i)
+    {
+        GlyphCacheEntry *entry = in->buckets[i];
+        while (entry)
+        {
+            GlyphCacheEntry *next = entry->chain;
+            size_t index = bucketOf(entry->font, entry->glyph, bucketCount);
+            entry->chain = buckets[index];
+            buckets[index] = entry;
+            entry = next;
+        }
+    }
+
+    free(in->buckets);
+    in->buckets = buckets;
+    in->bucketCount = bucketCount;
+}
+
+uint8_t GlyphCache_init(GlyphCache *in,
+                        size_t budget,
+                        void (*releaseFont)(const void *))
+{
+    if (!in) return 1;
+
+    memset(in, 0, sizeof(GlyphCache));
+    in->buckets = calloc(INITIAL_BUCKETS, sizeof(GlyphCacheEntry *));
+    if (!in->buckets)
+    {
+        return 1;
+    }
+
+    in->bucketCount = INITIAL_BUCKETS;
+    in->budget = budget;
+    in->releaseFont = releaseFont;
+    return 0;
+}
+
+void GlyphCache_fin(GlyphCache *in)
+{
+    if (!in) return;
+
+    if (in->buckets)
+    {
+        evict(in, 0);
+    }
+
+    free(in->buckets);
+    memset(in, 0, sizeof(GlyphCache));
+}
+
+void GlyphCache_setBudget(GlyphCache *in, size_t budget)
+{
+    if (!in) return;
+
+    in->budget = budget;
+    evict(in, budget);
+}
+
+const subfx_shapePath *GlyphCache_find(GlyphCache *in,
+                                       const void *font,
+                                       uint32_t glyph)
+{
+    if (!in) return NULL;
+
+    GlyphCacheEntry *entry = in->buckets[bucketOf(font,
+                                                  glyph,
+                                                  in->bucketCount)];
+    while (entry)
+    {
+        if (entry->font == font && entry->glyph == glyph)
+        {
+            if (entry != in->head)
+            {
+                unlinkEntry(in, entry);
+                pushFront(in, entry);
+            }
+
+            ++in->hits;
+            return &entry->path;
+        }
+
+        entry = entry->chain;
+    }
+
+    ++in->misses;
+    return NULL;
+}
+
+const subfx_shapePath *GlyphCache_insert(GlyphCache *in,
+                                         const void *font,
+                                         uint32_t glyph,
+                                         subfx_shapePath *path)
+{
+    if (!in || !path) return NULL;
+
+    size_t bytes = sizeof(GlyphCacheEntry) +
+                   path->opCapacity +
+                   path->coordCapacity * sizeof(double);
+    if (bytes > in->budget)
+    {
+        return NULL;
+    }
+
+    GlyphCacheEntry *entry = malloc(sizeof(GlyphCacheEntry));
+    if (!entry)
+    {
+        return NULL;
+    }
+
+    evict(in, in->budget - bytes);
+    if (in->size >= in->bucketCount)
+    {
+        grow(in);
+    }
+
+    entry->font = font;
+    entry->glyph = glyph;
+    entry->path = *path;
+    entry->bytes = bytes;
+    memset(path, 0, sizeof(subfx_shapePath));
+
+    size_t index = bucketOf(font, glyph, in->bucketCount);
+    entry->chain = in->buckets[index];
+    in->buckets[index] = entry;
+    pushFront(in, entry);
+
+    in->bytes += bytes;
+    ++in->size;
+    return &entry->path;
+}
@@ -0,0 +1,111 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "include/internal/shapepath.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Keeps the outline of every glyph once, keyed by (font, glyph id).
+ * The font is only compared by address, releaseFont() is called for every
+ * dropped entry, so the owner can hold one reference to the font per entry
+ * and its address can not be reused meanwhile.
+ * When the outlines take more than budget bytes, the least recently used
+ * ones are dropped.
+ */
+typedef struct GlyphCacheEntry
+{
+    const void *font;
+
+    uint32_t glyph;
+
+    subfx_shapePath path;
+
+    // what this entry costs against the budget
+    size_t bytes;
+
+    // next entry in the same bucket
+    struct GlyphCacheEntry *chain;
+
+    // LRU list, head is the most recently used
+    struct GlyphCacheEntry *prev;
+
+    struct GlyphCacheEntry *next;
+} GlyphCacheEntry;
+
+typedef struct GlyphCache
+{
+    GlyphCacheEntry **buckets;
+
+    // always a power of 2
+    size_t bucketCount;
+
+    size_t size;
+
+    GlyphCacheEntry *head;
+
+    GlyphCacheEntry *tail;
+
+    size_t bytes;
+
+    size_t budget;
+
+    // can be NULL
+    void (*releaseFont)(const void *);
+
+    size_t hits;
+
+    size_t misses;
+} GlyphCache;
+
+uint8_t GlyphCache_init(GlyphCache *,
+                        size_t budget,
+                        void (*releaseFont)(const void *));
+
+void GlyphCache_fin(GlyphCache *);
+
+// drops entries until they fit, 0 drops all of them
+void GlyphCache_setBudget(GlyphCache *, size_t budget);
+
+// @return NULL if the glyph is not in the cache.
+const subfx_shapePath *GlyphCache_find(GlyphCache *,
+                                       const void *font,
+                                       uint32_t glyph);
+
+/**
+ * Takes over path, which is then empty.
+ * @return NULL if the outline does not fit the budget, path is left
+ * untouched in this case.
+ */
+const subfx_shapePath *GlyphCache_insert(GlyphCache *,
+                                         const void *font,
+                                         uint32_t glyph,
+                                         subfx_shapePath *path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -31,6 +31,7 @@
 #include "utf8.h"
 
 #include "ass.h"
+#include "assparser.h"
 #include "fonthandle.h"
 
 SUBFX_API subfx_exitstate SubFX_init(SubFX *ret)
@@ -65,6 +66,11 @@ SUBFX_API subfx_exitstate SubFX_init(SubFX *ret)
         return subfx_failed;
     }
 
+    if (subfx_assParser_init(&ret->assParser) == subfx_failed)
+    {
+        return subfx_failed;
+    }
+
     if (subfx_fontHandle_init(&ret->fontHandle) == subfx_failed)
     {
         return subfx_failed;
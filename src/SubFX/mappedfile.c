@@ -0,0 +1,304 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "mappedfile.h"
+
+static const char emptyFile[1] = {'\0'};
+
+// The tail of the last page of a mapping is zero-filled by the OS,
+// so a mapping only has a readable '\0' behind the data
+// if the size is not a multiple of the page size.
+static size_t getPageSize()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (size_t)info.dwPageSize;
+#else
+    long ret = sysconf(_SC_PAGESIZE);
+    return ret > 0 ? (size_t)ret : 4096;
+#endif
+}
+
+#ifdef _WIN32
+static uint8_t readWholeFile(MappedFile *in)
+{
+    char *buf = malloc(in->size + 1);
+    if (!buf)
+    {
+        return 1;
+    }
+
+    size_t total = 0;
+    DWORD got;
+    while (total < in->size)
+    {
+        DWORD toRead = (in->size - total) > 0x40000000 ?
+                    0x40000000 : (DWORD)(in->size - total);
+        if (!ReadFile(in->file, buf + total, toRead, &got, NULL) || !got)
+        {
+            free(buf);
+            return 1;
+        }
+
+        total += got;
+    }
+
+    buf[in->size] = '\0';
+    in->data = buf;
+    in->isMapped = false;
+    return 0;
+}
+
+uint8_t MappedFile_init(MappedFile *in, const char *fileName)
+{
+    if (!in || !fileName) return 1;
+
+    memset(in, 0, sizeof(MappedFile));
+    in->file = CreateFileA(fileName,
+                           GENERIC_READ,
+                           FILE_SHARE_READ,
+                           NULL,
+                           OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                           NULL);
+    if (in->file == INVALID_HANDLE_VALUE)
+    {
+        in->file = NULL;
+        return 1;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(in->file, &fileSize))
+    {
+        MappedFile_fin(in);
+        return 1;
+    }
+
+    in->size = (size_t)fileSize.QuadPart;
+    if (!in->size)
+    {
+        in->data = emptyFile;
+        return 0;
+    }
+
+    if (!(in->size % getPageSize()))
+    {
+        if (readWholeFile(in))
+        {
+            MappedFile_fin(in);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    in->mapping = CreateFileMappingA(in->file, NULL, PAGE_READONLY,
+                                     0, 0, NULL);
+    if (!in->mapping)
+    {
+        MappedFile_fin(in);
+        return 1;
+    }
+
+    in->data = MapViewOfFile(in->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!in->data)
+    {
+        MappedFile_fin(in);
+        return 1;
+    }
+
+    in->isMapped = true;
+    return 0;
+}
+
+void MappedFile_fin(MappedFile *in)
+{
+    if (!in) return;
+
+    if (in->data && in->data != emptyFile)
+    {
+        if (in->isMapped)
+        {
+            UnmapViewOfFile(in->data);
+        }
+        else
+        {
+            free((void *)in->data);
+        }
+    }
+
+    if (in->mapping) CloseHandle(in->mapping);
+    if (in->file) CloseHandle(in->file);
+
+    memset(in, 0, sizeof(MappedFile));
+}
+#else
+static uint8_t readWholeFile(MappedFile *in)
+{
+    char *buf = malloc(in->size + 1);
+    if (!buf)
+    {
+        return 1;
+    }
+
+    size_t total = 0;
+    ssize_t got;
+    while (total < in->size)
+    {
+        got = read(in->fd, buf + total, in->size - total);
+        if (got <= 0)
+        {
+            free(buf);
+            return 1;
+        }
+
+        total += (size_t)got;
+    }
+
+    buf[in->size] = '\0';
+    in->data = buf;
+    in->isMapped = false;
+    return 0;
+}
+
+uint8_t MappedFile_init(MappedFile *in, const char *fileName)
+{
+    if (!in || !fileName) return 1;
+
+    memset(in, 0, sizeof(MappedFile));
+    in->fd = open(fileName, O_RDONLY);
+    if (in->fd < 0)
+    {
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(in->fd, &st) || !S_ISREG(st.st_mode))
+    {
+        MappedFile_fin(in);
+        return 1;
+    }
+
+    in->size = (size_t)st.st_size;
+    if (!in->size)
+    {
+        in->data = emptyFile;
+        return 0;
+    }
+
+    if (!(in->size % getPageSize()))
+    {
+        if (readWholeFile(in))
+        {
+            MappedFile_fin(in);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    void *data = mmap(NULL, in->size, PROT_READ, MAP_PRIVATE, in->fd, 0);
+    if (data == MAP_FAILED)
+    {
+        // e.g. the file system does not support mmap
+        if (readWholeFile(in))
+        {
+            MappedFile_fin(in);
+            return 1;
+        }
+
+        return 0;
+    }
+
+#ifdef MADV_SEQUENTIAL
+    madvise(data, in->size, MADV_SEQUENTIAL);
+#endif
+
+    in->data = data;
+    in->isMapped = true;
+    return 0;
+}
+
+void MappedFile_fin(MappedFile *in)
+{
+    if (!in) return;
+
+    if (in->data && in->data != emptyFile)
+    {
+        if (in->isMapped)
+        {
+            munmap((void *)in->data, in->size);
+        }
+        else
+        {
+            free((void *)in->data);
+        }
+    }
+
+    if (in->fd > 0) close(in->fd);
+
+    memset(in, 0, sizeof(MappedFile));
+}
+#endif
+
+bool MappedFile_nextLine(const MappedFile *in,
+                         size_t *offset,
+                         const char **line,
+                         size_t *lineLen)
+{
+    if (!in || !offset || !line || !lineLen) return false;
+    if (*offset >= in->size) return false;
+
+    const char *begin = in->data + *offset;
+    size_t remain = in->size - *offset;
+    const char *end = memchr(begin, '\n', remain);
+    size_t len;
+    if (end)
+    {
+        len = (size_t)(end - begin);
+        *offset += (len + 1);
+    }
+    else
+    {
+        len = remain;
+        *offset = in->size;
+    }
+
+    // note that "newline" just have two situations
+    // crlf(\r\n) or lf(\n)
+    if (len && begin[len - 1] == '\r')
+    {
+        --len;
+    }
+
+    *line = begin;
+    *lineLen = len;
+    return true;
+}
@@ -0,0 +1,75 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+#include "windows.h"
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * A read-only view of a whole file.
+ * The file is memory-mapped when possible, otherwise it is read into
+ * a heap buffer. In both cases data[size] is readable and is '\0',
+ * so the last line of the file can be handed to C string functions.
+ */
+typedef struct MappedFile
+{
+    const char *data;
+
+    size_t size;
+
+    bool isMapped;
+
+#ifdef _WIN32
+    HANDLE file;
+
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+} MappedFile;
+
+uint8_t MappedFile_init(MappedFile *, const char *fileName);
+
+void MappedFile_fin(MappedFile *);
+
+/**
+ * Gets the next line starting at *offset without copying it.
+ * The line terminator ("\n" or "\r\n") is not included in *lineLen.
+ * On return, *offset points to the beginning of the next line.
+ * @return false if there is no more line.
+ */
+bool MappedFile_nextLine(const MappedFile *,
+                         size_t *offset,
+                         const char **line,
+                         size_t *lineLen);
+
+#ifdef __cplusplus
+}
+#endif
@@ -17,12 +17,17 @@
 *    <http://www.gnu.org/licenses/>.
 */
 
+#include <inttypes.h>
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "misc.h"
 #include "common.h"
 
+// every integer below 2^53 is exact in double
+#define FIXED3_LIMIT 9007199254740.
+
 subfx_exitstate subfx_misc_init(subfx_misc_api *misc)
 {
     if (!misc)
@@ -31,22 +36,176 @@ subfx_exitstate subfx_misc_init(subfx_misc_api *misc)
     }
 
     misc->doubleToString = subfx_misc_doubleToString;
+    misc->doubleToString2 = subfx_misc_doubleToString2;
+    misc->doublesToString = subfx_misc_doublesToString;
     misc->getLine = subfx_misc_getLine;
 
     return subfx_success;
 }
 
+size_t subfx_misc_fixed3(double input, char *buffer)
+{
+    // NaN, infinities and huge numbers
+    if (!(fabs(input) < FIXED3_LIMIT))
+    {
+        return 0;
+    }
+
+    // both parts are exact, only the scaled fraction is rounded
+    double absValue = fabs(input);
+    double integer = floor(absValue);
+    uint64_t number = (uint64_t)integer;
+    double scaled = (absValue - integer) * 1000.;
+    double rounded = floor(scaled);
+    double half = scaled - rounded;
+    if (half == .5)
+    {
+        // the product may be rounded onto the tie, the residual tells
+        // which side the exact value is on, a real tie goes to even
+        double residual = fma(absValue - integer, 1000., -scaled);
+        if (residual > 0. ||
+            (residual == 0. && fmod(rounded, 2.) != 0.))
+        {
+            rounded += 1.;
+        }
+    }
+    else if (half > .5)
+    {
+        rounded += 1.;
+    }
+
+    uint32_t fraction = (uint32_t)rounded;
+    if (fraction == 1000)
+    {
+        fraction = 0;
+        ++number;
+    }
+
+    char tmp[subfx_misc_fixed3Size];
+    char *p = tmp + sizeof(tmp);
+    int i;
+    for (i = 0; i < 3; ++i)
+    {
+        *--p = (char)('0' + (fraction % 10));
+        fraction /= 10;
+    }
+
+    *--p = '.';
+    do
+    {
+        *--p = (char)('0' + (number % 10));
+        number /= 10;
+    } while (number);
+
+    // printf keeps the sign of -0.0001 and -0.0
+    if (signbit(input))
+    {
+        *--p = '-';
+    }
+
+    size_t len = (size_t)(tmp + sizeof(tmp) - p);
+    memcpy(buffer, p, len);
+    buffer[len] = '\0';
+    return len;
+}
+
 char *subfx_misc_doubleToString(double input)
 {
-    double *buffer = calloc(500, sizeof(double));
+    // callers may reuse it as a line buffer, so it keeps its old size
+    char *buffer = malloc(500 * sizeof(double));
     if (!buffer)
     {
         return NULL;
     }
 
-    sprintf((char *)(buffer), "%.3lf", input);
+    if (!subfx_misc_doubleToString2(input, buffer, 500 * sizeof(double)))
+    {
+        free(buffer);
+        return NULL;
+    }
+
+    return buffer;
+}
+
+size_t subfx_misc_doubleToString2(double input,
+                                  char *buffer,
+                                  size_t bufferSize)
+{
+    if (!buffer || !bufferSize)
+    {
+        return 0;
+    }
+
+    size_t len;
+    if (bufferSize >= subfx_misc_fixed3Size)
+    {
+        len = subfx_misc_fixed3(input, buffer);
+    }
+    else
+    {
+        char tmp[subfx_misc_fixed3Size];
+        len = subfx_misc_fixed3(input, tmp);
+        if (len >= bufferSize)
+        {
+            return 0;
+        }
+
+        if (len) memcpy(buffer, tmp, len + 1);
+    }
+
+    if (len)
+    {
+        return len;
+    }
+
+    int res = snprintf(NULL, 0, "%.3f", input);
+    if (res < 0 || (size_t)res >= bufferSize)
+    {
+        return 0;
+    }
+
+    snprintf(buffer, bufferSize, "%.3f", input);
+    return (size_t)res;
+}
+
+size_t subfx_misc_doublesToString(const double *input,
+                                  size_t count,
+                                  char *buffer,
+                                  size_t bufferSize)
+{
+    if (!buffer || !bufferSize || (count && !input))
+    {
+        return 0;
+    }
+
+    buffer[0] = '\0';
+    size_t len = 0, res;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i)
+        {
+            if (len + 1 >= bufferSize)
+            {
+                buffer[0] = '\0';
+                return 0;
+            }
+
+            buffer[len++] = ' ';
+        }
+
+        res = subfx_misc_doubleToString2(input[i],
+                                         buffer + len,
+                                         bufferSize - len);
+        if (!res)
+        {
+            buffer[0] = '\0';
+            return 0;
+        }
+
+        len += res;
+    }
 
-    return (char *)(buffer);
+    return len;
 }
 
 subfx_exitstate
@@ -33,6 +33,28 @@ subfx_exitstate subfx_misc_init(subfx_misc_api *);
 
 char *subfx_misc_doubleToString(double input);
 
+size_t subfx_misc_doubleToString2(double input,
+                                  char *buffer,
+                                  size_t bufferSize);
+
+size_t subfx_misc_doublesToString(const double *input,
+                                  size_t count,
+                                  char *buffer,
+                                  size_t bufferSize);
+
+// bytes subfx_misc_fixed3() may write, with the '\0'
+#define subfx_misc_fixed3Size 24
+
+/**
+ * Writes input as "%.3f" would, but with integer math.
+ * The result is the same as printf for any number that is already
+ * rounded to 3 decimals, e.g. by subfx_math_round(x, FP_PRECISION).
+ * @param buffer at least subfx_misc_fixed3Size bytes.
+ * @return the length without '\0', or 0 for NaN, infinities and numbers
+ * of 2^53 / 1000 or more, which are left to printf.
+ */
+size_t subfx_misc_fixed3(double input, char *buffer);
+
 subfx_exitstate
 subfx_misc_getLine(char *buffer,
                    size_t bufferSize,
@@ -17,6 +17,8 @@
 *    <http://www.gnu.org/licenses/>.
 */
 
+#include <string.h>
+
 #include "mutex.h"
 
 uint8_t Mutex_init(Mutex *in)
@@ -45,14 +47,14 @@ uint8_t Mutex_init(Mutex *in)
 void Mutex_fin(Mutex *in)
 {
     if (!in) return;
+#ifdef _WIN32
     if (in->handle)
     {
-#ifdef _WIN32
         CloseHandle(in->handle);
+    }
 #else
-        pthread_mutex_destroy(&in->handle);
+    pthread_mutex_destroy(&in->handle);
 #endif
-    }
 
     memset(in, 0, sizeof(Mutex));
 }
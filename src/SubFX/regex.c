@@ -101,6 +101,19 @@ void RegexData_fin(Regex *in)
 bool RegexData_match(Regex *data,
                      const char *in,
                      int *ret)
+{
+    if (!in)
+    {
+        return false;
+    }
+
+    return RegexData_matchLen(data, in, strlen(in), ret);
+}
+
+bool RegexData_matchLen(Regex *data,
+                        const char *in,
+                        size_t inLen,
+                        int *ret)
 {
     if (!data || !in || !ret)
     {
@@ -109,7 +122,7 @@ bool RegexData_match(Regex *data,
 
     *ret = pcre2_jit_match(data->regex,
                            (const unsigned char *)in,
-                           strlen(in),
+                           inLen,
                            0,
                            0,
                            data->matchData,
@@ -135,3 +148,29 @@ bool RegexData_match(Regex *data,
     return true;
 }
 
+
+bool RegexData_group(Regex *data,
+                     uint32_t index,
+                     size_t *offset,
+                     size_t *len)
+{
+    if (!data || !offset || !len)
+    {
+        return false;
+    }
+
+    if (index >= pcre2_get_ovector_count(data->matchData))
+    {
+        return false;
+    }
+
+    PCRE2_SIZE *ovector = pcre2_get_ovector_pointer(data->matchData);
+    if (ovector[index << 1] == PCRE2_UNSET)
+    {
+        return false;
+    }
+
+    *offset = ovector[index << 1];
+    *len = ovector[(index << 1) + 1] - ovector[index << 1];
+    return true;
+}
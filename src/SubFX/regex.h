@@ -43,6 +43,16 @@ void RegexData_fin(Regex *);
 
 bool RegexData_match(Regex *, const char *, int *);
 
+// same as RegexData_match, but the subject does not need to be '\0' terminated
+bool RegexData_matchLen(Regex *, const char *, size_t, int *);
+
+/**
+ * Gets the position of a captured group of the last successful match,
+ * index 0 is the whole match.
+ * @return false if the group is not set.
+ */
+bool RegexData_group(Regex *, uint32_t index, size_t *offset, size_t *len);
+
 #ifdef __cplusplus
 }
 #endif
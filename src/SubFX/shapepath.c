@@ -0,0 +1,211 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "shapepath.h"
+#include "smath.h"
+
+static const uint8_t pointCount[] = {1, 1, 3, 0};
+
+static const char commands[] = {'m', 'l', 'b', 'c'};
+
+static uint8_t reserve(subfx_shapePath *in, size_t moreOps, size_t moreCoords)
+{
+    if (in->opCount + moreOps > in->opCapacity)
+    {
+        size_t capacity = in->opCapacity ? in->opCapacity : 64;
+        while (capacity < in->opCount + moreOps)
+        {
+            capacity <<= 1;
+        }
+
+        uint8_t *ops = realloc(in->ops, capacity);
+        if (!ops)
+        {
+            return 1;
+        }
+
+        in->ops = ops;
+        in->opCapacity = capacity;
+    }
+
+    if (in->coordCount + moreCoords > in->coordCapacity)
+    {
+        size_t capacity = in->coordCapacity ? in->coordCapacity : 384;
+        while (capacity < in->coordCount + moreCoords)
+        {
+            capacity <<= 1;
+        }
+
+        double *coords = realloc(in->coords, capacity * sizeof(double));
+        if (!coords)
+        {
+            return 1;
+        }
+
+        in->coords = coords;
+        in->coordCapacity = capacity;
+    }
+
+    return 0;
+}
+
+uint8_t ShapePath_init(subfx_shapePath *in, size_t opCapacity)
+{
+    if (!in) return 1;
+
+    memset(in, 0, sizeof(subfx_shapePath));
+    if (!opCapacity)
+    {
+        return 0;
+    }
+
+    // glyph outlines are mostly curves
+    in->ops = malloc(opCapacity);
+    in->coords = malloc(opCapacity * 6 * sizeof(double));
+    if (!in->ops || !in->coords)
+    {
+        ShapePath_fin(in);
+        return 1;
+    }
+
+    in->opCapacity = opCapacity;
+    in->coordCapacity = opCapacity * 6;
+    return 0;
+}
+
+void ShapePath_fin(subfx_shapePath *in)
+{
+    if (!in) return;
+
+    free(in->ops);
+    free(in->coords);
+    memset(in, 0, sizeof(subfx_shapePath));
+}
+
+uint8_t ShapePath_append(subfx_shapePath *in,
+                         uint8_t op,
+                         const double *points)
+{
+    if (!in || op > subfx_shapePath_close) return 1;
+
+    size_t count = (size_t)pointCount[op] << 1;
+    if (count && !points) return 1;
+
+    if (reserve(in, 1, count))
+    {
+        return 1;
+    }
+
+    in->ops[in->opCount++] = op;
+    if (count)
+    {
+        memcpy(in->coords + in->coordCount, points, count * sizeof(double));
+        in->coordCount += count;
+    }
+
+    return 0;
+}
+
+uint8_t ShapePath_appendMoved(subfx_shapePath *in,
+                              const subfx_shapePath *src,
+                              double x,
+                              double y)
+{
+    if (!in || !src) return 1;
+
+    if (reserve(in, src->opCount, src->coordCount))
+    {
+        return 1;
+    }
+
+    if (src->opCount)
+    {
+        memcpy(in->ops + in->opCount, src->ops, src->opCount);
+        in->opCount += src->opCount;
+    }
+
+    double *coords = in->coords + in->coordCount;
+    for (size_t i = 0; i + 1 < src->coordCount; i += 2)
+    {
+        coords[i] = src->coords[i] + x;
+        coords[i + 1] = src->coords[i + 1] + y;
+    }
+
+    in->coordCount += src->coordCount;
+    return 0;
+}
+
+uint8_t ShapePath_toShape(const subfx_shapePath *in, StrBuf *buf)
+{
+    if (!in || !buf) return 1;
+
+    // about 16 bytes per point, so it seldom grows
+    if (StrBuf_reserve(buf, (in->coordCount << 3) + (in->opCount << 1)))
+    {
+        return 1;
+    }
+
+    const double *coords = in->coords;
+    const double *end = in->coords + in->coordCount;
+    uint8_t last = 0xff; // first command has no last one
+    for (size_t i = 0; i < in->opCount; ++i)
+    {
+        uint8_t op = in->ops[i];
+        if (op > subfx_shapePath_close)
+        {
+            return 1;
+        }
+
+        if (op != last)
+        {
+            char tmp[2] = {commands[op], ' '};
+            if (StrBuf_append(buf, tmp, 2))
+            {
+                return 1;
+            }
+
+            last = op;
+        }
+
+        size_t count = (size_t)pointCount[op] << 1;
+        if (count > (size_t)(end - coords))
+        {
+            return 1;
+        }
+
+        for (size_t j = 0; j < count; ++j)
+        {
+            if (StrBuf_appendFixed3(buf,
+                                    subfx_math_round(coords[j],
+                                                     FP_PRECISION)) ||
+                StrBuf_appendChar(buf, ' '))
+            {
+                return 1;
+            }
+        }
+
+        coords += count;
+    }
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "include/internal/shapepath.h"
+
+#include "strbuf.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+uint8_t ShapePath_init(subfx_shapePath *, size_t opCapacity);
+
+void ShapePath_fin(subfx_shapePath *);
+
+/**
+ * Appends one command.
+ * @param points x, y pairs, as many as the command has, can be NULL for
+ * subfx_shapePath_close.
+ */
+uint8_t ShapePath_append(subfx_shapePath *,
+                         uint8_t op,
+                         const double *points);
+
+// Appends all commands of src, every point shifted by x, y.
+uint8_t ShapePath_appendMoved(subfx_shapePath *,
+                              const subfx_shapePath *src,
+                              double x,
+                              double y);
+
+/**
+ * Writes the path as an ASS shape, every number is rounded to
+ * FP_PRECISION and followed by a space, and a command is only written
+ * when it differs from the previous one.
+ */
+uint8_t ShapePath_toShape(const subfx_shapePath *, StrBuf *);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,129 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "misc.h"
+#include "strbuf.h"
+
+uint8_t StrBuf_init(StrBuf *in, size_t capacity)
+{
+    if (!in) return 1;
+
+    memset(in, 0, sizeof(StrBuf));
+    return capacity ? StrBuf_reserve(in, capacity) : 0;
+}
+
+void StrBuf_fin(StrBuf *in)
+{
+    if (!in) return;
+
+    free(in->data);
+    memset(in, 0, sizeof(StrBuf));
+}
+
+uint8_t StrBuf_reserve(StrBuf *in, size_t more)
+{
+    if (!in) return 1;
+
+    size_t needed = in->size + more + 1;
+    if (needed <= in->capacity)
+    {
+        return 0;
+    }
+
+    size_t capacity = in->capacity ? in->capacity : 64;
+    while (capacity < needed)
+    {
+        capacity <<= 1;
+    }
+
+    char *data = realloc(in->data, capacity);
+    if (!data)
+    {
+        return 1;
+    }
+
+    in->data = data;
+    in->data[in->size] = '\0';
+    in->capacity = capacity;
+    return 0;
+}
+
+uint8_t StrBuf_append(StrBuf *in, const char *str, size_t len)
+{
+    if (!in || !str) return 1;
+    if (StrBuf_reserve(in, len)) return 1;
+
+    memcpy(in->data + in->size, str, len);
+    in->size += len;
+    in->data[in->size] = '\0';
+    return 0;
+}
+
+uint8_t StrBuf_appendChar(StrBuf *in, char c)
+{
+    if (!in) return 1;
+    if (StrBuf_reserve(in, 1)) return 1;
+
+    in->data[in->size++] = c;
+    in->data[in->size] = '\0';
+    return 0;
+}
+
+uint8_t StrBuf_appendFixed3(StrBuf *in, double value)
+{
+    if (!in) return 1;
+
+    if (StrBuf_reserve(in, subfx_misc_fixed3Size)) return 1;
+
+    size_t len = subfx_misc_fixed3(value, in->data + in->size);
+    if (len)
+    {
+        in->size += len;
+        return 0;
+    }
+
+    // NaN, infinities and huge numbers
+    int res = snprintf(NULL, 0, "%.3f", value);
+    if (res < 0 || StrBuf_reserve(in, (size_t)res)) return 1;
+
+    snprintf(in->data + in->size, (size_t)res + 1, "%.3f", value);
+    in->size += (size_t)res;
+    return 0;
+}
+
+char *StrBuf_release(StrBuf *in, size_t *len)
+{
+    if (!in) return NULL;
+
+    // an empty string is still a string
+    if (!in->data && StrBuf_reserve(in, 0))
+    {
+        return NULL;
+    }
+
+    char *ret = in->data;
+    if (len) *len = in->size;
+    memset(in, 0, sizeof(StrBuf));
+    return ret;
+}
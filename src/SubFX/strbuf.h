@@ -0,0 +1,70 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * A growable '\0' terminated string.
+ * data is NULL until something is appended.
+ */
+typedef struct StrBuf
+{
+    char *data;
+
+    // without the '\0'
+    size_t size;
+
+    size_t capacity;
+} StrBuf;
+
+uint8_t StrBuf_init(StrBuf *, size_t capacity);
+
+void StrBuf_fin(StrBuf *);
+
+// makes room for at least more bytes after size, plus the '\0'
+uint8_t StrBuf_reserve(StrBuf *, size_t more);
+
+uint8_t StrBuf_append(StrBuf *, const char *str, size_t len);
+
+uint8_t StrBuf_appendChar(StrBuf *, char c);
+
+/**
+ * Appends the number as "%.3f" would, see subfx_misc_fixed3().
+ */
+uint8_t StrBuf_appendFixed3(StrBuf *, double value);
+
+/**
+ * Hands the string over to the caller, who has to free() it.
+ * The StrBuf is empty afterwards.
+ * @param len the length of the string, can be NULL.
+ */
+char *StrBuf_release(StrBuf *, size_t *len);
+
+#ifdef __cplusplus
+}
+#endif
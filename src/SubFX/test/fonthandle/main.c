@@ -23,9 +23,56 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "SubFX.h"
 
+// every cache mode must give what the full layout gives
+static int compareModes(subfx_fontHandle_api *fontHandle,
+                        subfx_fontHandle *handle,
+                        const char *text)
+{
+    uint8_t modes[] =
+    {
+        subfx_fonthandle_cache_extents,
+        subfx_fonthandle_cache_advances,
+        subfx_fonthandle_cache_extents | subfx_fonthandle_cache_advances
+    };
+
+    double expected[2], extents[2];
+    fontHandle->setCacheMode(handle, subfx_fonthandle_cache_none);
+    if (fontHandle->text_extents2(handle, text, strlen(text),
+                                  expected) == subfx_failed)
+    {
+        puts("Fail to get text extents");
+        return 1;
+    }
+
+    for (size_t j = 0; j < sizeof(modes); ++j)
+    {
+        fontHandle->setCacheMode(handle, modes[j]);
+
+        // twice, so the second one hits the cache
+        for (int k = 0; k < 2; ++k)
+        {
+            if (fontHandle->text_extents2(handle, text, strlen(text),
+                                          extents) == subfx_failed ||
+                extents[0] != expected[0] ||
+                extents[1] != expected[1])
+            {
+                printf("text_extents2 mismatch: %s, mode %d\n",
+                       text, modes[j]);
+                fontHandle->setCacheMode(handle,
+                                         subfx_fonthandle_cache_extents);
+                return 1;
+            }
+        }
+    }
+
+    fontHandle->setCacheMode(handle, subfx_fonthandle_cache_extents);
+    return 0;
+}
+
 int main()
 {
     SubFX subfx;
@@ -102,8 +149,52 @@ int main()
     printf("text's height is: %lf\n",
            retDouble[subfx_fonthandle_text_extents_height]);
 
+    const char *texts[] = {"testing", "AV fi", "\xe6\x97\xa5\xe6\x9c\xac"};
+    for (size_t i = 0; i < (sizeof(texts) / sizeof(char *)); ++i)
+    {
+        if (compareModes(fontHandle, handle, texts[i]))
+        {
+            free(retDouble);
+            ret = 1;
+            goto error;
+        }
+    }
+
     free(retDouble);
 
+    // A proportional face with f ligatures. "ffi" is one glyph, while
+    // "ff" and "fi" may not be, so the pairs alone do not show it.
+    // The pairs are measured first, the advance cache knows them then.
+    sprintf(tmpString, "serif");
+    subfx_fontHandle *serif = fontHandle->create(tmpString, 0, 0, 0, 0, 60,
+                                                 1., 1., 0., errMsg);
+    if (!serif)
+    {
+        puts("Fail in initializing.");
+        ret = 1;
+        goto error;
+    }
+
+    const char *ligatures[] =
+    {
+        "of", "ff", "fi", "ic", "ce", "office", "ffi", "ffl", "fjord", "a->b"
+    };
+
+    for (size_t i = 0; i < (sizeof(ligatures) / sizeof(char *)); ++i)
+    {
+        if (compareModes(fontHandle, serif, ligatures[i]))
+        {
+            ret = 1;
+            break;
+        }
+    }
+
+    if (fontHandle->destory(serif) == subfx_failed || ret)
+    {
+        ret = 1;
+        goto error;
+    }
+
     char *retChar = fontHandle->text_to_shape(handle, tmpString, errMsg);
     if (!retChar)
     {
@@ -113,8 +204,77 @@ int main()
     }
 
     printf("text's shape is: %s\n", retChar);
+
+    // the path has to give the same shape
+    subfx_shapePath *path = fontHandle->text_to_path(handle, tmpString, errMsg);
+    if (!path)
+    {
+        puts("Fail to get text's path");
+        free(retChar);
+        ret = 1;
+        goto error;
+    }
+
+    char *pathShape = fontHandle->path_to_shape(path, NULL, errMsg);
+    if (!pathShape || strcmp(pathShape, retChar))
+    {
+        puts("text_to_path mismatch");
+        ret = 1;
+    }
+
+    free(pathShape);
+    fontHandle->destoryPath(path);
     free(retChar);
 
+    // outlines put together from cached glyphs match the layout's one
+    fontHandle->setCacheMode(handle, subfx_fonthandle_cache_none);
+    subfx_shapePath *expectedPath = fontHandle->text_to_path(handle,
+                                                             texts[1],
+                                                             errMsg);
+    fontHandle->setCacheMode(handle, subfx_fonthandle_cache_extents |
+                                     subfx_fonthandle_cache_glyphs);
+    if (!expectedPath)
+    {
+        puts("Fail to get text's path");
+        ret = 1;
+        goto error;
+    }
+
+    for (int k = 0; k < 2 && !ret; ++k)
+    {
+        path = fontHandle->text_to_path(handle, texts[1], errMsg);
+        if (!path ||
+            path->opCount != expectedPath->opCount ||
+            path->coordCount != expectedPath->coordCount ||
+            (path->opCount &&
+             memcmp(path->ops, expectedPath->ops, path->opCount)))
+        {
+            ret = 1;
+        }
+
+        for (size_t i = 0; !ret && i < path->coordCount; ++i)
+        {
+            double diff = path->coords[i] - expectedPath->coords[i];
+            if (diff > 1e-6 || diff < -1e-6)
+            {
+                ret = 1;
+            }
+        }
+
+        if (path) fontHandle->destoryPath(path);
+    }
+
+    fontHandle->destoryPath(expectedPath);
+    if (ret)
+    {
+        puts("glyph cache mismatch");
+        goto error;
+    }
+
+    size_t hits, misses;
+    fontHandle->glyphCacheStats(handle, &hits, &misses);
+    printf("glyph cache: %zu hits, %zu misses\n", hits, misses);
+
 error:
     if (fontHandle->destory(handle) == subfx_failed)
     {
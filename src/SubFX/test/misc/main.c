@@ -49,6 +49,22 @@ int main()
 
     puts(string);
 
+    // the allocation free ones have to agree with it
+    char buffer[64];
+    double numbers[] = {sqrt(2.), -0.0005, 12345.6785};
+    if (misc->doubleToString2(sqrt(2.), buffer, sizeof(buffer)) !=
+        strlen(string) ||
+        strcmp(buffer, string) ||
+        misc->doubleToString2(sqrt(2.), buffer, 5) != 0 ||
+        misc->doublesToString(numbers, 3, buffer, sizeof(buffer)) == 0 ||
+        strcmp(buffer, "1.414 -0.001 12345.678"))
+    {
+        fputs("Fail due to \"doubleToString2\"", stderr);
+        free(string);
+        SubFX_fin(&api);
+        return 1;
+    }
+
     char errMsg[1000];
     errMsg[0] = '\0';
 
@@ -0,0 +1,99 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "thread.h"
+
+#ifdef _WIN32
+static DWORD WINAPI threadEntry(LPVOID in)
+{
+    Thread *thread = (Thread *)in;
+    thread->func(thread->arg);
+    return 0;
+}
+#else
+static void *threadEntry(void *in)
+{
+    Thread *thread = (Thread *)in;
+    thread->func(thread->arg);
+    return NULL;
+}
+#endif
+
+uint8_t Thread_create(Thread *in, ThreadFunc func, void *arg)
+{
+    if (!in || !func) return 1;
+
+    memset(in, 0, sizeof(Thread));
+    in->func = func;
+    in->arg = arg;
+
+#ifdef _WIN32
+    in->handle = CreateThread(NULL, 0, threadEntry, in, 0, NULL);
+    if (!in->handle)
+    {
+        return 1;
+    }
+#else
+    if (pthread_create(&in->handle, NULL, threadEntry, in))
+    {
+        return 1;
+    }
+#endif
+
+    return 0;
+}
+
+uint8_t Thread_join(Thread *in)
+{
+    if (!in) return 1;
+
+#ifdef _WIN32
+    if (WaitForSingleObject(in->handle, INFINITE) != WAIT_OBJECT_0)
+    {
+        return 1;
+    }
+
+    CloseHandle(in->handle);
+#else
+    if (pthread_join(in->handle, NULL))
+    {
+        return 1;
+    }
+#endif
+
+    return 0;
+}
+
+uint32_t Thread_hardwareConcurrency()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors ? (uint32_t)info.dwNumberOfProcessors : 1;
+#else
+    long ret = sysconf(_SC_NPROCESSORS_ONLN);
+    return (ret > 0) ? (uint32_t)ret : 1;
+#endif
+}
@@ -0,0 +1,63 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include "pthread.h"
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef void (*ThreadFunc)(void *);
+
+/**
+ * The Thread object must stay at the same address
+ * until Thread_join() returns.
+ */
+typedef struct Thread
+{
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+
+    ThreadFunc func;
+
+    void *arg;
+} Thread;
+
+uint8_t Thread_create(Thread *, ThreadFunc, void *arg);
+
+uint8_t Thread_join(Thread *);
+
+// number of logical processors, at least 1
+uint32_t Thread_hardwareConcurrency();
+
+#ifdef __cplusplus
+}
+#endif
@@ -19,36 +19,61 @@
 
 #include <stdexcept>
 #include <iostream>
-#include <fstream>
+#include <memory>
+#include <atomic>
 
 #include <cstring>
+#include <cstdio>
 
 #include "YutilsCpp"
 #include "internal/asswriter_internal.hpp"
 
 using namespace PROJ_NAMESPACE::Yutils;
 
+// bytes of output collected before each write to a file
+static std::atomic<size_t> writeBufferSize(ASSWRITER_DEFAULT_BUFFER_SIZE);
+
+// The file is closed when it goes out of scope
+typedef std::unique_ptr<FILE, int(*)(FILE *)> FilePtr;
+
+SYMBOL_SHOW void AssWriter::setBufferSize(size_t size) THROW
+{
+    if (size < ASSWRITER_MIN_BUFFER_SIZE || size > ASSWRITER_MAX_BUFFER_SIZE)
+    {
+        throw std::invalid_argument("setBufferSize: size must be "
+                                    "between 64 KiB and 64 MiB.");
+    }
+
+    writeBufferSize = size;
+}
+
+SYMBOL_SHOW size_t AssWriter::bufferSize() NOTHROW
+{
+    return writeBufferSize;
+}
+
 SYMBOL_SHOW void AssWriter::write(const char *fileName,
                                   std::shared_ptr<AssParser> &parser) THROW
 {
     // here may throw
     AssWriter_Internal::checkFileName(fileName);
 
-    std::fstream file;
-    file.open(fileName, std::fstream::trunc | std::fstream::out);
-    if (file.fail())
+    // here may throw
+    FilePtr file(AssWriter_Internal::openFile(fileName, "w"), fclose);
+    AssWriter_Internal::writeFile(file.get(), [&](std::ostream &stream)
     {
-        throw std::invalid_argument("write: CANOT open file");
-    }
-
-    AssWriter_Internal::write(file, parser);
-
-    file.close();
+        AssWriter_Internal::write(stream, parser);
+    });
 }
 
 SYMBOL_SHOW void AssWriter::write(std::shared_ptr<AssParser> &parser) THROW
 {
-    AssWriter_Internal::write(std::cout, parser);
+    // keep the order of anything written to std::cout before
+    std::cout.flush();
+    AssWriter_Internal::writeFile(stdout, [&](std::ostream &stream)
+    {
+        AssWriter_Internal::write(stream, parser);
+    });
 }
 
 SYMBOL_SHOW void AssWriter::write(const char *fileName,
@@ -58,39 +83,30 @@ SYMBOL_SHOW void AssWriter::write(const char *fileName,
     // here may throw
     AssWriter_Internal::checkFileName(fileName);
 
-    std::fstream file;
     size_t length(0);
     if (assHeader)
     {
         length = strlen(assHeader);
-        if (length)
-        {
-            file.open(fileName, std::fstream::trunc | std::fstream::out);
-        }
-        else
-        {
-            file.open(fileName, std::fstream::app | std::fstream::out);
-        }
-    }
-    else
-    {
-        file.open(fileName, std::fstream::app | std::fstream::out);
     }
 
-    if (file.fail())
+    // without header, events are appended to the file
+    // here may throw
+    FilePtr file(AssWriter_Internal::openFile(fileName, length ? "w" : "a"),
+                 fclose);
+    AssWriter_Internal::writeFile(file.get(), [&](std::ostream &stream)
     {
-        throw std::invalid_argument("write: CANOT open file");
-    }
-
-    AssWriter_Internal::write(file, assHeader, length, assBuf);
-
-    file.close();
+        AssWriter_Internal::write(stream, assHeader, length, assBuf);
+    });
 }
 
 SYMBOL_SHOW void AssWriter::write(const char *assHeader,
                                   std::vector<std::string> &assBuf) THROW
 {
-    AssWriter_Internal::write(std::cout, assHeader, strlen(assHeader), assBuf);
+    std::cout.flush();
+    AssWriter_Internal::writeFile(stdout, [&](std::ostream &stream)
+    {
+        AssWriter_Internal::write(stream, assHeader, strlen(assHeader), assBuf);
+    });
 }
 
 SYMBOL_SHOW void AssWriter::write(const char *fileName,
@@ -102,16 +118,12 @@ SYMBOL_SHOW void AssWriter::write(const char *fileName,
     // here may throw
     AssWriter_Internal::checkFileName(fileName);
 
-    std::fstream file;
-    file.open(fileName, std::fstream::trunc | std::fstream::out);
-    if (file.fail())
+    // here may throw
+    FilePtr file(AssWriter_Internal::openFile(fileName, "w"), fclose);
+    AssWriter_Internal::writeFile(file.get(), [&](std::ostream &stream)
     {
-        throw std::invalid_argument("write: CANOT open file");
-    }
-
-    AssWriter_Internal::write(file, meta, styles, assBuf);
-
-    file.close();
+        AssWriter_Internal::write(stream, meta, styles, assBuf);
+    });
 }
 
 SYMBOL_SHOW void AssWriter::write(std::shared_ptr<AssMeta> &meta,
@@ -119,5 +131,109 @@ SYMBOL_SHOW void AssWriter::write(std::shared_ptr<AssMeta> &meta,
                                   std::shared_ptr<AssStyle>> &styles,
                                   std::vector<std::string> &assBuf) THROW
 {
-    AssWriter_Internal::write(std::cout, meta, styles, assBuf);
+    std::cout.flush();
+    AssWriter_Internal::writeFile(stdout, [&](std::ostream &stream)
+    {
+        AssWriter_Internal::write(stream, meta, styles, assBuf);
+    });
+}
+
+AssWriter::Sink::Sink(const char *fileName,
+                      std::shared_ptr<AssMeta> &meta,
+                      std::map<std::string,
+                      std::shared_ptr<AssStyle>> &styles) THROW :
+    m_file(nullptr, fclose),
+    m_buffer(nullptr),
+    m_stream(nullptr),
+    m_events(0)
+{
+    // here may throw
+    AssWriter_Internal::checkFileName(fileName);
+
+    // here may throw
+    m_file.reset(AssWriter_Internal::openFile(fileName, "w"));
+    m_buffer.reset(new AssWriter_Internal::FileBuffer(m_file.get(),
+                                                      bufferSize()));
+    m_stream.reset(new std::ostream(m_buffer.get()));
+
+    AssWriter_Internal::writeMeta(*m_stream, meta);
+    // here may throw
+    AssWriter_Internal::writeStyle(*m_stream, styles);
+    AssWriter_Internal::writeEventHeader(*m_stream);
+}
+
+AssWriter::Sink::Sink(const char *fileName) THROW :
+    m_file(nullptr, fclose),
+    m_buffer(nullptr),
+    m_stream(nullptr),
+    m_events(0)
+{
+    // here may throw
+    AssWriter_Internal::checkFileName(fileName);
+
+    // here may throw
+    m_file.reset(AssWriter_Internal::openFile(fileName, "w"));
+    m_buffer.reset(new AssWriter_Internal::FileBuffer(m_file.get(),
+                                                      bufferSize()));
+    m_stream.reset(new std::ostream(m_buffer.get()));
+}
+
+AssWriter::Sink::~Sink()
+{}
+
+void AssWriter::Sink::write(const std::vector<std::string> &events) THROW
+{
+    if (!m_stream)
+    {
+        throw std::invalid_argument("write: sink is closed.");
+    }
+
+    for (auto i = events.begin(); i != events.end(); ++i)
+    {
+        *m_stream << *i << '\n';
+    }
+
+    if (m_stream->fail())
+    {
+        throw std::invalid_argument("write: CANNOT write file");
+    }
+
+    m_events += events.size();
+}
+
+void AssWriter::Sink::flush() THROW
+{
+    if (!m_stream)
+    {
+        throw std::invalid_argument("flush: sink is closed.");
+    }
+
+    m_stream->flush();
+    if (m_stream->fail() || fflush(m_file.get()))
+    {
+        throw std::invalid_argument("flush: CANNOT write file");
+    }
+}
+
+void AssWriter::Sink::close() THROW
+{
+    if (!m_stream)
+    {
+        return;
+    }
+
+    // here may throw
+    flush();
+
+    m_stream.reset();
+    m_buffer.reset();
+    if (fclose(m_file.release()))
+    {
+        throw std::invalid_argument("close: CANNOT close file");
+    }
+}
+
+size_t AssWriter::Sink::events() const NOTHROW
+{
+    return m_events;
 }
@@ -0,0 +1,124 @@
+/*
+ * This file is part of SubFX,
+ * Copyright (c) 2020-2021 fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Writes 1M pixel effect like events with AssWriter::write,
+// against the std::endl per line fstream it used before,
+// and with buffers from 64 KiB to 8 MiB.
+// usage: benchAssWriter [events] [file]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "YutilsCpp"
+
+using namespace PROJ_NAMESPACE::Yutils;
+
+static const char *assHeader =
+        "[Script Info]\nScriptType: v4.00+\n\n"
+        "[Events]\nFormat: Layer, Start, End, Style, Name, "
+        "MarginL, MarginR, MarginV, Effect, Text\n";
+
+static std::vector<std::string> makeEvents(size_t count)
+{
+    std::vector<std::string> events;
+    events.reserve(count);
+    char line[256];
+    for (size_t i = 0; i < count; ++i)
+    {
+        snprintf(line, sizeof(line),
+                 "Dialogue: 1,0:00:%02zu.%02zu,0:00:%02zu.%02zu,Default,,0,0,0,,"
+                 "{\\an7\\pos(%zu,%zu)\\bord0\\shad0\\alpha&H%02zX&\\p1}"
+                 "m 0 0 l 1 0 1 1 0 1",
+                 (i / 100) % 60, i % 100, (i / 100 + 1) % 60, i % 100,
+                 i % 1920, (i / 1920) % 1080, i & 0xff);
+        events.push_back(line);
+    }
+
+    return events;
+}
+
+// what AssWriter::write did before it was buffered
+static void writeFlushing(const char *fileName,
+                          std::vector<std::string> &events)
+{
+    std::fstream file;
+    file.open(fileName, std::fstream::trunc | std::fstream::out);
+    file << assHeader;
+    for (auto i = events.begin(); i != events.end(); ++i)
+    {
+        file << *i << std::endl;
+    }
+
+    file.close();
+}
+
+template<class Func>
+static void report(const char *name, Func func)
+{
+    auto start(std::chrono::steady_clock::now());
+    func();
+    std::chrono::duration<double> elapsed(
+        std::chrono::steady_clock::now() - start);
+    printf("%-16s %9.1f ms\n", name, elapsed.count() * 1000.);
+}
+
+int main(int argc, char **argv)
+{
+    size_t count((argc > 1) ? strtoull(argv[1], nullptr, 10) : 0);
+    if (!count) count = 1000000;
+
+    const char *fileName((argc > 2) ? argv[2] : "benchAssWriter.ass");
+    std::vector<std::string> events(makeEvents(count));
+
+    report("endl per line", [&]()
+    {
+        writeFlushing(fileName, events);
+    });
+
+    const size_t sizes[] = {1 << 16, 1 << 20, 1 << 23};
+    const char *names[] = {"buffer 64 KiB", "buffer 1 MiB", "buffer 8 MiB"};
+    try
+    {
+        for (size_t i = 0; i < 3; ++i)
+        {
+            AssWriter::setBufferSize(sizes[i]);
+            report(names[i], [&]()
+            {
+                AssWriter::write(fileName, assHeader, events);
+            });
+        }
+    }
+    catch (std::exception &e)
+    {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    remove(fileName);
+    return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * This file is part of SubFX,
+ * Copyright (c) 2020-2021 fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Runs Shape::filter over shapes of 1k, 10k and 100k points and reports
+// the time per point, which should stay flat as the shape grows.
+// usage: benchShapeFilter [rounds]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "YutilsCpp"
+
+using namespace PROJ_NAMESPACE::Yutils;
+
+// lines and curves in the way text_to_shape writes them
+static std::string makeShape(size_t points, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<double> dist(-500., 500.);
+    char buffer[64];
+    std::string shape;
+    size_t count(0);
+    while (count < points)
+    {
+        if ((count % 100) == 0)
+        {
+            shape += (count == 0) ? "m " : "c m ";
+            count += 1;
+        }
+        else if ((rng() % 3) == 0 && (points - count) >= 3)
+        {
+            shape += "b ";
+            count += 3;
+        }
+        else
+        {
+            shape += "l ";
+            count += 1;
+        }
+
+        size_t coords((shape[shape.size() - 2] == 'b') ? 3 : 1);
+        for (size_t i = 0; i < coords; ++i)
+        {
+            snprintf(buffer, sizeof(buffer), "%.3f %.3f ",
+                     dist(rng), dist(rng));
+            shape += buffer;
+        }
+    }
+
+    return shape + "c";
+}
+
+int main(int argc, char **argv)
+{
+    size_t rounds((argc > 1) ? strtoull(argv[1], nullptr, 10) : 0);
+    if (!rounds) rounds = 1000000;
+
+    std::function<std::pair<double, double>(double, double, std::string &)> flt(
+        [](double x, double y, std::string &)
+        {
+            return std::make_pair(x, y);
+        }
+    );
+
+    std::mt19937 rng(42);
+    const size_t sizes[] = {1000, 10000, 100000};
+    for (size_t points : sizes)
+    {
+        std::string shape(makeShape(points, rng));
+
+        // about the same amount of points for every size
+        size_t repeat(rounds / points);
+        if (!repeat) repeat = 1;
+
+        size_t bytes(0);
+        auto start(std::chrono::steady_clock::now());
+        try
+        {
+            for (size_t i = 0; i < repeat; ++i)
+            {
+                bytes += Shape::filter(shape, flt).size();
+            }
+        }
+        catch (std::exception &e)
+        {
+            std::cout << e.what() << std::endl;
+            return 1;
+        }
+
+        std::chrono::duration<double> elapsed(
+            std::chrono::steady_clock::now() - start);
+        printf("%7zu points x %5zu %9.3f ms/shape %7.1f ns/point %10zu bytes\n",
+               points, repeat, elapsed.count() * 1000. / repeat,
+               elapsed.count() * 1e9 / (double)(points * repeat),
+               bytes / repeat);
+    }
+
+    return 0;
+}
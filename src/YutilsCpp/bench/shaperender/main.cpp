@@ -0,0 +1,98 @@
+/*
+ * This file is part of SubFX,
+ * Copyright (c) 2020-2021 fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Runs Shape::to_pixels on glyph like paths of 500, 2k and 8k edges,
+// about 200 pixels wide, so 1600 rows are scanned at 8x supersampling.
+// usage: benchShapeRender [rounds]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "YutilsCpp"
+
+using namespace PROJ_NAMESPACE::Yutils;
+
+// a few nested star shaped contours, like the outlines of a bold glyph
+static Shape::Path makePath(size_t edges)
+{
+    Shape::Path path;
+    size_t perContour(edges >> 2);
+    path.ops.reserve(edges + 4);
+    path.coords.reserve((edges + 4) << 1);
+    for (size_t contour = 0; contour < 4; ++contour)
+    {
+        for (size_t i = 0; i < perContour; ++i)
+        {
+            double angle(2. * M_PI * static_cast<double>(i) /
+                         static_cast<double>(perContour));
+            double radius(((i & 1) ? 90. : 40.) -
+                          static_cast<double>(contour) * 8.);
+            path.ops.push_back(i ? subfx_shapePath_line :
+                                   subfx_shapePath_move);
+            path.coords.push_back(100. + radius * cos(angle));
+            path.coords.push_back(100. + radius * sin(angle));
+        }
+
+        path.ops.push_back(subfx_shapePath_close);
+    }
+
+    return path;
+}
+
+int main(int argc, char **argv)
+{
+    size_t rounds((argc > 1) ? strtoull(argv[1], nullptr, 10) : 0);
+    if (!rounds) rounds = 20;
+
+    const size_t sizes[] = {500, 2000, 8000};
+    for (size_t edges : sizes)
+    {
+        Shape::Path path(makePath(edges));
+
+        size_t pixels(0);
+        auto start(std::chrono::steady_clock::now());
+        try
+        {
+            for (size_t i = 0; i < rounds; ++i)
+            {
+                pixels += Shape::to_pixels(path).size();
+            }
+        }
+        catch (std::exception &e)
+        {
+            std::cout << e.what() << std::endl;
+            return 1;
+        }
+
+        std::chrono::duration<double> elapsed(
+            std::chrono::steady_clock::now() - start);
+        printf("%5zu edges x %3zu %9.3f ms/shape %8zu pixels\n",
+               edges, rounds, elapsed.count() * 1000. / rounds,
+               pixels / rounds);
+    }
+
+    return 0;
+}
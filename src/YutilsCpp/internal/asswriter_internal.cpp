@@ -21,6 +21,52 @@
 
 using namespace PROJ_NAMESPACE::Yutils;
 
+AssWriter_Internal::FileBuffer::FileBuffer(FILE *file, size_t size) THROW :
+    m_file(file),
+    m_buffer(size)
+{
+    setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+}
+
+AssWriter_Internal::FileBuffer::~FileBuffer()
+{
+    flushBuffer();
+}
+
+AssWriter_Internal::FileBuffer::int_type
+AssWriter_Internal::FileBuffer::overflow(int_type ch)
+{
+    if (!flushBuffer())
+    {
+        return traits_type::eof();
+    }
+
+    if (!traits_type::eq_int_type(ch, traits_type::eof()))
+    {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(ch);
+}
+
+int AssWriter_Internal::FileBuffer::sync()
+{
+    return flushBuffer() ? 0 : -1;
+}
+
+bool AssWriter_Internal::FileBuffer::flushBuffer() NOTHROW
+{
+    size_t length(static_cast<size_t>(pptr() - pbase()));
+    if (length && fwrite(pbase(), 1, length, m_file) != length)
+    {
+        return false;
+    }
+
+    setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+    return true;
+}
+
 void AssWriter_Internal::checkFileName(const char *fileName) THROW
 {
     if (!fileName)
@@ -34,39 +80,53 @@ void AssWriter_Internal::checkFileName(const char *fileName) THROW
     }
 }
 
+FILE *AssWriter_Internal::openFile(const char *fileName,
+                                   const char *mode) THROW
+{
+    FILE *file(fopen(fileName, mode));
+    if (!file)
+    {
+        throw std::invalid_argument("write: CANOT open file");
+    }
+
+    // FileBuffer already writes in large blocks
+    setvbuf(file, nullptr, _IONBF, 0);
+    return file;
+}
+
 void AssWriter_Internal::writeMeta(std::ostream &file,
                                    std::shared_ptr<AssMeta> &meta) NOTHROW
 {
-    file << "[Script Info]" << std::endl;
-    file << "Title:" << std::endl;
-    file << "ScriptType: v4.00+" << std::endl;
-    file << "WrapStyle: " << (static_cast<int>(meta->wrap_style) - 48) << std::endl;
-    file << "ScaledBorderAndShadow: " << (meta->scaled_border_and_shadow ? "yes" : "no") << std::endl;
+    file << "[Script Info]" << '\n';
+    file << "Title:" << '\n';
+    file << "ScriptType: v4.00+" << '\n';
+    file << "WrapStyle: " << (static_cast<int>(meta->wrap_style) - 48) << '\n';
+    file << "ScaledBorderAndShadow: " << (meta->scaled_border_and_shadow ? "yes" : "no") << '\n';
 
     if (meta->colorMatrix != "")
     {
-        file << "YCbCr Matrix: " << meta->colorMatrix << std::endl;
+        file << "YCbCr Matrix: " << meta->colorMatrix << '\n';
     }
     else if (meta->play_res_x >= 1000 || meta->play_res_y >= 1000)
     {
-        file << "YCbCr Matrix: TV.709" << std::endl;
+        file << "YCbCr Matrix: TV.709" << '\n';
     }
     else
     {
-        file << "YCbCr Matrix: TV.601" << std::endl;
+        file << "YCbCr Matrix: TV.601" << '\n';
     }
 
-    file << "PlayResX: " << meta->play_res_x << std::endl;
-    file << "PlayResY: " << meta->play_res_y << std::endl;
-    file << std::endl;
+    file << "PlayResX: " << meta->play_res_x << '\n';
+    file << "PlayResY: " << meta->play_res_y << '\n';
+    file << '\n';
 }
 
 void AssWriter_Internal::writeStyle(std::ostream &file,
                                     std::map<std::string,
                                     std::shared_ptr<AssStyle>> &styles) THROW
 {
-    file << "[V4+ Styles]" << std::endl;
-    file << "Format: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, OutlineColour, BackColour, Bold, Italic, Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, BorderStyle, Outline, Shadow, Alignment, MarginL, MarginR, MarginV, Encoding" << std::endl;
+    file << "[V4+ Styles]" << '\n';
+    file << "Format: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, OutlineColour, BackColour, Bold, Italic, Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, BorderStyle, Outline, Shadow, Alignment, MarginL, MarginR, MarginV, Encoding" << '\n';
     std::tuple<uint8_t, uint8_t, uint8_t, uint8_t> tmpTuple;
     std::vector<uint8_t> tmpVector;
     tmpVector.resize(4);
@@ -157,16 +217,16 @@ void AssWriter_Internal::writeStyle(std::ostream &file,
 
         file << style->encoding;
 
-        file << std::endl;
+        file << '\n';
     }
 
-    file << std::endl;
+    file << '\n';
 }
 
 void AssWriter_Internal::writeEventHeader(std::ostream &file) NOTHROW
 {
-    file << "[Events]" << std::endl;
-    file << "Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text" << std::endl;
+    file << "[Events]" << '\n';
+    file << "Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text" << '\n';
 }
 
 void AssWriter_Internal::writeEvent(std::ostream &file,
@@ -176,7 +236,7 @@ void AssWriter_Internal::writeEvent(std::ostream &file,
 
     for (auto i = assBuf.begin(); i != assBuf.end(); ++i)
     {
-        file << *i << std::endl;
+        file << *i << '\n';
     }
 }
 
@@ -208,8 +268,8 @@ void AssWriter_Internal::writeEvent(std::ostream &file,
         file << dialog->effect << ",";
         file << dialog->text;
 
-        file << std::endl;
+        file << '\n';
     }
 
-    file << std::endl;
+    file << '\n';
 }
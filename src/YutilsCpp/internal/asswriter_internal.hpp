@@ -20,10 +20,20 @@
 #pragma once
 
 #include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <vector>
+
+#include <cstdio>
 
 #include "internal/basecommon.h"
 #include "YutilsCpp"
 
+// bytes of a FileBuffer
+#define ASSWRITER_DEFAULT_BUFFER_SIZE (1 << 20)
+#define ASSWRITER_MIN_BUFFER_SIZE (1 << 16)
+#define ASSWRITER_MAX_BUFFER_SIZE (1 << 26)
+
 namespace PROJ_NAMESPACE
 {
 
@@ -33,8 +43,56 @@ namespace Yutils
 namespace AssWriter_Internal
 {
 
+// Collects everything written to it in one large buffer and hands
+// it to file with one fwrite when it is full, instead of one write
+// syscall per line. file is not owned.
+class FileBuffer : public std::streambuf
+{
+public:
+
+    FileBuffer(FILE *file, size_t size) THROW;
+
+    ~FileBuffer() override;
+
+protected:
+
+    int_type overflow(int_type ch) override;
+
+    int sync() override;
+
+private:
+
+    bool flushBuffer() NOTHROW;
+
+    FILE *m_file;
+
+    std::vector<char> m_buffer;
+};
+
 void checkFileName(const char *fileName) THROW;
 
+// fopen, but throws if file CANNOT be opened
+FILE *openFile(const char *fileName, const char *mode) THROW;
+
+// Runs func(std::ostream &) on a FileBuffer of file,
+// which has AssWriter::bufferSize() bytes, then flushes everything.
+// file is not closed.
+template<class Func>
+void writeFile(FILE *file, Func func) THROW
+{
+    FileBuffer buffer(file, AssWriter::bufferSize());
+    std::ostream stream(&buffer);
+
+    // here may throw
+    func(stream);
+
+    stream.flush();
+    if (stream.fail() || fflush(file))
+    {
+        throw std::invalid_argument("write: CANNOT write file");
+    }
+}
+
 void writeMeta(std::ostream &file, std::shared_ptr<AssMeta> &meta) NOTHROW;
 
 void writeStyle(std::ostream &file,
@@ -75,7 +133,7 @@ void write(T &file,
 
     for (auto i = assBuf.begin(); i != assBuf.end(); ++i)
     {
-        file << *i << std::endl;
+        file << *i << '\n';
     }
 }
 
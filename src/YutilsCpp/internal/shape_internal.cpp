@@ -17,10 +17,12 @@
 *    <http://www.gnu.org/licenses/>.
 */
 
-#include <functional>
 #include <algorithm>
+#include <stdexcept>
 
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 
 #include "shape_internal.hpp"
 #include "YutilsCpp"
@@ -33,29 +35,73 @@
 
 using namespace PROJ_NAMESPACE::Yutils;
 
-std::vector<double>
-Shape_Internal::curve4_subdivide(double x0, double y0,
-                                 double x1, double y1,
-                                 double x2, double y2,
-                                 double x3, double y3,
-                                 double pct) NOTHROW
+size_t Shape_Internal::number_length(const char *pos,
+                                     const char *end) NOTHROW
 {
-    std::vector<double> ret;
-    ret.reserve(16);
-    ret.push_back(x0);
-    ret.push_back(y0);
+    const char *p(pos);
+    if (p != end && *p == '-') ++p;
+
+    const char *digits(p);
+    while (p != end && *p >= '0' && *p <= '9') ++p;
+    if (p == digits) return 0;
+
+    if (p != end && *p == '.')
+    {
+        ++p;
+        while (p != end && *p >= '0' && *p <= '9') ++p;
+    }
+
+    return static_cast<size_t>(p - pos);
+}
+
+double Shape_Internal::to_double(const char *pos, size_t len) THROW
+{
+    // strtod needs the token to be terminated
+    char buffer[64];
+    if (len < sizeof(buffer))
+    {
+        memcpy(buffer, pos, len);
+        buffer[len] = '\0';
+        return strtod(buffer, nullptr);
+    }
+
+    std::string number(pos, len);
+    return strtod(number.c_str(), nullptr);
+}
+
+Shape_Internal::CurveTolerance
+Shape_Internal::curve_angle_tolerance(double degree) NOTHROW
+{
+    CurveTolerance tolerance;
+    tolerance.min_cos = cos(degree * M_PI / 180.);
+    tolerance.min_cos2 = tolerance.min_cos * tolerance.min_cos;
+    tolerance.max_dist2 = 0.;
+    return tolerance;
+}
+
+Shape_Internal::CurveTolerance
+Shape_Internal::curve_distance_tolerance(double distance) NOTHROW
+{
+    CurveTolerance tolerance;
+    tolerance.min_cos = 1.;
+    tolerance.min_cos2 = 1.;
+    tolerance.max_dist2 = distance * distance;
+    return tolerance;
+}
+
+void
+Shape_Internal::curve4_subdivide(const double *curve,
+                                 double pct,
+                                 double *halves) NOTHROW
+{
+    halves[0] = curve[0]; // x0
+    halves[1] = curve[1]; // y0
 #ifdef ENABLE_SIMD
-    double point0[] = {x0, y0};
-    double point1[] = {x1, y1};
-    double point2[] = {x2, y2};
-    double point3[] = {x3, y3};
-    double pcts[] = {pct, pct};
-
-    __m128d point0r(_mm_loadu_pd(point0));
-    __m128d point1r(_mm_loadu_pd(point1));
-    __m128d point2r(_mm_loadu_pd(point2));
-    __m128d point3r(_mm_loadu_pd(point3));
-    __m128d pctsr(_mm_loadu_pd(pcts));
+    __m128d point0r(_mm_loadu_pd(curve));
+    __m128d point1r(_mm_loadu_pd(curve + 2));
+    __m128d point2r(_mm_loadu_pd(curve + 4));
+    __m128d point3r(_mm_loadu_pd(curve + 6));
+    __m128d pctsr(_mm_set1_pd(pct));
 
     __m128d res1r(_mm_add_pd(point0r, point1r));
     __m128d res2r(_mm_add_pd(point1r, point2r));
@@ -70,10 +116,8 @@ Shape_Internal::curve4_subdivide(double x0, double y0,
     res3r = _mm_mul_pd(res3r, pctsr);
     // now res3r contains {x23, y23}
 
-    // store result
-    _mm_storeu_pd(point0, res1r);
-    ret.push_back(point0[0]); // x01
-    ret.push_back(point0[1]); // y01
+    _mm_storeu_pd(halves + 2, res1r); // x01, y01
+    _mm_storeu_pd(halves + 12, res3r); // x23, y23
 
     res1r = _mm_add_pd(res1r, res2r);
     res2r = _mm_add_pd(res2r, res3r);
@@ -84,319 +128,674 @@ Shape_Internal::curve4_subdivide(double x0, double y0,
     res2r = _mm_mul_pd(res2r, pctsr);
     // now res2r contains {x123, y123}
 
-    // store result
-    _mm_storeu_pd(point0, res1r);
-    ret.push_back(point0[0]); // x012
-    ret.push_back(point0[1]); // y012
+    _mm_storeu_pd(halves + 4, res1r); // x012, y012
+    _mm_storeu_pd(halves + 10, res2r); // x123, y123
 
     res1r = _mm_add_pd(res1r, res2r);
     res1r = _mm_mul_pd(res1r, pctsr);
     // now res1r contains {x0123, y0123}
 
-    // store result
-    _mm_storeu_pd(point0, res1r);
-    ret.push_back(point0[0]); // x0123
-    ret.push_back(point0[1]); // y0123
-    ret.push_back(point0[0]); // x0123
-    ret.push_back(point0[1]); // y0123
-
-    _mm_storeu_pd(point0, res2r); // {x123, y123}
-    ret.push_back(point0[0]); // x123
-    ret.push_back(point0[1]); // y123
-
-    _mm_storeu_pd(point0, res3r); // {x23, y23}
-    ret.push_back(point0[0]); // x23
-    ret.push_back(point0[1]); // y23
-
-    ret.push_back(x3);
-    ret.push_back(y3);
+    _mm_storeu_pd(halves + 6, res1r); // x0123, y0123
+    _mm_storeu_pd(halves + 8, res1r); // x0123, y0123
 #else // pure c++
-    double x01 = (x0 + x1) * pct;
-    double y01 = (y0 + y1) * pct;
-    ret.push_back(x01);
-    ret.push_back(y01);
-
-    double x12 = (x1 + x2) * pct;
-    double y12 = (y1 + y2) * pct;
-    double x23 = (x2 + x3) * pct;
-    double y23 = (y2 + y3) * pct;
+    double x01 = (curve[0] + curve[2]) * pct;
+    double y01 = (curve[1] + curve[3]) * pct;
+    double x12 = (curve[2] + curve[4]) * pct;
+    double y12 = (curve[3] + curve[5]) * pct;
+    double x23 = (curve[4] + curve[6]) * pct;
+    double y23 = (curve[5] + curve[7]) * pct;
 
     double x012 = (x01 + x12) * pct;
     double y012 = (y01 + y12) * pct;
-    ret.push_back(x012);
-    ret.push_back(y012);
-
     double x123 = (x12 + x23) * pct;
     double y123 = (y12 + y23) * pct;
 
     double x0123 = (x012 + x123) * pct;
     double y0123 = (y012 + y123) * pct;
-    ret.push_back(x0123);
-    ret.push_back(y0123);
-    ret.push_back(x0123);
-    ret.push_back(y0123);
-
-    ret.push_back(x123);
-    ret.push_back(y123);
 
-    ret.push_back(x23);
-    ret.push_back(y23);
-
-    ret.push_back(x3);
-    ret.push_back(y3);
+    halves[2] = x01;
+    halves[3] = y01;
+    halves[4] = x012;
+    halves[5] = y012;
+    halves[6] = x0123;
+    halves[7] = y0123;
+    halves[8] = x0123;
+    halves[9] = y0123;
+    halves[10] = x123;
+    halves[11] = y123;
+    halves[12] = x23;
+    halves[13] = y23;
 #endif
-    return ret;
+    halves[14] = curve[6]; // x3
+    halves[15] = curve[7]; // y3
 }
 
 bool
-Shape_Internal::curve4_is_flat(double x0, double y0,
-                               double x1, double y1,
-                               double x2, double y2,
-                               double x3, double y3,
-                               double tolerance) NOTHROW
+Shape_Internal::curve4_is_flat(const double *curve,
+                               const CurveTolerance &tolerance) NOTHROW
 {
-    std::vector<std::pair<double, double>> vecs;
-    vecs.reserve(3);
+    if (tolerance.max_dist2 > 0.)
+    {
+        // distance of the control points to the chord, the curve stays
+        // in their hull, so it is at most that far from the line
+        double cx(curve[6] - curve[0]), cy(curve[7] - curve[1]);
+        double chord2(cx * cx + cy * cy);
+        for (uint8_t i = 2; i <= 4; i += 2)
+        {
+            double px(curve[i] - curve[0]), py(curve[i + 1] - curve[1]);
+            double t((chord2 == 0.) ? 0. : (px * cx + py * cy) / chord2);
+            t = std::min(std::max(t, 0.), 1.);
+            px -= t * cx;
+            py -= t * cy;
+            if (px * px + py * py > tolerance.max_dist2)
+            {
+                return false;
+            }
+        }
 
-    vecs.push_back(std::make_pair(x1 - x0, y1 - y0));
-    vecs.push_back(std::make_pair(x2 - x1, y2 - y1));
-    vecs.push_back(std::make_pair(x3 - x2, y3 - y2));
+        return true;
+    }
 
-    size_t i(0), n(3);
-    while (i < n)
+    // angle between neighbouring segments, zero length segments are skipped
+    double last_x(0.), last_y(0.);
+    bool has_last(false);
+    for (uint8_t i = 0; i < 6; i += 2)
     {
-        if (vecs.at(i).first == 0. && vecs.at(i).second == 0.)
+        double vx(curve[i + 2] - curve[i]), vy(curve[i + 3] - curve[i + 1]);
+        if (vx == 0. && vy == 0.)
         {
-            vecs.erase(vecs.begin() + static_cast<int>(i));
-            --n;
+            continue;
         }
-        else
+
+        if (has_last)
         {
-            ++i;
+            // cos(angle) >= min_cos without acos and sqrt
+            double dot(last_x * vx + last_y * vy);
+            double lengths2((last_x * last_x + last_y * last_y) *
+                            (vx * vx + vy * vy));
+            bool flat((tolerance.min_cos >= 0.) ?
+                      (dot >= 0. && dot * dot >= tolerance.min_cos2 * lengths2) :
+                      (dot >= 0. || dot * dot <= tolerance.min_cos2 * lengths2));
+            if (!flat)
+            {
+                return false;
+            }
         }
+
+        last_x = vx;
+        last_y = vy;
+        has_last = true;
     }
 
-    for (i = 1; i < n; ++i)
+    return true;
+}
+
+void
+Shape_Internal::curve4_to_lines(const double *curve,
+                                std::vector<double> &output,
+                                const CurveTolerance &tolerance) THROW
+{
+    // Depth first on an explicit stack, the second half waits below
+    // the first one, so points come out in order.
+    // Every level halves the curve, deeper ones are flat in any case.
+    static const uint8_t max_depth(32);
+    double stack[max_depth + 1][8];
+    uint8_t depths[max_depth + 1];
+    double halves[16];
+
+    memcpy(stack[0], curve, sizeof(stack[0]));
+    depths[0] = 0;
+    size_t top(1);
+    while (top != 0)
     {
-        if (abs(Math::degree(vecs.at(i - 1).first,
-                       vecs.at(i - 1).second,
-                       0,
-                       vecs.at(i).first,
-                       vecs.at(i).second,
-                       0)) > tolerance)
+        --top;
+        const double *current(stack[top]);
+        uint8_t depth(depths[top]);
+        if (depth == max_depth || curve4_is_flat(current, tolerance))
         {
-            return false;
+            output.push_back(current[6]);
+            output.push_back(current[7]);
+            continue;
         }
+
+        curve4_subdivide(current, 0.5, halves);
+        memcpy(stack[top], halves + 8, sizeof(stack[0]));
+        depths[top] = depth + 1;
+        memcpy(stack[top + 1], halves, sizeof(stack[0]));
+        depths[top + 1] = depth + 1;
+        top += 2;
     }
+}
 
-    return true;
+void
+Shape_Internal::curve4_to_lines(const double *curve,
+                                std::vector<double> &output) THROW
+{
+    static const CurveTolerance tolerance(
+        curve_angle_tolerance(CURVE_TOLERANCE));
+
+    // here may throw exception
+    curve4_to_lines(curve, output, tolerance);
 }
 
-std::vector<double>
-Shape_Internal::curve4_to_lines(double px0, double py0,
-                                double px1, double py1,
-                                double px2, double py2,
-                                double px3, double py3) NOTHROW
+Shape_Internal::Raster::Raster() NOTHROW :
+    m_width(0),
+    m_height(0),
+    m_stride(0),
+    m_words()
+{}
+
+void Shape_Internal::Raster::reset(size_t width, size_t height) THROW
 {
-    std::vector<double> pts;
-    pts.reserve(4);
-
-    std::function<void(double, double, double, double, double, double, double, double)>
-    convert_recursive{ [&convert_recursive, &pts](
-                           double x0, double y0,
-                           double x1, double y1,
-                           double x2, double y2,
-                           double x3, double y3)
+    m_width = width;
+    m_height = height;
+    m_stride = (width + 63) >> 6;
+
+    // assign keeps the capacity, so only a larger image allocates
+    m_words.assign(m_stride * height, 0);
+}
+
+size_t Shape_Internal::Raster::width() const NOTHROW
+{
+    return m_width;
+}
+
+size_t Shape_Internal::Raster::height() const NOTHROW
+{
+    return m_height;
+}
+
+void Shape_Internal::Raster::fill(size_t y, size_t x0, size_t x1) NOTHROW
+{
+    x1 = std::min(x1, m_width);
+    if (x0 >= x1 || y >= m_height)
+    {
+        return;
+    }
+
+    uint64_t *row(m_words.data() + y * m_stride);
+    size_t first(x0 >> 6), last((x1 - 1) >> 6);
+    uint64_t first_mask(~static_cast<uint64_t>(0) << (x0 & 63));
+    uint64_t last_mask(~static_cast<uint64_t>(0) >> (63 - ((x1 - 1) & 63)));
+    if (first == last)
+    {
+        row[first] |= (first_mask & last_mask);
+        return;
+    }
+
+    row[first] |= first_mask;
+    for (size_t i = first + 1; i < last; ++i)
+    {
+        row[i] = ~static_cast<uint64_t>(0);
+    }
+
+    row[last] |= last_mask;
+}
+
+bool Shape_Internal::Raster::at(size_t x, size_t y) const NOTHROW
+{
+    if (x >= m_width || y >= m_height)
+    {
+        return false;
+    }
+
+    return (m_words[y * m_stride + (x >> 6)] >> (x & 63)) & 1;
+}
+
+void
+Shape_Internal::Raster::count_blocks(size_t by, uint8_t *counts) const NOTHROW
+{
+    const uint64_t *rows(m_words.data() + (by << 3) * m_stride);
+    size_t lines(std::min(static_cast<size_t>(8), m_height - (by << 3)));
+    for (size_t i = 0; i < m_stride; ++i)
     {
-        if (curve4_is_flat(x0, y0, x1, y1, x2, y2, x3, y3, CURVE_TOLERANCE))
+        // popcount of every byte, a byte is one block wide,
+        // 8 rows sum up to at most 64 per byte
+        uint64_t sum(0);
+        for (size_t yy = 0; yy < lines; ++yy)
         {
-            pts.push_back(x3);
-            pts.push_back(y3);
-            pts.reserve(pts.size() + 2);
+            uint64_t v(rows[yy * m_stride + i]);
+            v = v - ((v >> 1) & 0x5555555555555555ULL);
+            v = (v & 0x3333333333333333ULL) +
+                ((v >> 2) & 0x3333333333333333ULL);
+            v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+            sum += v;
         }
-        else
+
+        for (size_t j = 0; j < 8; ++j)
         {
-            std::vector<double> resVec(curve4_subdivide(x0, y0,
-                                                        x1, y1,
-                                                        x2, y2,
-                                                        x3, y3,
-                                                        0.5));
-            convert_recursive(resVec.at(0), resVec.at(1),
-                              resVec.at(2), resVec.at(3),
-                              resVec.at(4), resVec.at(5),
-                              resVec.at(6), resVec.at(7));
-            convert_recursive(resVec.at(8), resVec.at(9),
-                              resVec.at(10), resVec.at(11),
-                              resVec.at(12), resVec.at(13),
-                              resVec.at(14), resVec.at(15));
+            counts[(i << 3) + j] = static_cast<uint8_t>(sum >> (j << 3));
         }
-    } };
-
-    convert_recursive(px0, py0, px1, py1, px2, py2, px3, py3);
-    return pts;
+    }
 }
 
+namespace
+{
+
+// An edge of the edge table, it crosses the scanlines first to last
+typedef struct ScanEdge
+{
+    // start point and direction, as line_x_hline took them
+    double x, y, vx, vy;
+
+    // intersection with the current scanline
+    double cx;
+
+    int64_t first, last;
+
+    // +1 downwards, -1 upwards for non-zero winding
+    double winding;
+} ScanEdge;
+
+} // end namespace
+
 void
-Shape_Internal::render_shape(double width,
-                             double height,
-                             std::vector<bool> &image,
-                             std::string &shape) THROW
+Shape_Internal::render_path(Raster &image, const Shape::Path &path) THROW
 {
-    std::vector<std::tuple<double, double, double, double>> lines;
-    lines.reserve(500);
-    std::vector<double> last_point;
-    last_point.reserve(2);
-    std::vector<double> last_move;
-    last_move.reserve(2);
-    std::function<std::pair<double, double>(double, double, std::string &)>
-    flt([&](double x, double y, std::string &typ)
+    double width(static_cast<double>(image.width()));
+    double height(static_cast<double>(image.height()));
+    std::vector<ScanEdge> edges;
+    edges.reserve(path.coords.size() >> 1);
+    double last_point[2] = {0., 0.};
+    double last_move[2] = {0., 0.};
+    bool has_point(false), has_move(false);
+    double top(0.), bottom(0.);
+
+    // Close figure with non-horizontal line in image
+    auto add_line([&](const double *from, const double *to)
     {
+        if (from[1] != to[1] &&
+            !(from[1] < 0 && to[1] < 0) &&
+            !(from[1] > height && to[1] > height))
+        {
+            // points are integers, so scanline y + 0.5 never hits an end
+            // and the edge crosses rows min(y) to max(y) - 1
+            ScanEdge edge;
+            edge.x = from[0];
+            edge.y = from[1];
+            edge.vx = to[0] - from[0];
+            edge.vy = to[1] - from[1];
+            edge.cx = 0.;
+            edge.first = static_cast<int64_t>(std::min(from[1], to[1]));
+            edge.last = static_cast<int64_t>(std::max(from[1], to[1])) - 1;
+            edge.winding = (edge.vy > 0.) ? 1. : -1.;
+            edges.push_back(edge);
+        }
+    });
+
+    const double *coords(path.coords.data());
+    for (size_t i = 0; i < path.ops.size(); ++i)
+    {
+        uint8_t op(path.ops.at(i));
+        if (op == subfx_shapePath_close)
+        {
+            // figures are closed by the next move anyway
+            continue;
+        }
+
+        if (op == subfx_shapePath_curve)
+        {
+            throw std::invalid_argument("render_path: path is not flattened");
+        }
+
+        if (static_cast<size_t>(coords - path.coords.data()) + 2 >
+            path.coords.size())
+        {
+            throw std::invalid_argument("render_path: too few coordinates");
+        }
+
         // Use integers to avoid rounding errors
-        x = round(x);
-        y = round(y);
+        double point[2] = {round(coords[0]), round(coords[1])};
+        coords += 2;
 
-        if (typ == "m")
+        if (op == subfx_shapePath_move)
         {
-            // Close figure with non-horizontal line in image
-            if (last_move.size() != 0)
+            if (has_move)
             {
-                if ((last_move.at(1) != last_point.at(1)) &&
-                    !(last_point.at(1) < 0 && last_move.at(1) < 0) &&
-                    !(last_point.at(1) > height && last_move.at(1) > height))
-                {
-                    lines.push_back(std::make_tuple(last_point.at(0),
-                                                    last_point.at(1),
-                                                    last_move.at(0) - last_point.at(0),
-                                                    last_move.at(1) - last_point.at(1)));
-                }
+                add_line(last_point, last_move);
+            }
+
+            last_move[0] = point[0];
+            last_move[1] = point[1];
+            has_move = true;
+        }
+        else if (has_point) // Non-horizontal line in image
+        {
+            add_line(last_point, point);
+        }
 
-                last_move.at(0) = x;
-                last_move.at(1) = y;
+        if (!has_point)
+        {
+            top = point[1];
+            bottom = point[1];
+        }
+
+        top = std::min(top, point[1]);
+        bottom = std::max(bottom, point[1]);
+
+        // Remember last point
+        last_point[0] = point[0];
+        last_point[1] = point[1];
+        has_point = true;
+    }
+
+    if (has_move)
+    {
+        add_line(last_point, last_move);
+    }
+
+    // Edge table, edges enter the active list in order of their first row
+    std::sort(edges.begin(), edges.end(),
+              [](const ScanEdge &a, const ScanEdge &b)
+              {
+                  return a.first < b.first;
+              });
+
+    // Active edges, kept sorted by cx between rows,
+    // so the sort per row is an insertion sort over almost sorted data
+    std::vector<ScanEdge *> active;
+    active.reserve(edges.size());
+
+    size_t next(0);
+    int64_t row_begin(static_cast<int64_t>(std::max(top, 0.)));
+    int64_t row_end(static_cast<int64_t>(std::min(bottom, height) - 1));
+    for (int64_t y = row_begin; y <= row_end; ++y)
+    {
+        // Drop edges ending above this row
+        active.erase(std::remove_if(active.begin(), active.end(),
+                                    [y](const ScanEdge *edge)
+                                    {
+                                        return edge->last < y;
+                                    }),
+                     active.end());
+
+        // Add edges starting at this row,
+        // edges starting above the image are clipped here
+        for (; next < edges.size() && edges[next].first <= y; ++next)
+        {
+            if (edges[next].last >= y)
+            {
+                active.push_back(&edges[next]);
             }
-            else
+        }
+
+        if (active.empty())
+        {
+            continue;
+        }
+
+        // Line x horizontal line intersection
+        double scanline(static_cast<double>(y) + 0.5);
+        for (size_t i = 0; i < active.size(); ++i)
+        {
+            ScanEdge *edge(active[i]);
+            double s((scanline - edge->y) / edge->vy);
+
+            // here may throw exception
+            edge->cx = Math::trim(edge->x + s * edge->vx, 0, width);
+
+            ScanEdge *key(edge);
+            size_t j(i);
+            for (; j > 0 && active[j - 1]->cx > key->cx; --j)
             {
-                last_move.push_back(x);
-                last_move.push_back(y);
+                active[j] = active[j - 1];
             }
+
+            active[j] = key;
         }
-        else // Non-horizontal line in image
+
+        double status(0.);
+        for (size_t i = 0; i < active.size() - 1; ++i)
         {
-            if (last_point.size() != 0)
+            status += active[i]->winding;
+            if (status != 0.)
             {
-                if (last_point.at(1) != y &&
-                    !(last_point.at(1) < 0 && y < 0) &&
-                    !(last_point.at(1) > height && y > height))
+                // cx is trimmed to [0, width], so the span stays in the row
+                double x0(ceil(active[i]->cx - 0.5));
+                double x1(floor(active[i + 1]->cx + 0.5));
+                if (x1 > x0)
                 {
-                    lines.push_back(std::make_tuple(last_point.at(0),
-                                                    last_point.at(1),
-                                                    x - last_point.at(0),
-                                                    y - last_point.at(1)));
+                    image.fill(static_cast<size_t>(y),
+                               static_cast<size_t>(x0),
+                               static_cast<size_t>(x1));
                 }
             }
-        }
+        } // end for i
+    } // end for y
+}
 
-        // Remember last point
-        if (last_point.size() != 0)
+void
+Shape_Internal::extract_pixels(const Raster &img_data,
+                               double shift_x,
+                               double shift_y,
+                               Shape::PixelBuffer &pixels) THROW
+{
+    uint8_t upscale(SUPERSAMPLING);
+    double downscale(0.125); // 1 / 8
+    size_t blocks_x(img_data.width() / upscale);
+    size_t blocks_y(img_data.height() / upscale);
+    pixels.x.reserve(pixels.x.size() + blocks_x * blocks_y);
+    pixels.y.reserve(pixels.y.size() + blocks_x * blocks_y);
+    pixels.alpha.reserve(pixels.alpha.size() + blocks_x * blocks_y);
+
+    // one count per 8 samples, rounded up to whole words
+    std::vector<uint8_t> counts(((img_data.width() + 63) >> 6) << 3);
+    for (size_t by = 0; by < blocks_y; ++by)
+    {
+        img_data.count_blocks(by, counts.data());
+        for (size_t bx = 0; bx < blocks_x; ++bx)
         {
-            last_point.at(0) = x;
-            last_point.at(1) = y;
+            if (counts[bx] == 0)
+            {
+                continue;
+            }
+
+            double opacity(static_cast<double>(counts[bx]) * 255.);
+            pixels.alpha.push_back(static_cast<uint8_t>(opacity * (downscale * downscale)));
+            pixels.x.push_back((static_cast<double>(bx * upscale) - shift_x) * downscale);
+            pixels.y.push_back((static_cast<double>(by * upscale) - shift_y) * downscale);
+        } // end for bx
+    } // end for by
+}
+
+namespace
+{
+
+// Adds the area line x0, y0 to x1, y1 covers in every cell it crosses,
+// the rest of the row gets the cover as difference in the next cell
+void accumulate_line(float *cells,
+                     size_t width,
+                     size_t height,
+                     double x0, double y0,
+                     double x1, double y1) NOTHROW
+{
+    if (y0 == y1)
+    {
+        return;
+    }
+
+    double dir(1.);
+    if (y0 > y1)
+    {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+        dir = -1.;
+    }
+
+    double dxdy((x1 - x0) / (y1 - y0));
+    double x(x0);
+    int64_t y(static_cast<int64_t>(floor(y0)));
+    if (y0 < 0.)
+    {
+        x -= y0 * dxdy;
+        y = 0;
+    }
+
+    size_t stride(width + 2);
+    double right(static_cast<double>(width));
+    int64_t end(std::min(static_cast<int64_t>(height),
+                         static_cast<int64_t>(ceil(y1))));
+    for (; y < end; ++y)
+    {
+        float *row(cells + static_cast<size_t>(y) * stride);
+        double dy(std::min(static_cast<double>(y + 1), y1) -
+                  std::max(static_cast<double>(y), y0));
+        double xnext(x + dxdy * dy);
+        double d(dy * dir);
+
+        // the part of the line in this row spans cells a to b
+        double a(std::min(std::max(std::min(x, xnext), 0.), right));
+        double b(std::max(std::min(std::max(x, xnext), right), 0.));
+        double a_floor(floor(a)), b_ceil(ceil(b));
+        size_t ai(static_cast<size_t>(a_floor));
+        size_t bi(static_cast<size_t>(b_ceil));
+        if (bi <= ai + 1)
+        {
+            // within one cell, area is the trapezoid right of the line
+            double mid(0.5 * (a + b) - a_floor);
+            row[ai] += static_cast<float>(d - d * mid);
+            row[ai + 1] += static_cast<float>(d * mid);
         }
         else
         {
-            last_point.push_back(x);
-            last_point.push_back(y);
+            // the first and last cells get triangles,
+            // the ones between get equal slices
+            double s(1. / (b - a));
+            double a_frac(a - a_floor);
+            double first(0.5 * s * (1. - a_frac) * (1. - a_frac));
+            double b_frac(b - b_ceil + 1.);
+            double last(0.5 * s * b_frac * b_frac);
+            row[ai] += static_cast<float>(d * first);
+            if (bi == ai + 2)
+            {
+                row[ai + 1] += static_cast<float>(d * (1. - first - last));
+            }
+            else
+            {
+                double second(s * (1.5 - a_frac));
+                row[ai + 1] += static_cast<float>(d * (second - first));
+                for (size_t i = ai + 2; i < bi - 1; ++i)
+                {
+                    row[i] += static_cast<float>(d * s);
+                }
+
+                double before_last(second +
+                                   static_cast<double>(bi - ai - 3) * s);
+                row[bi - 1] +=
+                        static_cast<float>(d * (1. - before_last - last));
+            }
+
+            row[bi] += static_cast<float>(d * last);
         }
 
-        return std::pair<double, double>();
-    });
+        x = xnext;
+    } // end for y
+}
 
-    std::string shapeBak(shape);
+} // end namespace
 
-    // here may throw exception
-    shapeBak = Shape::flatten(shapeBak);
-    // here may throw exception
-    Shape::filter(shapeBak, flt);
+void
+Shape_Internal::render_coverage(size_t width,
+                                size_t height,
+                                std::vector<float> &cells,
+                                const Shape::Path &path) THROW
+{
+    if (cells.size() < (width + 2) * height)
+    {
+        throw std::invalid_argument("render_coverage: cells are too small");
+    }
+
+    double last_point[2] = {0., 0.};
+    double last_move[2] = {0., 0.};
+    bool has_point(false), has_move(false);
 
-    if (last_move.size() > 0)
+    const double *coords(path.coords.data());
+    for (size_t i = 0; i < path.ops.size(); ++i)
     {
-        if (last_move.at(1) != last_point.at(1) &&
-            !(last_point.at(1) < 0 && last_move.at(1) < 0) &&
-            !(last_point.at(1) > height && last_move.at(1) > height))
+        uint8_t op(path.ops.at(i));
+        if (op == subfx_shapePath_close)
         {
-            lines.push_back(std::make_tuple(last_point.at(0),
-                                            last_point.at(1),
-                                            last_move.at(0) - last_point.at(0),
-                                            last_move.at(1) - last_point.at(1)));
+            // figures are closed by the next move anyway
+            continue;
         }
-    }
 
-    // Calculates line x horizontal line intersection
-    std::function<std::vector<double>(double, double, double, double, double)>
-    line_x_hline([](double x, double y, double vx, double vy, double y2)
-    {
-        std::vector<double> ret;
-        ret.reserve(2);
-        if (vy != 0.)
+        if (op == subfx_shapePath_curve)
         {
-            double s((y2 - y) / vy);
-            if (s >= 0. && s <= 1.)
-            {
-                ret.push_back(x + s * vx);
-                ret.push_back(y2);
-            }
+            throw std::invalid_argument("render_coverage: path is not flattened");
         }
 
-        return ret;
-    });
+        if (static_cast<size_t>(coords - path.coords.data()) + 2 >
+            path.coords.size())
+        {
+            throw std::invalid_argument("render_coverage: too few coordinates");
+        }
 
-    double tmpDouble;
-    // here may throw exception
-    auto tmpTuple(Shape::bounding(shape));
-    for (double y = std::max(floor(std::get<1>(tmpTuple)), 0.);
-         y <= (std::min(ceil(std::get<3>(tmpTuple)), height) - 1);
-         ++y)
-    {
-        std::vector<std::pair<double, double>> row_stops;
-        row_stops.reserve(lines.size());
+        // no rounding, coverage is exact
+        double point[2] = {coords[0], coords[1]};
+        coords += 2;
 
-        for (size_t i = 0; i < lines.size(); ++i)
+        if (op == subfx_shapePath_move)
         {
-            auto line(lines.at(i));
-            std::vector<double> cx(line_x_hline(std::get<0>(line),
-                                                std::get<1>(line),
-                                                std::get<2>(line),
-                                                std::get<3>(line),
-                                                y + 0.5));
-            if (cx.size() != 0)
+            if (has_move)
             {
-                // here may throw exception
-                tmpDouble = Math::trim(cx.at(0), 0, width);
-                row_stops.push_back(std::make_pair(tmpDouble,
-                                    std::get<3>(line) > 0. ? 1. : -1.));
+                accumulate_line(cells.data(), width, height,
+                                last_point[0], last_point[1],
+                                last_move[0], last_move[1]);
             }
-        } //end for i
 
-        if (row_stops.size() > 0)
+            last_move[0] = point[0];
+            last_move[1] = point[1];
+            has_move = true;
+        }
+        else if (has_point)
         {
-            std::sort(row_stops.begin(), row_stops.end(), [](const std::pair<double, double> &a,
-                                                        const std::pair<double, double> &b)
-                                                        {
-                                                            return (a.first < b.first);
-                                                        });
-            double status(0.), row_index(y * width);
-            for (size_t i = 0; i < row_stops.size() - 1; ++i)
-            {
-                status += row_stops.at(i).second;
-                if (status != 0.)
-                {
-                    for (double x = ceil(row_stops.at(i).first - 0.5);
-                         x <= (floor(row_stops.at(i + 1).first + 0.5) - 1);
-                         ++x)
-                    {
-                        image.at(static_cast<size_t>(row_index + x)) = true;
-                    } // end for x
-                }
-            } // end for i
+            accumulate_line(cells.data(), width, height,
+                            last_point[0], last_point[1],
+                            point[0], point[1]);
         }
+
+        last_point[0] = point[0];
+        last_point[1] = point[1];
+        has_point = true;
+    }
+
+    if (has_move)
+    {
+        accumulate_line(cells.data(), width, height,
+                        last_point[0], last_point[1],
+                        last_move[0], last_move[1]);
+    }
+}
+
+void
+Shape_Internal::extract_coverage(size_t width,
+                                 size_t height,
+                                 std::vector<float> &cells,
+                                 double shift_x,
+                                 double shift_y,
+                                 Shape::PixelBuffer &pixels) THROW
+{
+    pixels.x.reserve(pixels.x.size() + width * height);
+    pixels.y.reserve(pixels.y.size() + width * height);
+    pixels.alpha.reserve(pixels.alpha.size() + width * height);
+    size_t stride(width + 2);
+    for (size_t y = 0; y < height; ++y)
+    {
+        const float *row(cells.data() + y * stride);
+
+        // the running sum is the winding, clamped like non-zero filling
+        double sum(0.);
+        for (size_t x = 0; x < width; ++x)
+        {
+            sum += row[x];
+            double coverage(std::min(fabs(sum), 1.));
+            uint8_t alpha(static_cast<uint8_t>(coverage * 255. + 0.5));
+            if (alpha > 0)
+            {
+                pixels.alpha.push_back(alpha);
+                pixels.x.push_back(static_cast<double>(x) - shift_x);
+                pixels.y.push_back(static_cast<double>(y) - shift_y);
+            }
+        } // end for x
     } // end for y
 }
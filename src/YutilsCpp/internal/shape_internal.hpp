@@ -20,9 +20,14 @@
 #pragma once
 
 #include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <map>
 #include <string>
+#include <stdexcept>
 
 #include "internal/basecommon.h"
+#include "../shape.hpp"
 
 namespace PROJ_NAMESPACE
 {
@@ -33,35 +38,253 @@ namespace Yutils
 namespace Shape_Internal
 {
 
-// 4th degree curve subdivider
+// Lexer helpers, they match what the regexes of the old filter matched
+// for filter
+
+// \s in the "C" locale
+inline bool is_space(char c) NOTHROW
+{
+    return c == ' ' || c == '\t' || c == '\n' ||
+           c == '\v' || c == '\f' || c == '\r';
+}
+
+// c is one of types, types must not contain '\0'
+inline bool is_type(char c, const char *types) NOTHROW
+{
+    for (; *types != '\0'; ++types)
+    {
+        if (*types == c) return true;
+    }
+
+    return false;
+}
+
+// first non space character at or after pos
+inline const char *skip_spaces(const char *pos, const char *end) NOTHROW
+{
+    while (pos != end && is_space(*pos)) ++pos;
+    return pos;
+}
+
+// length of -?\d+\.?\d* at pos, 0 if nothing matches
+size_t number_length(const char *, const char *) NOTHROW;
+
+// parses exactly len characters that number_length matched
+double to_double(const char *, size_t) THROW;
+
+// Walks the points of an ASS shape the way filter reads them,
+// on_type(char) gets every command, on_point(char, double, double)
+// every point with the command it belongs to.
+// for filter, bounding and transform
+template<typename TypeFunc, typename PointFunc>
+void for_each_point(const std::string &shape,
+                    TypeFunc on_type,
+                    PointFunc on_point) THROW
+{
+    typedef enum _FLT_STATUS
+    {
+        start, detect_type, read_data
+    } FLT_STATUS;
+
+    // walk the shape once, every token is matched in place
+    const char *pos(shape.data());
+    const char *end(pos + shape.size());
+    const char *next(nullptr);
+    size_t len1(0), len2(0);
+    FLT_STATUS status(start);
+    char shapeType('\0');
+    while (pos != end)
+    {
+        if ((static_cast<uint8_t>(*pos) & 0x80) != 0)
+        {
+            // input is not ascii
+            throw std::invalid_argument("filter: input is out of ASCII!");
+        }
+
+        switch (status)
+        {
+        case start:
+        {
+            // ^([mnlbsp])(\s+)
+            if (is_type(*pos, "mnlbsp") &&
+                (pos + 1) != end &&
+                is_space(pos[1]))
+            {
+                status = read_data;
+                shapeType = *pos;
+                pos = skip_spaces(pos + 1, end);
+                on_type(shapeType);
+            }
+            else
+            {
+                throw std::invalid_argument("filter: shape syntax error: "
+                                            "unexpected token in the begging of shape.");
+            }
+
+            continue; // goto next loop
+        }
+        case detect_type:
+        {
+            // ^([mnlbspc])(\s*)
+            if (is_type(*pos, "mnlbspc"))
+            {
+                status = read_data;
+                shapeType = *pos;
+                pos = skip_spaces(pos + 1, end);
+                on_type(shapeType);
+            }
+            else
+            {
+                std::string err(1, *pos);
+                err = "filter: shape syntax error: expect m, n, l, b, s, p "
+                      "or c, but get " + err + " .";
+                throw std::invalid_argument(err);
+            }
+
+            continue; // goto next loop
+        }
+        default: // read data
+        {
+            if (shapeType == 'c')
+            {
+                status = detect_type;
+                continue;
+            }
+
+            // ^(-?\d+\.?\d*)(\s+)(-?\d+\.?\d*)(\s*)
+            len1 = number_length(pos, end);
+            next = pos + len1;
+            if (len1 == 0 || next == end || !is_space(*next))
+            {
+                status = detect_type;
+                continue;
+            }
+
+            next = skip_spaces(next, end);
+            len2 = number_length(next, end);
+            if (len2 == 0)
+            {
+                status = detect_type;
+                continue;
+            }
+
+            double x(to_double(pos, len1));
+            double y(to_double(next, len2));
+            pos = skip_spaces(next + len2, end);
+            on_point(shapeType, x, y);
+            break;
+        }
+        } //end switch
+    } // end while (pos != end)
+}
+
+// Flatness tolerance of curve4_to_lines, made by curve_angle_tolerance
+// or curve_distance_tolerance, so no trigonometry runs per curve
+typedef struct CurveTolerance
+{
+    // cosine of the largest angle between control polygon segments
+    // and its square, used when max_dist2 is 0
+    double min_cos;
+
+    double min_cos2;
+
+    // square of the largest distance of the control points to the chord
+    double max_dist2;
+} CurveTolerance;
+
+// Flat when every angle of the control polygon is at most degree,
+// the test the acos based version made
+CurveTolerance curve_angle_tolerance(double degree) NOTHROW;
+
+// Flat when both control points are at most distance from the chord
+CurveTolerance curve_distance_tolerance(double distance) NOTHROW;
+
+// 4th degree curve subdivider, curve holds x0, y0 to x3, y3,
+// halves gets both curves, 16 numbers
 // for flatten
-std::vector<double> curve4_subdivide(double, double,
-                                     double, double,
-                                     double, double,
-                                     double, double,
-                                     double) NOTHROW;
+void curve4_subdivide(const double *, double, double *) NOTHROW;
 
-// Check flatness of 4th degree curve with angles
+// Check flatness of 4th degree curve of 8 numbers
 // for flatten
-bool curve4_is_flat(double, double,
-                    double, double,
-                    double, double,
-                    double, double,
-                    double) NOTHROW;
+bool curve4_is_flat(const double *, const CurveTolerance &) NOTHROW;
 
-// Convert 4th degree curve to line points
+// Convert 4th degree curve of 8 numbers to line points, the end point of
+// every line is appended to the buffer, the start point is not
 // for flatten
-std::vector<double> curve4_to_lines(double, double,
-                                    double, double,
-                                    double, double,
-                                    double, double) NOTHROW;
+void curve4_to_lines(const double *,
+                     std::vector<double> &,
+                     const CurveTolerance &) THROW;
+
+// Same as above with the default tolerance, angles below 1 degree
+void curve4_to_lines(const double *, std::vector<double> &) THROW;
+
+// Binary image of the supersampled renderer, every row is a span of
+// 64 bit words, sample x of a row is bit x % 64 of word x / 64.
+// Memory is only grown, keep one to render many shapes.
+class Raster
+{
+public:
+
+    Raster() NOTHROW;
+
+    // Resizes to width x height samples, all cleared
+    void reset(size_t width, size_t height) THROW;
+
+    size_t width() const NOTHROW;
+
+    size_t height() const NOTHROW;
+
+    // Sets samples x0 to x1 - 1 of row y, whole words at a time
+    void fill(size_t y, size_t x0, size_t x1) NOTHROW;
+
+    bool at(size_t x, size_t y) const NOTHROW;
 
-// Renderer (on binary image with aliasing)
+    // Counts set samples of every 8x8 block in block row by,
+    // counts needs one byte per 8 samples of a row
+    void count_blocks(size_t by, uint8_t *counts) const NOTHROW;
+
+private:
+
+    size_t m_width;
+
+    size_t m_height;
+
+    // words per row
+    size_t m_stride;
+
+    std::vector<uint64_t> m_words;
+
+};
+
+// Renderer (on binary image with aliasing),
+// path has to be flattened already
+// for to_pixels
+void render_path(Raster &, const Shape::Path &) THROW;
+
+// Downsamples the rendered image to pixels
 // for to_pixels
-void render_shape(double,
-                  double,
-                  std::vector<bool> &,
-                  std::string &) THROW;
+void extract_pixels(const Raster &,
+                    double,
+                    double,
+                    Shape::PixelBuffer &) THROW;
+
+// Accumulates the signed area and cover of every line of path into cells,
+// width + 2 cells per row, path has to be flattened and shifted to
+// the origin already
+// for to_pixels with PixelMode::coverage
+void render_coverage(size_t,
+                     size_t,
+                     std::vector<float> &,
+                     const Shape::Path &) THROW;
+
+// Sums the cells of every row up to the alpha of its pixels
+// for to_pixels with PixelMode::coverage
+void extract_coverage(size_t,
+                      size_t,
+                      std::vector<float> &,
+                      double,
+                      double,
+                      Shape::PixelBuffer &) THROW;
 
 } // end namespace Shape_Internal
 
@@ -1,4 +1,6 @@
 #include <new>
+#include <stdexcept>
+#include <algorithm>
 
 #include "YutilsCpp"
 
@@ -103,3 +105,67 @@ Matrix::transform(double x, double y, double z, double w) NOTHROW
     Eigen::Vector4d v(x, y, z, w);
     return v.adjoint() * m_data;
 }
+
+// Points as rows, so a block of them times the matrix is what transform
+// does for one, and Eigen runs it vectorized.
+// Blocks have a fixed maximum size, so nothing is allocated.
+template<int Dim>
+static void transformRows(const Eigen::Matrix4d &matrix,
+                          double *points,
+                          size_t count,
+                          bool perspective) NOTHROW
+{
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Dim, Eigen::RowMajor> Points;
+    static const Eigen::Index blockSize(256);
+
+    Eigen::Map<Points> input(points, static_cast<Eigen::Index>(count), Dim);
+    Eigen::Matrix<double, Eigen::Dynamic, 4, Eigen::ColMajor, blockSize, 4> result;
+    for (Eigen::Index i = 0; i < input.rows(); i += blockSize)
+    {
+        Eigen::Index rows(std::min(blockSize, input.rows() - i));
+        auto block(input.middleRows(i, rows));
+
+        // (x, y[, z], 1) * matrix
+        result.noalias() = block * matrix.topRows<Dim>();
+        result.rowwise() += matrix.row(3);
+        if (perspective)
+        {
+            block = result.leftCols<Dim>().array().colwise() /
+                    result.col(3).array();
+        }
+        else
+        {
+            block = result.leftCols<Dim>();
+        }
+    }
+}
+
+void Matrix::transformPoints(double *points,
+                             size_t count,
+                             uint8_t dimension,
+                             bool perspective) const THROW
+{
+    if (!points && count)
+    {
+        throw std::invalid_argument("transformPoints: points is NULL.");
+    }
+
+    switch (dimension)
+    {
+    case 2:
+    {
+        transformRows<2>(m_data, points, count, perspective);
+        break;
+    }
+    case 3:
+    {
+        transformRows<3>(m_data, points, count, perspective);
+        break;
+    }
+    default:
+    {
+        throw std::invalid_argument("transformPoints: "
+                                    "dimension must be 2 or 3.");
+    }
+    } //end switch (dimension)
+}
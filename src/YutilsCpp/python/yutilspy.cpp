@@ -20,6 +20,8 @@
 #include "pybind11/stl.h"
 #include "pybind11/attr.h"
 #include "pybind11/functional.h"
+#include "pybind11/eigen.h"
+#include "pybind11/numpy.h"
 
 #include "internal/basecommon.h"
 #include "YutilsCpp"
@@ -28,6 +30,15 @@ namespace py = pybind11;
 
 using namespace PROJ_NAMESPACE::Yutils;
 
+// NumPy array on the data of vec, owner keeps vec alive, nothing is copied
+template<typename T>
+static py::array_t<T> arrayView(std::vector<T> &vec, py::handle owner)
+{
+    return py::array_t<T>(static_cast<py::ssize_t>(vec.size()),
+                          vec.data(),
+                          owner);
+}
+
 PYBIND11_MODULE(SubFX_YutilsPy, m)
 {
     m.doc() = "This is core library for SubFX, a modified version of Yutils.";
@@ -128,16 +139,86 @@ PYBIND11_MODULE(SubFX_YutilsPy, m)
     "rotated_point = rotate(point, axis, angle)\n"
     "Allows to rotate a point in 3D room.\n");
 
+    /* in matrix.hpp */
+    py::class_<Math::Matrix, std::shared_ptr<Math::Matrix>>(math, "Matrix")
+    .def_static("create", &Math::Matrix::create,
+    "matrix = create()\n"
+    "Creates an identity matrix.\n")
+
+    .def("data", &Math::Matrix::data,
+    "data = data()\n"
+    "Returns the 4x4 matrix as numpy.ndarray.\n")
+
+    .def("setData", &Math::Matrix::setData,
+    "setData(data)\n"
+    "Replaces the matrix by a 4x4 numpy.ndarray.\n")
+
+    .def("identity", &Math::Matrix::identity,
+    "identity()\n"
+    "Resets the matrix to identity.\n")
+
+    .def("multiply", &Math::Matrix::multiply,
+    "multiply(other)\n"
+    "Multiplies the matrix by other.\n")
+
+    .def("translate", &Math::Matrix::translate,
+    "translate(x, y, z)\n"
+    "Adds a translation.\n")
+
+    .def("scale", &Math::Matrix::scale,
+    "scale(x, y, z)\n"
+    "Adds a scale.\n")
+
+    .def("rotate", &Math::Matrix::rotate,
+    "rotate(axis, angle)\n"
+    "Adds a rotation around axis x, y or z by angle in radian.\n")
+
+    .def("inverse", &Math::Matrix::inverse,
+    "inverse()\n"
+    "Inverts the matrix.\n")
+
+    .def("transform", &Math::Matrix::transform,
+    "vector = transform(x, y, z, w)\n"
+    "Applies the matrix to a point as row vector.\n")
+
+    .def("transformPoints", [](const Math::Matrix &matrix,
+                               py::array_t<double, py::array::c_style> points,
+                               bool perspective)
+    {
+        // checked before the cast, a shape of 258 must not become 2
+        if (points.ndim() != 2 ||
+            (points.shape(1) != 2 && points.shape(1) != 3))
+        {
+            throw py::value_error("transformPoints: "
+                                  "points must have shape (N, 2) or (N, 3).");
+        }
+
+        matrix.transformPoints(points.mutable_data(),
+                               static_cast<size_t>(points.shape(0)),
+                               static_cast<uint8_t>(points.shape(1)),
+                               perspective);
+    },
+    py::arg("points").noconvert(),
+    py::arg("perspective") = false,
+    "transformPoints(points[, perspective])\n"
+    "Applies the matrix in place to a C contiguous float64 "
+    "numpy.ndarray of shape (N, 2) or (N, 3), z is 0 for 2D points "
+    "and w is 1.\n"
+    "If perspective is true, results are divided by their w.\n"
+    "Other arrays are not converted, so results are never lost in a copy.\n");
+
     /* in shape.hpp */
     auto shape(m.def_submodule("Shape"));
 
-    shape.def("bounding", &Shape::bounding,
+    shape.def("bounding", py::overload_cast<std::string &>(&Shape::bounding),
     "tuple(x0, y0, x1, y1) = bounding(shape)\n"
     "Calculates the bounding box of shape shape.\n"
     "x0|y0 is the upper-left and "
     "x1|y1 the lower-right corner of the rectangle.\n");
 
-    shape.def("filter", &Shape::filter,
+    shape.def("filter", py::overload_cast<std::string &,
+              std::function<std::pair<double, double>(double, double, std::string &)> &>(
+              &Shape::filter),
     "new_shape = filter(shape, flt)\n"
     "Filters points of shape shape by function flt and returns a new one.\n"
     "flt receives point coordinates x and y as well as the point type"
@@ -156,23 +237,207 @@ PYBIND11_MODULE(SubFX_YutilsPy, m)
     "test = \"m 1 2 l 3 4 5 6 b 7 8 9 10 11 12 13 14 c\"\n"
     "print(shape.filter(test, flt))\n");
 
-    shape.def("flatten", &Shape::flatten,
+    shape.def("flatten", py::overload_cast<std::string &>(&Shape::flatten),
     "flattened_shape = flatten(shape)\n"
     "Converts all 3rd order bezier curves in shape shape to lines,\n"
     "creating a new shape.\n");
 
-    shape.def("move", &Shape::move,
+    shape.def("move", py::overload_cast<std::string &, double, double>(&Shape::move),
     "new_shape = move(shape, x, y)\n"
     "Shifts points of shape shape horizontally by x and vertically by y,\n"
     "creating a new shape.\n");
 
-    shape.def("to_pixels", &Shape::to_pixels,
-    "pixels = to_pixels(shape)\n"
+    shape.def("transform", py::overload_cast<std::string &,
+              const Math::Matrix &, bool, double>(&Shape::transform),
+              py::arg("shape"),
+              py::arg("matrix"),
+              py::arg("project") = false,
+              py::arg("perspective_z") = 0.,
+    "new_shape = transform(shape, matrix[, project[, perspective_z]])\n"
+    "Applies matrix to all points in one pass, new points are x and y of "
+    "matrix.transform(x, y, 0, 1).\n"
+    "If project is True, they are divided by its w, and if perspective_z is "
+    "greater than 0, projected to z = 0 as seen from distance "
+    "perspective_z.\n"
+    "Curves are converted to lines if a projection is not affine.\n");
+
+    py::enum_<Shape::PixelMode>(shape, "PixelMode")
+    .value("supersampling", Shape::PixelMode::supersampling)
+    .value("coverage", Shape::PixelMode::coverage);
+
+    shape.def("to_pixels", py::overload_cast<std::string &, Shape::PixelMode>(
+              &Shape::to_pixels),
+              py::arg("shape"),
+              py::arg("mode") = Shape::PixelMode::supersampling,
+    "pixels = to_pixels(shape[, mode])\n"
     "Renders shape shape and returns pixels.\n"
     "pixels is a list of dictionaries, each one with following fields:\n"
     "x: horizontal position\n"
     "y: vertical position\n"
-    "alpha: opacity\n");
+    "alpha: opacity\n"
+    "mode is PixelMode.supersampling (default), which renders at 8x "
+    "resolution, or PixelMode.coverage, which computes the covered area "
+    "of every pixel directly and is much faster.\n");
+
+    py::class_<Shape::PixelBuffer, std::shared_ptr<Shape::PixelBuffer>>(
+        shape, "PixelBuffer")
+    .def(py::init())
+    .def_property_readonly("x", [](py::object self)
+    {
+        return arrayView(self.cast<Shape::PixelBuffer &>().x, self);
+    },
+    "numpy.ndarray of float64, horizontal positions\n")
+
+    .def_property_readonly("y", [](py::object self)
+    {
+        return arrayView(self.cast<Shape::PixelBuffer &>().y, self);
+    },
+    "numpy.ndarray of float64, vertical positions\n")
+
+    .def_property_readonly("alpha", [](py::object self)
+    {
+        return arrayView(self.cast<Shape::PixelBuffer &>().alpha, self);
+    },
+    "numpy.ndarray of uint8, opacities\n")
+
+    .def("__len__", [](const Shape::PixelBuffer &pixels)
+    {
+        return pixels.alpha.size();
+    });
+
+    shape.def("to_pixel_buffer", py::overload_cast<std::string &, Shape::PixelMode>(
+              &Shape::to_pixel_buffer),
+              py::arg("shape"),
+              py::arg("mode") = Shape::PixelMode::supersampling,
+    "pixels = to_pixel_buffer(shape[, mode])\n"
+    "Same as to_pixels(shape, mode), but returns a PixelBuffer.\n"
+    "Its x, y and alpha are numpy arrays on the rendered data, "
+    "no dictionary is built and nothing is copied.\n");
+
+    shape.def("to_maps", &Shape::to_maps,
+    "pixels = to_maps(buffer)\n"
+    "Converts a PixelBuffer to the list of dictionaries to_pixels returns.\n");
+
+    py::class_<Shape::Path, std::shared_ptr<Shape::Path>>(shape, "Path")
+    .def(py::init())
+    .def_readwrite("ops", &Shape::Path::ops)
+    .def_readwrite("coords", &Shape::Path::coords);
+
+    shape.def("bounding", py::overload_cast<const Shape::Path &>(&Shape::bounding),
+    "tuple(x0, y0, x1, y1) = bounding(path)\n"
+    "Same as bounding(shape), but on a path from FontHandle.text_to_path.\n");
+
+    shape.def("filter", py::overload_cast<const Shape::Path &,
+              std::function<std::pair<double, double>(double, double, std::string &)> &>(
+              &Shape::filter),
+    "new_path = filter(path, flt)\n"
+    "Same as filter(shape, flt), but on a path.\n");
+
+    shape.def("flatten", py::overload_cast<const Shape::Path &>(&Shape::flatten),
+    "flattened_path = flatten(path)\n"
+    "Same as flatten(shape), but on a path.\n");
+
+    shape.def("move", py::overload_cast<const Shape::Path &, double, double>(&Shape::move),
+    "new_path = move(path, x, y)\n"
+    "Same as move(shape, x, y), but on a path.\n");
+
+    shape.def("transform", py::overload_cast<const Shape::Path &,
+              const Math::Matrix &, bool, double>(&Shape::transform),
+              py::arg("path"),
+              py::arg("matrix"),
+              py::arg("project") = false,
+              py::arg("perspective_z") = 0.,
+    "new_path = transform(path, matrix[, project[, perspective_z]])\n"
+    "Same as transform(shape, matrix, project, perspective_z), "
+    "but on a path.\n");
+
+    shape.def("to_pixels", py::overload_cast<const Shape::Path &, Shape::PixelMode>(
+              &Shape::to_pixels),
+              py::arg("path"),
+              py::arg("mode") = Shape::PixelMode::supersampling,
+    "pixels = to_pixels(path[, mode])\n"
+    "Same as to_pixels(shape), but on a path, "
+    "no text is formatted or parsed.\n");
+
+    shape.def("to_pixel_buffer", py::overload_cast<const Shape::Path &, Shape::PixelMode>(
+              &Shape::to_pixel_buffer),
+              py::arg("path"),
+              py::arg("mode") = Shape::PixelMode::supersampling,
+    "pixels = to_pixel_buffer(path[, mode])\n"
+    "Same as to_pixel_buffer(shape), but on a path.\n");
+
+    shape.def("to_shape", &Shape::to_shape,
+    "shape = to_shape(path)\n"
+    "Formats path as an ASS shape.\n");
+
+    shape.def("to_path", &Shape::to_path,
+    "path = to_path(shape)\n"
+    "Parses an ASS shape into a path.\n"
+    "Points after n, s and p are kept as lines.\n");
+
+    /* in shapepath.hpp */
+    py::class_<ShapePath, std::shared_ptr<ShapePath>>(m, "ShapePath")
+    .def(py::init())
+    .def(py::init<const std::string &>())
+    .def(py::init<const Shape::Path &>())
+    .def("move", &ShapePath::move,
+         py::return_value_policy::reference_internal,
+    "self = move(x, y)\n"
+    "Shifts points horizontally by x and vertically by y.\n"
+    "Transforms are recorded and applied in one pass "
+    "when the points are needed.\n")
+
+    .def("scale", &ShapePath::scale,
+         py::return_value_policy::reference_internal,
+    "self = scale(x, y)\n"
+    "Scales points around the origin.\n")
+
+    .def("rotate", &ShapePath::rotate,
+         py::return_value_policy::reference_internal,
+    "self = rotate(angle)\n"
+    "Rotates points around the origin by angle in degree.\n")
+
+    .def("transform", py::overload_cast<const Math::Matrix &>(&ShapePath::transform),
+         py::return_value_policy::reference_internal,
+    "self = transform(matrix)\n"
+    "Points become x and y of matrix.transform(x, y, 0, 1).\n")
+
+    .def("transform", py::overload_cast<const Eigen::Matrix4d &>(&ShapePath::transform),
+         py::return_value_policy::reference_internal,
+    "self = transform(data)\n"
+    "Same as above, but on a 4x4 array such as Matrix.data().\n")
+
+    .def("filter", &ShapePath::filter,
+         py::return_value_policy::reference_internal,
+    "self = filter(flt)\n"
+    "Same as Shape.filter, but in place.\n")
+
+    .def("flatten", &ShapePath::flatten,
+         py::return_value_policy::reference_internal,
+    "self = flatten()\n"
+    "Converts all curves to lines.\n")
+
+    .def("bounding", &ShapePath::bounding,
+    "tuple(x0, y0, x1, y1) = bounding()\n"
+    "Same as Shape.bounding.\n")
+
+    .def("to_pixels", &ShapePath::to_pixels,
+         py::arg("mode") = Shape::PixelMode::supersampling,
+    "pixels = to_pixels([mode])\n"
+    "Same as Shape.to_pixels.\n")
+
+    .def("to_pixel_buffer", &ShapePath::to_pixel_buffer,
+         py::arg("mode") = Shape::PixelMode::supersampling,
+    "pixels = to_pixel_buffer([mode])\n"
+    "Same as Shape.to_pixel_buffer.\n")
+
+    .def("to_shape", &ShapePath::to_shape,
+    "shape = to_shape()\n"
+    "Formats the path as an ASS shape.\n")
+
+    .def("path", &ShapePath::path,
+    "path = path()\n"
+    "Returns a copy of the path as Shape.Path.\n");
 
     /* in ass.hpp */
     auto ass(m.def_submodule("Ass"));
@@ -534,6 +799,16 @@ PYBIND11_MODULE(SubFX_YutilsPy, m)
     /* in asswriter.hpp */
     auto assWriter(m.def_submodule("AssWriter"));
 
+    assWriter.def("setBufferSize", &AssWriter::setBufferSize,
+    "setBufferSize(size)\n"
+    "Output is collected in a buffer of size bytes and written "
+    "when it is full, 1 MiB by default.\n"
+    "size must be within 64 KiB and 64 MiB.\n");
+
+    assWriter.def("bufferSize", &AssWriter::bufferSize,
+    "size = bufferSize()\n"
+    "Returns the buffer size of write.\n");
+
     assWriter.def("write",
                   py::overload_cast<const char *,
                   std::shared_ptr<AssParser> &>(&AssWriter::write),
@@ -564,6 +839,36 @@ PYBIND11_MODULE(SubFX_YutilsPy, m)
     "write(meta, styles, assBuf)\n"
     "Write all contents by providing meta, styles and assbuf.\n");
 
+    py::class_<AssWriter::Sink, std::shared_ptr<AssWriter::Sink>>(assWriter, "Sink")
+    .def(py::init<const char *,
+         std::shared_ptr<AssMeta> &,
+         std::map<std::string, std::shared_ptr<AssStyle>> &>(),
+    "sink = Sink(fileName, meta, styles)\n"
+    "Writes meta, styles and the event header to fileName, "
+    "events follow with write while they are made.\n"
+    "Only bufferSize() bytes of events are kept in memory.\n")
+
+    .def(py::init<const char *>(),
+    "sink = Sink(fileName)\n"
+    "Writes events only, e.g. a part of the events of a file, "
+    "which is joined to it later.\n")
+
+    .def("write", &AssWriter::Sink::write,
+    "write(events)\n"
+    "Writes a list of strings as event lines.\n")
+
+    .def("flush", &AssWriter::Sink::flush,
+    "flush()\n"
+    "Hands the buffered events to the file.\n")
+
+    .def("close", &AssWriter::Sink::close,
+    "close()\n"
+    "Flushes and closes the file.\n")
+
+    .def("events", &AssWriter::Sink::events,
+    "count = events()\n"
+    "Returns the number of event lines written so far.\n");
+
     /* in fonthandle.hpp */
     py::class_<FontHandle, std::shared_ptr<FontHandle>>(m, "FontHandle")
     .def_static("create", &FontHandle::create,
@@ -606,5 +911,11 @@ PYBIND11_MODULE(SubFX_YutilsPy, m)
     .def("text_to_shape", &FontHandle::text_to_shape,
     "shape = text_to_shape(text)\n"
     "Converts text with given font to an ASS shape.\n"
-    "If failed, it will return an empty string.\n");
+    "If failed, it will return an empty string.\n")
+
+    .def("text_to_path", &FontHandle::text_to_path,
+    "path = text_to_path(text)\n"
+    "Same as text_to_shape, but returns a Shape.Path,\n"
+    "which Shape functions take without parsing text.\n"
+    "If failed, it will return an empty path.\n");
 }
@@ -29,36 +29,87 @@
 
 using namespace PROJ_NAMESPACE::Yutils;
 
+// Image of the supersampled renderer, reused by every to_pixels call
+// of a thread, so it is only allocated when a shape is larger than before
+static Shape_Internal::Raster &threadRaster()
+{
+    thread_local Shape_Internal::Raster raster;
+    return raster;
+}
+
+// Without projection x and y are an affine image of the points,
+// with it they are divided by w, which must not depend on them
+static bool isAffine(const Math::Matrix &matrix,
+                     bool project,
+                     double perspective_z)
+{
+    if (!project)
+    {
+        return true;
+    }
+
+    Eigen::Matrix4d data(matrix.data());
+    return perspective_z <= 0. && data(0, 3) == 0. && data(1, 3) == 0.;
+}
+
+// Transforms the x, y pairs of coords in place, see Shape::transform
+static void transformCoords(std::vector<double> &coords,
+                            const Math::Matrix &matrix,
+                            bool project,
+                            double perspective_z) THROW
+{
+    size_t count(coords.size() >> 1);
+    if (!project || perspective_z <= 0.)
+    {
+        // z is not needed, all points in one call
+        // here may throw exception
+        matrix.transformPoints(coords.data(), count, 2, project);
+        return;
+    }
+
+    std::vector<double> points(count * 3, 0.);
+    for (size_t i = 0; i < count; ++i)
+    {
+        points[i * 3] = coords[i << 1];
+        points[i * 3 + 1] = coords[(i << 1) + 1];
+    }
+
+    // here may throw exception
+    matrix.transformPoints(points.data(), count, 3, true);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        double scale(perspective_z / (perspective_z + points[i * 3 + 2]));
+        coords[i << 1] = points[i * 3] * scale;
+        coords[(i << 1) + 1] = points[i * 3 + 1] * scale;
+    }
+}
+
 std::tuple<double, double, double, double>
 Shape::bounding(std::string &shape) THROW
 {
     // Bounding data
     double x0(0.), y0(0.), x1(0.), y1(0.);
-    uint8_t flag(0);
-    std::function<std::pair<double, double>(double, double, std::string&)> flt(
-        [&](double x, double y, std::string &pointType)
-        {
-            UNUSED(pointType);
-            if (flag == 0)
-            {
-                x0 = x;
-                y0 = y;
-                x1 = x;
-                y1 = y;
-                flag = 1;
-            }
-
-            x0 = std::min(x0, x);
-            y0 = std::min(y0, y);
-            x1 = std::max(x1, x);
-            y1 = std::max(y1, y);
+    bool has_point(false);
 
-            return std::pair<double, double>();
+    // here may throw exception
+    Shape_Internal::for_each_point(shape, [](char) {},
+    [&](char, double x, double y)
+    {
+        if (!has_point)
+        {
+            x0 = x;
+            y0 = y;
+            x1 = x;
+            y1 = y;
+            has_point = true;
         }
-    );
 
-    // here may throw exception
-    filter(shape, flt);
+        x0 = std::min(x0, x);
+        y0 = std::min(y0, y);
+        x1 = std::max(x1, x);
+        y1 = std::max(y1, y);
+    });
 
     return std::make_tuple(x0, y0, x1, y1);
 }
@@ -73,101 +124,26 @@ THROW
         throw std::invalid_argument("filter: flt is empty!");
     }
 
-    typedef enum _FLT_STATUS
-    {
-        start, detect_type, read_data
-    } FLT_STATUS;
-
-    std::string tmpString(shape);
-    FLT_STATUS status(start);
-    std::regex typeReg("^([mnlbspc])(\\s*)");
-    std::regex dataReg("^(-?\\d+\\.?\\d*)(\\s+)(-?\\d+\\.?\\d*)(\\s*)");
-    std::smatch sm;
     std::string shapeType("");
     std::string output("");
-    double point1(0.), point2(0.);
-    while (tmpString.length() != 0)
-    {
-        if ((static_cast<uint8_t>(tmpString.at(0)) & 0x80) != 0)
-        {
-            // input is not ascii
-            throw std::invalid_argument("filter: input is out of ASCII!");
-        }
-
-        switch (status)
-        {
-        case start:
-        {
-            if (std::regex_search(tmpString, sm, std::regex("^([mnlbsp])(\\s+)")))
-            {
-                status = read_data;
-                shapeType = sm[1];
-                tmpString = sm.suffix();
-                output += (shapeType + " ");
-            }
-            else
-            {
-                throw std::invalid_argument("filter: shape syntax error: "
-                                            "unexpected token in the begging of shape.");
-            }
-
-            continue; // goto next loop
-        }
-        case detect_type:
-        {
-            if (regex_search(tmpString, sm, typeReg))
-            {
-                status = read_data;
-                shapeType = sm[1];
-                tmpString = sm.suffix();
-                output += (shapeType + " ");
-            }
-            else
-            {
-                std::string err(tmpString.substr(0, 1));
-                err = "filter: shape syntax error: expect m, n, l, b, s, p "
-                      "or c, but get " + err + " .";
-                throw std::invalid_argument(err);
-            }
-
-            continue; // goto next loop
-        }
-        default: // read data
-        {
-            if (shapeType == "c")
-            {
-                status = detect_type;
-                continue;
-            }
-
-            if (regex_search(tmpString, sm, dataReg))
-            {
-                std::string number(sm[1]);
-                sscanf(number.c_str(), "%lf", &point1);
-
-                number = sm[3];
-                sscanf(number.c_str(), "%lf", &point2);
 
-                tmpString = sm.suffix();
-            }
-            else
-            {
-                status = detect_type;
-                continue;
-            }
-
-            break;
-        }
-        } //end switch
-
-        std::pair<double, double> newPoints(flt(point1, point2, shapeType));
+    // here may throw exception
+    Shape_Internal::for_each_point(shape,
+    [&](char type)
+    {
+        shapeType.assign(1, type);
+        output += (shapeType + " ");
+    },
+    [&](char, double x, double y)
+    {
+        std::pair<double, double> newPoints(flt(x, y, shapeType));
         output +=
                 (PROJ_NAMESPACE::Utils::Misc::doubleToString(
                      Math::round(newPoints.first, FP_PRECISION)) + " ");
         output +=
                 (PROJ_NAMESPACE::Utils::Misc::doubleToString(
                      Math::round(newPoints.second, FP_PRECISION)) + " ");
-    } // end while (tmpString.length() != 0)
+    });
 
     return output;
 }
@@ -184,6 +160,7 @@ std::string Shape::flatten(std::string &shape) THROW
     double x2(0.), y2(0.), x3(0.), y3(0.);
     std::string output("");
     std::string number("");
+    std::vector<double> line_points;
     std::regex startReg("(-?\\d+\\.?\\d*)\\s+(-?\\d+\\.?\\d*)\\s+b(\\s+)");
     std::regex pointReg("^(-?\\d+\\.?\\d*)\\s+(-?\\d+\\.?\\d*)\\s+"
                         "(-?\\d+\\.?\\d*)\\s+(-?\\d+\\.?\\d*)\\s+"
@@ -245,11 +222,11 @@ std::string Shape::flatten(std::string &shape) THROW
                 number = sm[6];
                 sscanf(number.c_str(), "%lf", &y3);
 
-                std::vector<double>
-                        line_points(Shape_Internal::curve4_to_lines(x0, y0,
-                                                                    x1, y1,
-                                                                    x2, y2,
-                                                                    x3, y3));
+                const double curve[8] = {x0, y0, x1, y1, x2, y2, x3, y3};
+                line_points.clear();
+
+                // here may throw exception
+                Shape_Internal::curve4_to_lines(curve, line_points);
 
                 for (size_t i = 0; i < line_points.size(); ++i)
                 {
@@ -298,76 +275,459 @@ std::string Shape::move(std::string &shape, double x, double y) THROW
     return filter(shape, flt);
 }
 
-std::vector<std::map<std::string, double>>
-Shape::to_pixels(std::string &shape) THROW
+std::string Shape::transform(std::string &shape,
+                             const Math::Matrix &matrix,
+                             bool project,
+                             double perspective_z) THROW
 {
-    // Scale values for supersampled rendering
-    uint8_t upscale(SUPERSAMPLING);
-    double downscale(0.125); // 1 / 8
-    std::function<std::pair<double, double>(double, double, std::string &)> flt([&](double x, double y,
-                                                                     std::string &input)
+    // here may throw exception
+    std::string source(isAffine(matrix, project, perspective_z) ?
+                           shape : flatten(shape));
+
+    // Points are collected, transformed at once,
+    // and formatted the way filter does
+    std::string types("");
+    std::vector<size_t> counts;
+    std::vector<double> coords;
+
+    // here may throw exception
+    Shape_Internal::for_each_point(source,
+    [&](char type)
+    {
+        types.push_back(type);
+        counts.push_back(0);
+    },
+    [&](char, double x, double y)
     {
-        UNUSED(input);
-        return std::make_pair(x * static_cast<double>(upscale),
-                              y * static_cast<double>(upscale));
+        coords.push_back(x);
+        coords.push_back(y);
+        ++counts.back();
     });
 
-    // Upscale shape for later downsampling
+    transformCoords(coords, matrix, project, perspective_z);
+
+    std::string output("");
+    size_t index(0);
+    for (size_t i = 0; i < types.length(); ++i)
+    {
+        output += types.at(i);
+        output += " ";
+        for (size_t j = 0; j < (counts.at(i) << 1); ++j)
+        {
+            output +=
+                    (PROJ_NAMESPACE::Utils::Misc::doubleToString(
+                         Math::round(coords.at(index++), FP_PRECISION)) + " ");
+        }
+    }
+
+    return output;
+}
+
+std::vector<std::map<std::string, double>>
+Shape::to_pixels(std::string &shape, PixelMode mode) THROW
+{
+    // here may throw exception
+    return to_maps(to_pixel_buffer(shape, mode));
+}
+
+Shape::PixelBuffer
+Shape::to_pixel_buffer(std::string &shape, PixelMode mode) THROW
+{
+    // The shape is parsed once, everything else runs on the path
+    // here may throw exception
+    return to_pixel_buffer(to_path(shape), mode);
+}
+
+static const char *pathCommands[] = {"m", "l", "b", "c"};
+
+static const uint8_t pathPoints[] = {1, 1, 3, 0};
+
+Shape::Path::Path(const subfx_shapePath &path) :
+    ops(path.ops, path.ops + path.opCount),
+    coords(path.coords, path.coords + path.coordCount)
+{}
+
+std::tuple<double, double, double, double>
+Shape::bounding(const Path &path) NOTHROW
+{
+    if (path.coords.size() < 2)
+    {
+        return std::make_tuple(0., 0., 0., 0.);
+    }
+
+    double x0(path.coords[0]), y0(path.coords[1]);
+    double x1(x0), y1(y0);
+    for (size_t i = 2; i + 1 < path.coords.size(); i += 2)
+    {
+        x0 = std::min(x0, path.coords[i]);
+        y0 = std::min(y0, path.coords[i + 1]);
+        x1 = std::max(x1, path.coords[i]);
+        y1 = std::max(y1, path.coords[i + 1]);
+    }
+
+    return std::make_tuple(x0, y0, x1, y1);
+}
+
+Shape::Path
+Shape::filter(const Path &path,
+              std::function<std::pair<double, double>(double, double, std::string &)> &flt)
+THROW
+{
+    if (!flt)
+    {
+        throw std::invalid_argument("filter: flt is empty!");
+    }
+
+    Path output(path);
+    size_t index(0);
+    for (size_t i = 0; i < output.ops.size(); ++i)
+    {
+        uint8_t op(output.ops.at(i));
+        if (op > subfx_shapePath_close)
+        {
+            throw std::invalid_argument("filter: invalid command in path.");
+        }
+
+        for (uint8_t j = 0; j < pathPoints[op]; ++j)
+        {
+            if (index + 2 > output.coords.size())
+            {
+                throw std::invalid_argument("filter: too few coordinates.");
+            }
+
+            std::string shapeType(pathCommands[op]);
+            std::pair<double, double> newPoints(flt(output.coords[index],
+                                                    output.coords[index + 1],
+                                                    shapeType));
+            output.coords[index] = newPoints.first;
+            output.coords[index + 1] = newPoints.second;
+            index += 2;
+        }
+    }
+
+    return output;
+}
+
+Shape::Path Shape::flatten(const Path &path) THROW
+{
+    Path output;
+    output.ops.reserve(path.ops.size());
+    output.coords.reserve(path.coords.size());
+
+    size_t index(0);
+    double x0(0.), y0(0.);
+    for (size_t i = 0; i < path.ops.size(); ++i)
+    {
+        uint8_t op(path.ops.at(i));
+        if (op > subfx_shapePath_close)
+        {
+            throw std::invalid_argument("flatten: invalid command in path.");
+        }
+
+        size_t count(static_cast<size_t>(pathPoints[op]) << 1);
+        if (index + count > path.coords.size())
+        {
+            throw std::invalid_argument("flatten: too few coordinates.");
+        }
+
+        const double *pts(path.coords.data() + index);
+        index += count;
+        if (op != subfx_shapePath_curve)
+        {
+            output.ops.push_back(op);
+            output.coords.insert(output.coords.end(), pts, pts + count);
+            if (count)
+            {
+                x0 = pts[0];
+                y0 = pts[1];
+            }
+
+            continue;
+        }
+
+        // lines are written to the output right away
+        const double curve[8] = {x0, y0,
+                                 pts[0], pts[1],
+                                 pts[2], pts[3],
+                                 pts[4], pts[5]};
+        size_t start(output.coords.size());
+
+        // here may throw exception
+        Shape_Internal::curve4_to_lines(curve, output.coords);
+        output.ops.insert(output.ops.end(),
+                          (output.coords.size() - start) >> 1,
+                          subfx_shapePath_line);
+        x0 = pts[4];
+        y0 = pts[5];
+    }
+
+    return output;
+}
+
+Shape::Path Shape::move(const Path &path, double x, double y) THROW
+{
+    Path output(path);
+    for (size_t i = 0; i + 1 < output.coords.size(); i += 2)
+    {
+        output.coords[i] += x;
+        output.coords[i + 1] += y;
+    }
+
+    return output;
+}
+
+Shape::Path Shape::transform(const Path &path,
+                             const Math::Matrix &matrix,
+                             bool project,
+                             double perspective_z) THROW
+{
     // here may throw exception
-    std::string newShape(filter(shape, flt));
+    Path output(isAffine(matrix, project, perspective_z) ?
+                    path : flatten(path));
+    transformCoords(output.coords, matrix, project, perspective_z);
+    return output;
+}
 
+std::vector<std::map<std::string, double>>
+Shape::to_pixels(const Path &path, PixelMode mode) THROW
+{
     // here may throw exception
-    auto tmpTuple(bounding(newShape));
-    double x1(std::get<0>(tmpTuple)), y1(std::get<1>(tmpTuple));
-    double x2(std::get<2>(tmpTuple)), y2(std::get<3>(tmpTuple));
+    return to_maps(to_pixel_buffer(path, mode));
+}
+
+Shape::PixelBuffer
+Shape::to_pixel_buffer(const Path &path, PixelMode mode) THROW
+{
+    if (mode == PixelMode::coverage)
+    {
+        // here may throw exception
+        Path newPath(flatten(path));
+
+        // Shift to the pixel grid, pixels stay at integer positions
+        auto tmpTuple(bounding(newPath));
+        double shift_x(-floor(std::get<0>(tmpTuple)));
+        double shift_y(-floor(std::get<1>(tmpTuple)));
+        for (size_t i = 0; i + 1 < newPath.coords.size(); i += 2)
+        {
+            newPath.coords[i] += shift_x;
+            newPath.coords[i + 1] += shift_y;
+        }
+
+        size_t width(static_cast<size_t>(ceil(std::get<2>(tmpTuple) + shift_x)));
+        size_t height(static_cast<size_t>(ceil(std::get<3>(tmpTuple) + shift_y)));
+        std::vector<float> cells((width + 2) * height, 0.f);
+
+        // here may throw exception
+        Shape_Internal::render_coverage(width, height, cells, newPath);
+
+        PixelBuffer pixels;
+
+        // here may throw exception
+        Shape_Internal::extract_coverage(width, height, cells,
+                                         shift_x, shift_y, pixels);
+        return pixels;
+    }
+
+    // Scale values for supersampled rendering
+    uint8_t upscale(SUPERSAMPLING);
+    double downscale(0.125); // 1 / 8
+
+    // Bounding box of the upscaled shape, scaling by 8 is exact,
+    // so it is the box of the input scaled
+    auto tmpTuple(bounding(path));
+    double x1(std::get<0>(tmpTuple) * upscale), y1(std::get<1>(tmpTuple) * upscale);
+    double x2(std::get<2>(tmpTuple) * upscale), y2(std::get<3>(tmpTuple) * upscale);
 
     double shift_x(-(x1 - (static_cast<int64_t>(x1) % upscale)));
     double shift_y(-(y1 - (static_cast<int64_t>(y1) % upscale)));
 
+    // Flattening commutes with scaling and moving,
+    // so curves are flattened first and the lines are upscaled and
+    // shifted in one pass for later downsampling
     // here may throw exception
-    newShape = move(newShape, shift_x, shift_y);
+    Path newPath(flatten(path));
+    for (size_t i = 0; i + 1 < newPath.coords.size(); i += 2)
+    {
+        newPath.coords[i] = newPath.coords[i] * upscale + shift_x;
+        newPath.coords[i + 1] = newPath.coords[i + 1] * upscale + shift_y;
+    }
 
     // Create image
     double img_width(ceil((x2 + shift_x) * downscale) * upscale);
     double img_height(ceil((y2 + shift_y) * downscale) * upscale);
-    std::vector<bool> img_data;
-    img_data.resize(static_cast<size_t>(img_width * img_height));
-    std::fill(img_data.begin(), img_data.end(), false);
+    Shape_Internal::Raster &img_data(threadRaster());
+
+    // here may throw exception
+    img_data.reset(static_cast<size_t>(img_width),
+                   static_cast<size_t>(img_height));
 
     // Render shape on image
     // here may throw exception
-    Shape_Internal::render_shape(img_width, img_height, img_data, newShape);
+    Shape_Internal::render_path(img_data, newPath);
 
     // Extract pixels from image
-    std::vector<std::map<std::string, double>> pixels;
-    pixels.reserve(static_cast<size_t>((img_height-upscale) * (img_width-upscale)));
-    double opacity(0.);
-    for (double y = 0; y <= (img_height - upscale); y += upscale)
+    PixelBuffer pixels;
+
+    // here may throw exception
+    Shape_Internal::extract_pixels(img_data, shift_x, shift_y, pixels);
+    return pixels;
+}
+
+std::vector<std::map<std::string, double>>
+Shape::to_maps(const PixelBuffer &pixels) THROW
+{
+    std::vector<std::map<std::string, double>> output;
+    output.reserve(pixels.alpha.size());
+    for (size_t i = 0; i < pixels.alpha.size(); ++i)
+    {
+        std::map<std::string, double> pixel;
+        pixel["alpha"] = pixels.alpha[i];
+        pixel["x"] = pixels.x.at(i);
+        pixel["y"] = pixels.y.at(i);
+        output.push_back(pixel);
+    }
+
+    return output;
+}
+
+std::string Shape::to_shape(const Path &path) THROW
+{
+    std::string output("");
+    output.reserve(path.coords.size() << 3);
+
+    size_t index(0);
+    uint8_t last(0xff); // first command has no last one
+    for (size_t i = 0; i < path.ops.size(); ++i)
+    {
+        uint8_t op(path.ops.at(i));
+        if (op > subfx_shapePath_close)
+        {
+            throw std::invalid_argument("to_shape: invalid command in path.");
+        }
+
+        if (op != last)
+        {
+            output += pathCommands[op];
+            output += " ";
+            last = op;
+        }
+
+        size_t count(static_cast<size_t>(pathPoints[op]) << 1);
+        if (index + count > path.coords.size())
+        {
+            throw std::invalid_argument("to_shape: too few coordinates.");
+        }
+
+        for (size_t j = 0; j < count; ++j)
+        {
+            output +=
+                    (PROJ_NAMESPACE::Utils::Misc::doubleToString(
+                         Math::round(path.coords[index + j], FP_PRECISION)) + " ");
+        }
+
+        index += count;
+    }
+
+    return output;
+}
+
+Shape::Path Shape::to_path(const std::string &shape) THROW
+{
+    Path output;
+    output.ops.reserve(shape.size() >> 4);
+    output.coords.reserve(shape.size() >> 3);
+
+    // same tokens as filter accepts
+    const char *pos(shape.data());
+    const char *end(pos + shape.size());
+    const char *next(nullptr);
+    size_t len1(0), len2(0);
+    char shapeType('\0');
+    uint8_t curvePoints(0);
+    while (pos != end)
     {
-        for (double x = 0; x <= (img_width - upscale); x += upscale)
+        if ((static_cast<uint8_t>(*pos) & 0x80) != 0)
         {
-            opacity = 0.;
-            for (uint8_t yy = 0; yy <= (upscale - 1); ++yy)
+            // input is not ascii
+            throw std::invalid_argument("to_path: input is out of ASCII!");
+        }
+
+        if (shapeType == '\0' || shapeType == 'c' ||
+            Shape_Internal::is_type(*pos, "mnlbspc"))
+        {
+            if (!Shape_Internal::is_type(*pos, (shapeType == '\0') ?
+                                               "mnlbsp" : "mnlbspc") ||
+                (shapeType == '\0' &&
+                 ((pos + 1) == end || !Shape_Internal::is_space(pos[1]))))
             {
-                for (uint8_t xx = 0; xx <= (upscale - 1); ++xx)
-                {
-                    if (img_data.at(static_cast<size_t>(((y + yy) * img_width) + (x + xx))))
-                    {
-                        opacity += 255;
-                    }
-                } // end for xx
-            } // end for yy
-
-            if (opacity > 0.)
+                std::string err(1, *pos);
+                err = "to_path: shape syntax error: unexpected token " +
+                      err + " .";
+                throw std::invalid_argument(err);
+            }
+
+            // points of an unfinished curve
+            output.ops.insert(output.ops.end(), curvePoints,
+                              subfx_shapePath_line);
+            curvePoints = 0;
+
+            shapeType = *pos;
+            pos = Shape_Internal::skip_spaces(pos + 1, end);
+            if (shapeType == 'c')
             {
-                std::map<std::string, double> pixel;
-                pixel["alpha"] = static_cast<uint8_t>(opacity * (downscale * downscale));
-                pixel["x"] = (x - shift_x) * downscale;
-                pixel["y"] = (y - shift_y) * downscale;
-                pixels.push_back(pixel);
+                output.ops.push_back(subfx_shapePath_close);
             }
-        } // end for x
-    } // end for y
 
-    return pixels;
+            continue;
+        }
+
+        // a point is two numbers
+        len1 = Shape_Internal::number_length(pos, end);
+        next = pos + len1;
+        len2 = 0;
+        if (len1 != 0 && next != end && Shape_Internal::is_space(*next))
+        {
+            next = Shape_Internal::skip_spaces(next, end);
+            len2 = Shape_Internal::number_length(next, end);
+        }
+
+        if (len2 == 0)
+        {
+            std::string err(1, *pos);
+            err = "to_path: shape syntax error: expect a point, but get " +
+                  err + " .";
+            throw std::invalid_argument(err);
+        }
+
+        output.coords.push_back(Shape_Internal::to_double(pos, len1));
+        output.coords.push_back(Shape_Internal::to_double(next, len2));
+        pos = Shape_Internal::skip_spaces(next + len2, end);
+
+        switch (shapeType)
+        {
+        case 'm':
+        {
+            output.ops.push_back(subfx_shapePath_move);
+            break;
+        }
+        case 'b':
+        {
+            if (++curvePoints == 3)
+            {
+                output.ops.push_back(subfx_shapePath_curve);
+                curvePoints = 0;
+            }
+
+            break;
+        }
+        default: // n, l, s and p
+        {
+            output.ops.push_back(subfx_shapePath_line);
+            break;
+        }
+        } // end switch (shapeType)
+    } // end while (pos != end)
+
+    output.ops.insert(output.ops.end(), curvePoints, subfx_shapePath_line);
+    return output;
 }
@@ -26,6 +26,9 @@
 #include <vector>
 
 #include "../basecommon.h"
+#include "../shapepath.h"
+
+#include "matrix.hpp"
 
 namespace PROJ_NAMESPACE
 {
@@ -36,6 +39,43 @@ namespace Yutils
 namespace Shape
 {
 
+// Commands and coordinates of a shape, the same layout as subfx_shapePath.
+// Routines taking a Path never format or parse text.
+struct SYMBOL_SHOW Path
+{
+    Path() = default;
+
+    explicit Path(const subfx_shapePath &);
+
+    // one of subfx_shapePath_* per command
+    std::vector<uint8_t> ops;
+
+    // x, y pairs of all commands in order
+    std::vector<double> coords;
+};
+
+// How to_pixels computes alpha
+enum class PixelMode
+{
+    // Renders at 8x resolution and counts the samples of every pixel
+    supersampling,
+
+    // Area of every pixel covered by the shape, at output resolution,
+    // about 64x less cells and much faster than supersampling
+    coverage
+};
+
+// Pixels of a rendered shape, the i-th pixel is at x[i], y[i]
+// with opacity alpha[i]
+struct SYMBOL_SHOW PixelBuffer
+{
+    std::vector<double> x;
+
+    std::vector<double> y;
+
+    std::vector<uint8_t> alpha;
+};
+
 // Calculates shape bounding box
 SYMBOL_SHOW std::tuple<double, double, double, double>
 bounding(std::string &) THROW;
@@ -52,9 +92,63 @@ SYMBOL_SHOW std::string flatten(std::string &) THROW;
 // Shifts shape coordinates
 SYMBOL_SHOW std::string move(std::string &, double, double) THROW;
 
+// Applies matrix to shape points, x and y of Matrix::transform(x, y, 0, 1).
+// If project is true, they are divided by its w, and if perspective_z is
+// greater than 0, projected to z = 0 as seen from distance perspective_z,
+// so points must be in front of it. Curves are converted to lines if
+// a projection is not affine, their image would not be a curve any more.
+SYMBOL_SHOW std::string
+transform(std::string &,
+          const Math::Matrix &,
+          bool project = false,
+          double perspective_z = 0.) THROW;
+
 // Converts shape to pixels
 SYMBOL_SHOW std::vector<std::map<std::string, double>>
-to_pixels(std::string &) THROW;
+to_pixels(std::string &, PixelMode = PixelMode::supersampling) THROW;
+
+// Same as above, but without a map per pixel
+SYMBOL_SHOW PixelBuffer
+to_pixel_buffer(std::string &, PixelMode = PixelMode::supersampling) THROW;
+
+// Same as above, but on a Path, e.g. from FontHandle's text_to_path.
+// Points are not rounded between the steps.
+SYMBOL_SHOW std::tuple<double, double, double, double>
+bounding(const Path &) NOTHROW;
+
+SYMBOL_SHOW Path
+filter(const Path &,
+       std::function<std::pair<double, double>(double, double, std::string &)> &)
+THROW;
+
+SYMBOL_SHOW Path flatten(const Path &) THROW;
+
+SYMBOL_SHOW Path move(const Path &, double, double) THROW;
+SYMBOL_SHOW Path
+transform(const Path &,
+          const Math::Matrix &,
+          bool project = false,
+          double perspective_z = 0.) THROW;
+
+SYMBOL_SHOW std::vector<std::map<std::string, double>>
+to_pixels(const Path &, PixelMode = PixelMode::supersampling) THROW;
+
+SYMBOL_SHOW PixelBuffer
+to_pixel_buffer(const Path &, PixelMode = PixelMode::supersampling) THROW;
+
+// Converts pixels to one map per pixel, as to_pixels returns them
+SYMBOL_SHOW std::vector<std::map<std::string, double>>
+to_maps(const PixelBuffer &) THROW;
+
+// Formats path as an ASS shape
+SYMBOL_SHOW std::string to_shape(const Path &) THROW;
+
+// Parses an ASS shape into a path.
+// Paths have only m, l, b and c. Points after n, s and p are kept as
+// lines, the way to_pixels has always drawn them, so are the points of
+// a b that do not make a whole curve, as flatten leaves them.
+// ShapePath rejects n, s and p, its to_shape could not write them back.
+SYMBOL_SHOW Path to_path(const std::string &) THROW;
 
 } // end namespace Shape
 
@@ -0,0 +1,218 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdexcept>
+
+#include <cmath>
+
+#include "YutilsCpp"
+
+using namespace PROJ_NAMESPACE::Yutils;
+
+ShapePath::ShapePath() NOTHROW :
+    m_path(),
+    m_pending(Eigen::Matrix4d::Identity()),
+    m_hasPending(false)
+{}
+
+ShapePath::ShapePath(const std::string &shape) THROW :
+    m_path(),
+    m_pending(Eigen::Matrix4d::Identity()),
+    m_hasPending(false)
+{
+    // letters are only ever commands, anything else is a syntax error
+    if (shape.find_first_of("nsp") != std::string::npos)
+    {
+        throw std::invalid_argument("ShapePath: n, s and p are not supported.");
+    }
+
+    // here may throw exception
+    m_path = Shape::to_path(shape);
+}
+
+ShapePath::ShapePath(const Shape::Path &path) NOTHROW :
+    m_path(path),
+    m_pending(Eigen::Matrix4d::Identity()),
+    m_hasPending(false)
+{}
+
+ShapePath &ShapePath::move(double x, double y) NOTHROW
+{
+    Eigen::Matrix4d translation(Eigen::Matrix4d::Identity());
+    translation(3, 0) = x;
+    translation(3, 1) = y;
+    return transform(translation);
+}
+
+ShapePath &ShapePath::scale(double x, double y) NOTHROW
+{
+    Eigen::Matrix4d scaling(Eigen::Matrix4d::Identity());
+    scaling(0, 0) = x;
+    scaling(1, 1) = y;
+    return transform(scaling);
+}
+
+ShapePath &ShapePath::rotate(double angle) NOTHROW
+{
+    double rad(angle * M_PI / 180.);
+    double c(cos(rad)), s(sin(rad));
+    Eigen::Matrix4d rotation(Eigen::Matrix4d::Identity());
+    rotation(0, 0) = c;
+    rotation(0, 1) = s;
+    rotation(1, 0) = -s;
+    rotation(1, 1) = c;
+    return transform(rotation);
+}
+
+ShapePath &ShapePath::transform(const Eigen::Matrix4d &matrix) NOTHROW
+{
+    // Only what reaches x and y of (x, y, 0, 1) * matrix,
+    // so the next transform sees z = 0 and w = 1 again
+    Eigen::Matrix4d planar(Eigen::Matrix4d::Identity());
+    planar.topLeftCorner<2, 2>() = matrix.topLeftCorner<2, 2>();
+    planar.block<1, 2>(3, 0) = matrix.block<1, 2>(3, 0);
+
+    // points are row vectors, so later transforms multiply on the right
+    m_pending = m_pending * planar;
+    m_hasPending = true;
+    return *this;
+}
+
+ShapePath &ShapePath::transform(const Math::Matrix &matrix) NOTHROW
+{
+    return transform(matrix.data());
+}
+
+ShapePath &
+ShapePath::filter(
+    std::function<std::pair<double, double>(double, double, std::string &)> &flt)
+THROW
+{
+    if (!flt)
+    {
+        throw std::invalid_argument("filter: flt is empty!");
+    }
+
+    // all points first, so a throwing flt leaves
+    // no point transformed twice later
+    apply();
+
+    static const char *commands[] = {"m", "l", "b", "c"};
+    static const uint8_t points[] = {1, 1, 3, 0};
+
+    size_t index(0);
+    std::string shapeType;
+    for (size_t i = 0; i < m_path.ops.size(); ++i)
+    {
+        uint8_t op(m_path.ops.at(i));
+        if (op > subfx_shapePath_close)
+        {
+            throw std::invalid_argument("filter: invalid command in path.");
+        }
+
+        for (uint8_t j = 0; j < points[op]; ++j)
+        {
+            if (index + 2 > m_path.coords.size())
+            {
+                throw std::invalid_argument("filter: too few coordinates.");
+            }
+
+            shapeType = commands[op];
+            std::pair<double, double> newPoints(flt(m_path.coords[index],
+                                                    m_path.coords[index + 1],
+                                                    shapeType));
+            m_path.coords[index] = newPoints.first;
+            m_path.coords[index + 1] = newPoints.second;
+            index += 2;
+        }
+    }
+
+    return *this;
+}
+
+ShapePath &ShapePath::flatten() THROW
+{
+    apply();
+
+    // here may throw exception
+    m_path = Shape::flatten(m_path);
+    return *this;
+}
+
+std::tuple<double, double, double, double> ShapePath::bounding() NOTHROW
+{
+    apply();
+    return Shape::bounding(m_path);
+}
+
+std::vector<std::map<std::string, double>>
+ShapePath::to_pixels(Shape::PixelMode mode) THROW
+{
+    apply();
+
+    // here may throw exception
+    return Shape::to_pixels(m_path, mode);
+}
+
+Shape::PixelBuffer ShapePath::to_pixel_buffer(Shape::PixelMode mode) THROW
+{
+    apply();
+
+    // here may throw exception
+    return Shape::to_pixel_buffer(m_path, mode);
+}
+
+std::string ShapePath::to_shape() THROW
+{
+    apply();
+
+    // here may throw exception
+    return Shape::to_shape(m_path);
+}
+
+const Shape::Path &ShapePath::path() NOTHROW
+{
+    apply();
+    return m_path;
+}
+
+void ShapePath::transformPoint(double &x, double &y) const NOTHROW
+{
+    // (x, y, 0, 1) * m_pending
+    double newX(x * m_pending(0, 0) + y * m_pending(1, 0) + m_pending(3, 0));
+    double newY(x * m_pending(0, 1) + y * m_pending(1, 1) + m_pending(3, 1));
+    x = newX;
+    y = newY;
+}
+
+void ShapePath::apply() NOTHROW
+{
+    if (!m_hasPending)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i + 1 < m_path.coords.size(); i += 2)
+    {
+        transformPoint(m_path.coords[i], m_path.coords[i + 1]);
+    }
+
+    m_pending = Eigen::Matrix4d::Identity();
+    m_hasPending = false;
+}
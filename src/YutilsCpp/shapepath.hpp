@@ -0,0 +1,112 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+#include <functional>
+#include <utility>
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "../basecommon.h"
+#include "matrix.hpp"
+#include "shape.hpp"
+
+namespace PROJ_NAMESPACE
+{
+
+namespace Yutils
+{
+
+// A shape kept as a Shape::Path between calls, so a chain like
+// move, scale, rotate and to_pixels parses and formats text at most once.
+// Transforms are only recorded and fused into one matrix, the points are
+// touched in a single pass when something reads them.
+class SYMBOL_SHOW ShapePath
+{
+public:
+
+    ShapePath() NOTHROW;
+
+    // Parses an ASS shape. Throws std::invalid_argument for n, s and p,
+    // to_shape writes only m, l, b and c.
+    explicit ShapePath(const std::string &) THROW;
+
+    explicit ShapePath(const Shape::Path &) NOTHROW;
+
+    // Shifts points horizontally by x and vertically by y
+    ShapePath &move(double x, double y) NOTHROW;
+
+    // Scales points around the origin
+    ShapePath &scale(double x, double y) NOTHROW;
+
+    // Rotates points around the origin by angle in degree,
+    // clockwise on screen as y goes down
+    ShapePath &rotate(double angle) NOTHROW;
+
+    // Points become x and y of Matrix::transform(x, y, 0, 1),
+    // like Shape::transform without projection
+    ShapePath &transform(const Eigen::Matrix4d &) NOTHROW;
+
+    ShapePath &transform(const Math::Matrix &) NOTHROW;
+
+    // Same as Shape::filter, pending transforms are applied first
+    ShapePath &filter(
+        std::function<std::pair<double, double>(double, double, std::string &)> &)
+    THROW;
+
+    // Converts curves to lines
+    ShapePath &flatten() THROW;
+
+    std::tuple<double, double, double, double> bounding() NOTHROW;
+
+    std::vector<std::map<std::string, double>>
+    to_pixels(Shape::PixelMode = Shape::PixelMode::supersampling) THROW;
+
+    Shape::PixelBuffer
+    to_pixel_buffer(Shape::PixelMode = Shape::PixelMode::supersampling) THROW;
+
+    // Formats the path as an ASS shape
+    std::string to_shape() THROW;
+
+    // Path with all transforms applied
+    const Shape::Path &path() NOTHROW;
+
+private:
+
+    // Applies pending transforms to point
+    void transformPoint(double &x, double &y) const NOTHROW;
+
+    // Applies pending transforms to all points
+    void apply() NOTHROW;
+
+    Shape::Path m_path;
+
+    // row vector convention, like Math::Matrix
+    Eigen::Matrix4d m_pending;
+
+    bool m_hasPending;
+
+};
+
+} // end namespace Yutils
+
+} // end namespace PROJ_NAMESPACE
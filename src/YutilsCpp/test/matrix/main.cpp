@@ -0,0 +1,127 @@
+/*
+ * This file is part of SubFX,
+ * Copyright (c) 2020-2021 fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Checks that Matrix::transformPoints gives what Matrix::transform gives
+// point by point, for 2D and 3D points, with and without the division by w.
+// The count is not a multiple of the 256 points block.
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "YutilsCpp"
+
+using namespace PROJ_NAMESPACE::Yutils;
+
+#define POINT_COUNT 1000
+#define MAX_DIFF 1e-9
+
+static int compare(std::shared_ptr<Math::Matrix> &matrix,
+                   uint8_t dimension,
+                   bool perspective)
+{
+    std::vector<double> points(POINT_COUNT * dimension);
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        // spread over a few hundred pixels, negative ones too
+        points[i] = static_cast<double>((i * 7919) % 601) - 300.5;
+    }
+
+    std::vector<double> transformed(points);
+    matrix->transformPoints(transformed.data(), POINT_COUNT,
+                            dimension, perspective);
+
+    for (size_t i = 0; i < POINT_COUNT; ++i)
+    {
+        const double *point(&points[i * dimension]);
+        Eigen::Vector4d expected(matrix->transform(
+                                     point[0], point[1],
+                                     (dimension == 3) ? point[2] : 0., 1.));
+        for (uint8_t j = 0; j < dimension; ++j)
+        {
+            double value(perspective ? expected(j) / expected(3) : expected(j));
+            if (fabs(transformed[i * dimension + j] - value) > MAX_DIFF)
+            {
+                printf("dimension %u, perspective %d: point %zu is %f, "
+                       "expected %f\n", dimension, perspective, i,
+                       transformed[i * dimension + j], value);
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+int main()
+{
+    try
+    {
+        std::string axis("x");
+        std::shared_ptr<Math::Matrix> matrix(Math::Matrix::create());
+        matrix->translate(15., -7., 3.);
+        matrix->rotate(axis, .4);
+        matrix->scale(2., .5, 4.);
+
+        // an offset in row 3 and a projective column, so w is not 1
+        Eigen::Matrix4d data(matrix->data());
+        data(3, 0) = 5.;
+        data(3, 1) = -9.;
+        data(3, 2) = 1.;
+        data(0, 3) = .001;
+        data(1, 3) = -.0005;
+        data(2, 3) = .0002;
+        data(3, 3) = 2.;
+        matrix->setData(data);
+
+        for (uint8_t dimension = 2; dimension <= 3; ++dimension)
+        {
+            if (compare(matrix, dimension, false) ||
+                compare(matrix, dimension, true))
+            {
+                return 1;
+            }
+        }
+
+        try
+        {
+            double point[4] = {0., 0., 0., 1.};
+            matrix->transformPoints(point, 1, 4);
+            printf("dimension 4 is accepted\n");
+            return 1;
+        }
+        catch (std::invalid_argument &)
+        {}
+    }
+    catch (std::exception &e)
+    {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,413 @@
+/*
+ * This file is part of SubFX,
+ * Copyright (c) 2020-2021 fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Checks that PixelMode::coverage stays close to PixelMode::supersampling.
+// Coverage is exact, supersampling is off by up to a few of its 64 samples
+// on every edge pixel.
+// Also checks that curves are flattened to the same points as the
+// recursive acos based flattener did.
+// Also checks that Shape::transform and ShapePath::transform move points
+// where Matrix::transform(x, y, 0, 1) does and keep curves.
+// Also checks that points of an unfinished b are drawn as lines.
+// Also checks that points after n, s and p are drawn as lines, as they were
+// before to_path, and that ShapePath rejects them.
+// Also checks that a ShapePath filter which throws leaves every point
+// moved once.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "YutilsCpp"
+
+using namespace PROJ_NAMESPACE::Yutils;
+
+#define MAX_ALPHA_DIFF 64.
+#define MEAN_ALPHA_DIFF 4.
+
+static std::map<std::pair<int64_t, int64_t>, double>
+toImage(const Shape::PixelBuffer &pixels)
+{
+    std::map<std::pair<int64_t, int64_t>, double> image;
+    for (size_t i = 0; i < pixels.alpha.size(); ++i)
+    {
+        image[std::make_pair(static_cast<int64_t>(pixels.x.at(i)),
+                             static_cast<int64_t>(pixels.y.at(i)))] =
+                pixels.alpha.at(i);
+    }
+
+    return image;
+}
+
+static int compare(std::string shape)
+{
+    auto supersampled(toImage(Shape::to_pixel_buffer(
+                                  shape, Shape::PixelMode::supersampling)));
+    auto coverage(toImage(Shape::to_pixel_buffer(
+                              shape, Shape::PixelMode::coverage)));
+    for (auto &pixel : coverage)
+    {
+        // pixels only one of them found
+        supersampled.emplace(pixel.first, 0.);
+    }
+
+    double maxDiff(0.), sumDiff(0.), sum1(0.), sum2(0.);
+    for (auto &pixel : supersampled)
+    {
+        auto it(coverage.find(pixel.first));
+        double alpha((it == coverage.end()) ? 0. : it->second);
+        double diff(fabs(pixel.second - alpha));
+        maxDiff = std::max(maxDiff, diff);
+        sumDiff += diff;
+        sum1 += pixel.second;
+        sum2 += alpha;
+    }
+
+    double meanDiff(sumDiff / static_cast<double>(supersampled.size()));
+    if (maxDiff > MAX_ALPHA_DIFF ||
+        meanDiff > MEAN_ALPHA_DIFF ||
+        fabs(sum1 - sum2) > sum1 * 0.01)
+    {
+        printf("%s\nmax diff: %f, mean diff: %f, alpha sums: %f %f\n",
+               shape.c_str(), maxDiff, meanDiff, sum1, sum2);
+        return 1;
+    }
+
+    return 0;
+}
+
+// Angle in degree between two segments, as Math::degree computes it
+static double segmentAngle(double x1, double y1, double x2, double y2)
+{
+    double lengths(sqrt(x1 * x1 + y1 * y1) * sqrt(x2 * x2 + y2 * y2));
+    if (lengths == 0.)
+    {
+        return 0.;
+    }
+
+    return acos((x1 * x2 + y1 * y2) / lengths) * 180. / M_PI;
+}
+
+// The old curve4_is_flat: every angle of the control polygon is at most
+// 1 degree, zero length segments are skipped
+static bool referenceIsFlat(const double *curve)
+{
+    double vecs[6];
+    size_t n(0);
+    for (size_t i = 0; i < 6; i += 2)
+    {
+        double vx(curve[i + 2] - curve[i]), vy(curve[i + 3] - curve[i + 1]);
+        if (vx == 0. && vy == 0.)
+        {
+            continue;
+        }
+
+        vecs[n++] = vx;
+        vecs[n++] = vy;
+    }
+
+    for (size_t i = 2; i < n; i += 2)
+    {
+        if (fabs(segmentAngle(vecs[i - 2], vecs[i - 1],
+                              vecs[i], vecs[i + 1])) > 1.)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// The old recursive curve4_to_lines, halves until referenceIsFlat
+static void referenceToLines(const double *curve, std::vector<double> &output)
+{
+    if (referenceIsFlat(curve))
+    {
+        output.push_back(curve[6]);
+        output.push_back(curve[7]);
+        return;
+    }
+
+    double x01((curve[0] + curve[2]) * .5), y01((curve[1] + curve[3]) * .5);
+    double x12((curve[2] + curve[4]) * .5), y12((curve[3] + curve[5]) * .5);
+    double x23((curve[4] + curve[6]) * .5), y23((curve[5] + curve[7]) * .5);
+    double x012((x01 + x12) * .5), y012((y01 + y12) * .5);
+    double x123((x12 + x23) * .5), y123((y12 + y23) * .5);
+    double x0123((x012 + x123) * .5), y0123((y012 + y123) * .5);
+
+    const double first[8] = {curve[0], curve[1], x01, y01,
+                             x012, y012, x0123, y0123};
+    const double second[8] = {x0123, y0123, x123, y123,
+                              x23, y23, curve[6], curve[7]};
+    referenceToLines(first, output);
+    referenceToLines(second, output);
+}
+
+static int compareFlatten(const double *curve)
+{
+    Shape::Path path;
+    path.ops = {subfx_shapePath_move, subfx_shapePath_curve};
+    path.coords.assign(curve, curve + 8);
+
+    std::vector<double> expected(curve, curve + 2);
+    referenceToLines(curve, expected);
+
+    Shape::Path flattened(Shape::flatten(path));
+    if (flattened.coords != expected)
+    {
+        printf("flatten: %zu points, expected %zu\n",
+               flattened.coords.size() >> 1, expected.size() >> 1);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int compareTransform(std::shared_ptr<Math::Matrix> &matrix)
+{
+    Shape::Path path;
+    path.ops = {subfx_shapePath_move, subfx_shapePath_curve,
+                subfx_shapePath_line, subfx_shapePath_close};
+    path.coords = {10., 20., 30., -5., 60., 45., 80., 20., 40., 70.};
+
+    Shape::Path transformed(Shape::transform(path, *matrix));
+    ShapePath shapePath(path);
+    const Shape::Path &chained(shapePath.transform(*matrix).path());
+    if (transformed.ops != path.ops ||
+        transformed.coords.size() != path.coords.size() ||
+        chained.coords.size() != path.coords.size())
+    {
+        printf("transform: points or commands changed\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < path.coords.size(); i += 2)
+    {
+        Eigen::Vector4d expected(matrix->transform(path.coords[i],
+                                                   path.coords[i + 1],
+                                                   0., 1.));
+        for (size_t j = 0; j < 2; ++j)
+        {
+            if (fabs(transformed.coords[i + j] - expected(j)) > 1e-9 ||
+                fabs(chained.coords[i + j] - expected(j)) > 1e-9)
+            {
+                printf("transform: point %zu is %f %f, expected %f\n",
+                       i >> 1, transformed.coords[i + j],
+                       chained.coords[i + j], expected(j));
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int compareUnfinishedCurve()
+{
+    std::string unfinished("m 10 10 l 50 10 b 50 50 10 50");
+    std::string lines("m 10 10 l 50 10 50 50 10 50");
+    Shape::PixelBuffer expected(Shape::to_pixel_buffer(lines));
+    Shape::PixelBuffer pixels(Shape::to_pixel_buffer(unfinished));
+    if (pixels.x != expected.x || pixels.y != expected.y ||
+        pixels.alpha != expected.alpha)
+    {
+        printf("unfinished curve: %zu pixels, expected %zu\n",
+               pixels.alpha.size(), expected.alpha.size());
+        return 1;
+    }
+
+    return 0;
+}
+
+static int compareLinePoints()
+{
+    // the count the filter based to_pixels gave
+    std::string withN("m 0 0 l 40 0 40 40 n 60 60 l 100 60 100 100");
+    std::string lines("m 0 0 l 40 0 40 40 l 60 60 l 100 60 100 100");
+    Shape::PixelBuffer pixels(Shape::to_pixel_buffer(withN));
+    Shape::PixelBuffer expected(Shape::to_pixel_buffer(lines));
+    if (pixels.alpha.size() != 1660 || pixels.x != expected.x ||
+        pixels.y != expected.y || pixels.alpha != expected.alpha)
+    {
+        printf("n: %zu pixels, expected 1660\n", pixels.alpha.size());
+        return 1;
+    }
+
+    std::string splines("m 10 10 s 50 10 50 50 10 50 p 30 30 c");
+    lines = "m 10 10 l 50 10 50 50 10 50 l 30 30 c";
+    pixels = Shape::to_pixel_buffer(splines);
+    expected = Shape::to_pixel_buffer(lines);
+    if (pixels.x != expected.x || pixels.y != expected.y ||
+        pixels.alpha != expected.alpha)
+    {
+        printf("s and p: %zu pixels, expected %zu\n",
+               pixels.alpha.size(), expected.alpha.size());
+        return 1;
+    }
+
+    for (const std::string &shape : {withN, splines})
+    {
+        try
+        {
+            ShapePath shapePath(shape);
+            printf("ShapePath accepts %s\n", shape.c_str());
+            return 1;
+        }
+        catch (std::invalid_argument &)
+        {}
+    }
+
+    return 0;
+}
+
+static int compareFilterThrow()
+{
+    Shape::Path path;
+    path.ops = {subfx_shapePath_move, subfx_shapePath_line,
+                subfx_shapePath_line};
+    path.coords = {10., 20., 30., -5., 60., 45.};
+
+    ShapePath shapePath(path);
+    shapePath.move(5., 5.);
+
+    size_t calls(0);
+    std::function<std::pair<double, double>(double, double, std::string &)>
+    flt([&](double x, double y, std::string &)
+    {
+        if (++calls == 2)
+        {
+            throw std::runtime_error("filter stopped");
+        }
+
+        return std::make_pair(x, y);
+    });
+
+    try
+    {
+        shapePath.filter(flt);
+    }
+    catch (std::runtime_error &)
+    {}
+
+    const Shape::Path &moved(shapePath.path());
+    for (size_t i = 0; i < path.coords.size(); ++i)
+    {
+        if (moved.coords[i] != path.coords[i] + 5.)
+        {
+            printf("filter: coordinate %zu is %f, expected %f\n",
+                   i, moved.coords[i], path.coords[i] + 5.);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int main()
+{
+    const char *shapes[] =
+    {
+        // fractional edges
+        "m 10.3 10.6 l 50.7 10.6 50.7 40.2 10.3 40.2 c",
+        // slopes
+        "m 20 20 l 80 35 30 70 c",
+        // hole, the inner figure goes the other way round
+        "m 10 10 l 90 10 90 90 10 90 c "
+        "m 30.5 30.5 l 30.5 69.5 69.5 69.5 69.5 30.5 c",
+        // curves
+        "m 50 10 b 72 10 90 28 90 50 b 90 72 72 90 50 90 "
+        "b 28 90 10 72 10 50 b 10 28 28 10 50 10 c",
+    };
+
+    const double curves[][8] =
+    {
+        // first control point on the start point
+        {0., 0., 0., 0., 100., 0., 100., 100.},
+        // s shaped
+        {10., 80., 40., -20., 90., 130., 120., 30.},
+    };
+
+    try
+    {
+        for (const double *curve : curves)
+        {
+            if (compareFlatten(curve))
+            {
+                return 1;
+            }
+        }
+
+        std::string axis("z");
+        std::shared_ptr<Math::Matrix> translation(Math::Matrix::create());
+        translation->translate(15., -7., 3.);
+        std::shared_ptr<Math::Matrix> scaling(Math::Matrix::create());
+        scaling->scale(2., .5, 4.);
+        std::shared_ptr<Math::Matrix> rotation(Math::Matrix::create());
+        rotation->rotate(axis, .7);
+        std::shared_ptr<Math::Matrix> combined(Math::Matrix::create());
+        combined->translate(15., -7., 3.);
+        combined->rotate(axis, .7);
+        combined->scale(2., .5, 4.);
+        std::shared_ptr<Math::Matrix> matrices[] =
+        {
+            translation, scaling, rotation, combined
+        };
+
+        for (auto &matrix : matrices)
+        {
+            if (compareTransform(matrix))
+            {
+                return 1;
+            }
+        }
+
+        if (compareUnfinishedCurve() || compareLinePoints() ||
+            compareFilterThrow())
+        {
+            return 1;
+        }
+
+        for (const char *shape : shapes)
+        {
+            if (compare(shape))
+            {
+                return 1;
+            }
+        }
+    }
+    catch (std::exception &e)
+    {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
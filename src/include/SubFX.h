@@ -28,6 +28,7 @@
 
 #include "internal/ass.h"
 #include "internal/fonthandle.h"
+#include "internal/shapepath.h"
 
 #if defined _WIN32 || defined __CYGWIN__
 #ifdef __MINGW32__
@@ -63,6 +64,8 @@ typedef struct SubFX
 
     subfx_ass_api ass;
 
+    subfx_assParser_api assParser;
+
     subfx_fontHandle_api fontHandle;
 
     /**
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -33,7 +34,6 @@ extern "C"
 
 #define SUBFX_FONT_NAME_LEN 32
 #define SUBFX_COLOR_ALPHA_LEN 16
-#define SUBFX_ASS_TEXT_LEN (1 << 16) // maybe too large? maybe too small? or dynamic allocate?
 
 typedef struct subfx_ass_meta
 {
@@ -74,10 +74,15 @@ typedef struct subfx_ass_style
     char alpha4[SUBFX_COLOR_ALPHA_LEN];
 } subfx_ass_style;
 
+// All strings below are '\0' terminated and owned by the parser,
+// they are valid until subfx_assParser's destory is called.
+// The lengths are in bytes, without the '\0'.
+
 #define subfx_ass_symbol \
     uint64_t start_time; \
     uint64_t end_time; \
-    char text[SUBFX_ASS_TEXT_LEN]; \
+    const char *text; \
+    size_t text_len; \
     uint32_t i; \
     uint64_t duration; \
     uint64_t mid_time; \
@@ -96,19 +101,19 @@ typedef struct subfx_ass_style
     double bottom; \
     double y;
 
-// maybe too large? maybe too small? or dynamic allocate?
-#define SUBFX_ASS_CHUNKED_TEXT_SIZE (1 << 8)
-
 typedef struct subfx_ass_chunked
 {
-    char tags[SUBFX_ASS_CHUNKED_TEXT_SIZE];
-    char text[SUBFX_ASS_CHUNKED_TEXT_SIZE];
+    const char *tags;
+    size_t tags_len;
+    const char *text;
+    size_t text_len;
 } subfx_ass_chunked;
 
 typedef struct subfx_ass_syl
 {
     subfx_ass_symbol
-    char tags[SUBFX_ASS_CHUNKED_TEXT_SIZE];
+    const char *tags;
+    size_t tags_len;
     uint32_t prespace;
     uint32_t postspace;
 } subfx_ass_syl;
@@ -131,7 +136,8 @@ typedef struct subfx_ass_dialog
 {
     subfx_ass_symbol
     subfx_ass_style *styleref;
-    char text_stripped[SUBFX_ASS_CHUNKED_TEXT_SIZE];
+    const char *text_stripped;
+    size_t text_stripped_len;
     bool comment;
     uint32_t layer;
     char style[32];
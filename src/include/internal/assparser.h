@@ -44,11 +44,36 @@ typedef struct subfx_assParser_api
 
     subfx_exitstate (*destory)(subfx_assParser *parser);
 
+    /**
+     * Splits dialogs into syls, words and chars, and measures them.
+     * It uses as many threads as processors, see extendDialogs2().
+     */
     subfx_exitstate (*extendDialogs)(subfx_assParser *parser,
                                      char *errMsg);
 
+    /**
+     * Same as extendDialogs(), but with the given number of threads.
+     *
+     * @param threads 0 means the number of processors.
+     * The results and their order do not depend on it.
+     */
+    subfx_exitstate (*extendDialogs2)(subfx_assParser *parser,
+                                      uint32_t threads,
+                                      char *errMsg);
+
     subfx_exitstate (*dialogIsExtended)(subfx_assParser *parser, bool *out);
 
+    /**
+     * Font handles are created once per style and thread
+     * by extendDialogs(), this reports how well that works.
+     *
+     * @param hits how many times a font handle is reused.
+     * @param misses how many font handles are created.
+     */
+    subfx_exitstate (*fontCacheStats)(subfx_assParser *parser,
+                                      size_t *hits,
+                                      size_t *misses);
+
 } subfx_assParser_api;
 
 #ifdef __cplusplus
@@ -21,8 +21,10 @@
 
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "defines.h"
+#include "shapepath.h"
 
 #define subfx_fonthandle_metrics_height           0
 #define subfx_fonthandle_metrics_ascent           1
@@ -33,6 +35,12 @@
 #define subfx_fonthandle_text_extents_width  0
 #define subfx_fonthandle_text_extents_height 1
 
+// see setCacheMode()
+#define subfx_fonthandle_cache_none     0x0
+#define subfx_fonthandle_cache_extents  0x1
+#define subfx_fonthandle_cache_advances 0x2
+#define subfx_fonthandle_cache_glyphs   0x4
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -95,6 +103,68 @@ typedef struct subfx_fontHandle_api
     double *(*text_extents)(subfx_fontHandle *fontHandle,
                             const char *text);
 
+    /**
+     * Same as text_extents(), but it writes to out and allocates nothing.
+     *
+     * @param fonthandle the fonthandle return from create()
+     * @param text input text, it does not need to be '\0' terminated.
+     * @param textLen length of text in bytes.
+     * @param out buffer of at least 2 doubles.
+     */
+    subfx_exitstate (*text_extents2)(subfx_fontHandle *fontHandle,
+                                     const char *text,
+                                     size_t textLen,
+                                     double *out);
+
+    /**
+     * Sets how text_extents() and text_extents2() reuse earlier results,
+     * mode is a combination of followings:
+     * subfx_fonthandle_cache_extents: remembers the extents of every text,
+     * this is the default.
+     * subfx_fonthandle_cache_advances: adds up remembered widths of single
+     * characters for Latin and CJK text, and falls back to a full layout
+     * when kerning changes the width, or for text with characters that
+     * ligatures start from, like f and punctuation. It has no effect on
+     * Windows.
+     * subfx_fonthandle_cache_glyphs: text_to_path() and text_to_shape()
+     * put the outline together from remembered glyph outlines, this is
+     * also the default. It has no effect on Windows, nor with underline
+     * or strikeout.
+     *
+     * @param fonthandle the fonthandle return from create()
+     * @param mode subfx_fonthandle_cache_none to measure every time.
+     */
+    subfx_exitstate (*setCacheMode)(subfx_fontHandle *fontHandle,
+                                    uint8_t mode);
+
+    /**
+     * How many times text_extents() found its result in the cache.
+     *
+     * @param fonthandle the fonthandle return from create()
+     */
+    subfx_exitstate (*cacheStats)(subfx_fontHandle *fontHandle,
+                                  size_t *hits,
+                                  size_t *misses);
+
+    /**
+     * Limits the memory of remembered glyph outlines, the least recently
+     * used ones are dropped first. The default is 4 MiB.
+     *
+     * @param fonthandle the fonthandle return from create()
+     * @param bytes 0 forgets every outline and stops remembering.
+     */
+    subfx_exitstate (*setGlyphCacheBudget)(subfx_fontHandle *fontHandle,
+                                           size_t bytes);
+
+    /**
+     * How many times a glyph outline was found in the cache.
+     *
+     * @param fonthandle the fonthandle return from create()
+     */
+    subfx_exitstate (*glyphCacheStats)(subfx_fontHandle *fontHandle,
+                                       size_t *hits,
+                                       size_t *misses);
+
     /**
      * Converts text with given font to an ASS shape.
      *
@@ -105,6 +175,48 @@ typedef struct subfx_fontHandle_api
      */
     char *(*text_to_shape)(subfx_fontHandle *fontHandle,
                            const char *text, char *errMsg);
+
+    /**
+     * Same as text_to_shape(), but it also gives the length of the shape.
+     *
+     * @param fonthandle the fonthandle return from create()
+     * @param text input text
+     * @param len the length of the result without '\0', can be NULL.
+     * @param errMsg you can pass buffer if you want to get the error message.
+     * @return If fail, it will return NULL.
+     */
+    char *(*text_to_shape2)(subfx_fontHandle *fontHandle,
+                            const char *text,
+                            size_t *len,
+                            char *errMsg);
+
+    /**
+     * Same outline as text_to_shape(), but as commands and coordinates,
+     * so nothing is formatted to text. Coordinates are not rounded.
+     *
+     * @param fonthandle the fonthandle return from create()
+     * @param text input text
+     * @param errMsg you can pass buffer if you want to get the error message.
+     * @return If fail, it will return NULL, else release it by destoryPath().
+     */
+    subfx_shapePath *(*text_to_path)(subfx_fontHandle *fontHandle,
+                                     const char *text,
+                                     char *errMsg);
+
+    /**
+     * Converts a path to an ASS shape, text_to_shape() is
+     * text_to_path() followed by this.
+     *
+     * @param path the path return from text_to_path()
+     * @param len the length of the result without '\0', can be NULL.
+     * @param errMsg you can pass buffer if you want to get the error message.
+     * @return If fail, it will return NULL.
+     */
+    char *(*path_to_shape)(const subfx_shapePath *path,
+                           size_t *len,
+                           char *errMsg);
+
+    subfx_exitstate (*destoryPath)(subfx_shapePath *path);
 } subfx_fontHandle_api;
 
 #ifdef __cplusplus
@@ -30,8 +30,40 @@ extern "C"
 
 typedef struct subfx_misc_api
 {
+    /**
+     * Formats input as "%.3f".
+     *
+     * @return If fail, it will return NULL, else free() it.
+     */
     char *(*doubleToString)(double input);
 
+    /**
+     * Same as doubleToString(), but it writes to buffer and allocates
+     * nothing. 24 bytes are enough for any number below 2^53 / 1000.
+     *
+     * @param buffer the result is '\0' terminated.
+     * @param bufferSize the size of buffer.
+     * @return the length of the result without '\0',
+     * 0 if buffer is too small.
+     */
+    size_t (*doubleToString2)(double input,
+                              char *buffer,
+                              size_t bufferSize);
+
+    /**
+     * Formats count numbers like doubleToString2(), separated by a space,
+     * e.g. the points of a shape.
+     *
+     * @param buffer the result is '\0' terminated.
+     * @param bufferSize the size of buffer.
+     * @return the length of the result without '\0',
+     * 0 if buffer is too small.
+     */
+    size_t (*doublesToString)(const double *input,
+                              size_t count,
+                              char *buffer,
+                              size_t bufferSize);
+
     subfx_exitstate (*getLine)(char *buffer,
                                size_t bufferSize,
                                FILE *file,
@@ -0,0 +1,60 @@
+/*
+*    This file is part of SubFX,
+*    Copyright(C) 2019-2021 fdar0536.
+*
+*    SubFX is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Lesser General Public License as
+*    published by the Free Software Foundation, either version 2.1
+*    of the License, or (at your option) any later version.
+*
+*    SubFX is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*    GNU Lesser General Public License for more details.
+*
+*    You should have received a copy of the GNU Lesser General
+*    Public License along with SubFX. If not, see
+*    <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+
+// commands of subfx_shapePath, and how many points each one has
+#define subfx_shapePath_move  0 // 1 point, "m"
+#define subfx_shapePath_line  1 // 1 point, "l"
+#define subfx_shapePath_curve 2 // 3 points, "b"
+#define subfx_shapePath_close 3 // no point, "c"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * An outline kept as numbers instead of an ASS shape string.
+ * ops holds one command per entry, coords holds the x, y pairs of all
+ * commands in the same order, so no command has to be parsed back out
+ * of text.
+ */
+typedef struct subfx_shapePath
+{
+    uint8_t *ops;
+
+    size_t opCount;
+
+    double *coords;
+
+    // number of doubles, twice the number of points
+    size_t coordCount;
+
+    size_t opCapacity;
+
+    size_t coordCapacity;
+} subfx_shapePath;
+
+#ifdef __cplusplus
+}
+#endif
@@ -21,6 +21,10 @@
 
 #include <vector>
 #include <map>
+#include <memory>
+#include <ostream>
+
+#include <cstdio>
 
 #include "../basecommon.h"
 #include "assparser.hpp"
@@ -31,9 +35,23 @@ namespace PROJ_NAMESPACE
 namespace Yutils
 {
 
+namespace AssWriter_Internal
+{
+
+class FileBuffer;
+
+} // end namespace AssWriter_Internal
+
 namespace AssWriter
 {
 
+// Output is collected in a buffer of size bytes and written to the file
+// when it is full, 1 MiB by default, size must be within 64 KiB and 64 MiB.
+// It applies to all following writes.
+SYMBOL_SHOW void setBufferSize(size_t size) THROW;
+
+SYMBOL_SHOW size_t bufferSize() NOTHROW;
+
 SYMBOL_SHOW void write(const char *fileName,
                        std::shared_ptr<AssParser> &parser) THROW;
 
@@ -57,6 +75,55 @@ SYMBOL_SHOW void write(std::shared_ptr<AssMeta> &meta,
                        std::shared_ptr<AssStyle>> &styles,
                        std::vector<std::string> &assBuf) THROW;
 
+// Writes an ASS file while its events are made: meta, styles and the
+// event header are written when it is created, events are kept only
+// in a buffer of bufferSize() bytes before they go to the file,
+// so memory does not grow with the output.
+class SYMBOL_SHOW Sink
+{
+public:
+
+    // here may throw exception
+    Sink(const char *fileName,
+         std::shared_ptr<AssMeta> &meta,
+         std::map<std::string, std::shared_ptr<AssStyle>> &styles) THROW;
+
+    // Writes events only, e.g. a part of the events of a file,
+    // which is joined to it later
+    // here may throw exception
+    explicit Sink(const char *fileName) THROW;
+
+    Sink(const Sink &) = delete;
+
+    Sink &operator=(const Sink &) = delete;
+
+    // closes the file if close was not called
+    ~Sink();
+
+    // Writes every string as an event line
+    void write(const std::vector<std::string> &events) THROW;
+
+    // Hands the buffered events to the file
+    void flush() THROW;
+
+    // Flushes and closes the file, later writes throw
+    void close() THROW;
+
+    // Event lines written so far
+    size_t events() const NOTHROW;
+
+private:
+
+    // declared first, so the buffer is flushed before the file is closed
+    std::unique_ptr<FILE, int(*)(FILE *)> m_file;
+
+    std::unique_ptr<AssWriter_Internal::FileBuffer> m_buffer;
+
+    std::unique_ptr<std::ostream> m_stream;
+
+    size_t m_events;
+};
+
 } // end namespace AssWriter
 
 } // end namespace Yutils
@@ -51,6 +51,14 @@ public:
     Eigen::Vector4d
     transform(double x, double y, double z, double w) NOTHROW;
 
+    // Applies matrix to count points in place, points holds x, y
+    // (dimension 2) or x, y, z (dimension 3) of every point, missing z is 0
+    // and w is 1. If perspective is true, results are divided by their w.
+    void transformPoints(double *points,
+                         size_t count,
+                         uint8_t dimension,
+                         bool perspective = false) const THROW;
+
 private:
 
     Matrix() {}
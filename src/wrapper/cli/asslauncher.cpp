@@ -1,18 +1,130 @@
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
 
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
 #include <ctime>
 
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #include "asslauncher.hpp"
+#include "cachekey.hpp"
 
 #include "pybind11/cast.h"
 #include "pybind11/attr.h"
 #include "pybind11/stl.h"
+#include "pybind11/embed.h"
+#include "config.h"
 
 namespace py = pybind11;
 
+// tells apart the files of runs that share an output,
+// and of the workers of a run
+static long processId()
+{
+#ifdef _WIN32
+    return static_cast<long>(_getpid());
+#else
+    return static_cast<long>(getpid());
+#endif
+}
+
+// events of config made by job of the execJobs run in process run
+static std::string segmentName(const std::string &output,
+                               long run,
+                               size_t job,
+                               size_t config)
+{
+    return output + "." + std::to_string(run) + ".job" +
+            std::to_string(job) + "." + std::to_string(config);
+}
+
+// where exec and execJobs write the output until it is complete,
+// it is renamed over the output only then, so a failed run never
+// leaves a truncated or header only output behind
+static std::string partName(const std::string &output)
+{
+    return output + ".part";
+}
+
+// where exec and the workers of execJobs keep the events of every dialog
+static std::string cacheDirName(const std::string &output)
+{
+    return output + ".cache";
+}
+
+#ifndef _WIN32
+// removes what workers of execJobs wrote, merged or not
+static void removeSegments(const std::string &output,
+                           size_t jobs,
+                           size_t configs)
+{
+    for (size_t config = 0; config < configs; ++config)
+    {
+        for (size_t job = 0; job < jobs; ++job)
+        {
+            remove(segmentName(output, processId(), job, config).c_str());
+        }
+    }
+}
+
+// waitpid, retried when a signal interrupts it,
+// returns true if the worker exited with 0
+static bool waitJob(int pid)
+{
+    int status(0);
+    while (waitpid(pid, &status, 0) < 0)
+    {
+        if (errno != EINTR)
+        {
+            return false;
+        }
+    }
+
+    return WIFEXITED(status) && !WEXITSTATUS(status);
+}
+
+// terminates the workers of execJobs when there is nothing to merge
+static void stopJobs(std::shared_ptr<ConfigParser> &assConfig,
+                     std::vector<int> &pids,
+                     std::vector<int> &progressFds)
+{
+    for (int pid : pids)
+    {
+        kill(pid, SIGTERM);
+    }
+
+    for (int fd : progressFds)
+    {
+        close(fd);
+    }
+
+    for (int pid : pids)
+    {
+        waitJob(pid);
+    }
+
+    // after every worker is gone, none of them writes any more
+    removeSegments(assConfig->getOutputFileName(), pids.size(),
+                   assConfig->getConfigDatas().size());
+}
+#endif
+
 std::shared_ptr<AssLauncher>
-AssLauncher::create() NOTHROW
+AssLauncher::create(bool useCache) NOTHROW
 {
     AssLauncher *ret(new (std::nothrow) AssLauncher());
     if (!ret)
@@ -20,6 +132,8 @@ AssLauncher::create() NOTHROW
         return nullptr;
     }
 
+    ret->m_useCache = useCache;
+
     try
     {
 #if (defined(_WIN32) && \
@@ -48,25 +162,36 @@ AssLauncher::create() NOTHROW
 
 int AssLauncher::exec(std::shared_ptr<ConfigParser> &assConfig) NOTHROW
 {
-    if (assConfig->getLogFileName() == "stdout")
+    if (createLogger(assConfig, ""))
     {
-        m_logger = PROJ_NAMESPACE::Utils::Logger::create();
+        return 1;
     }
-    else
+
+    if (getParser(assConfig))
     {
-        m_logger = PROJ_NAMESPACE::Utils::Logger::create(
-                    assConfig->getLogFileName(),
-                    assConfig->getLogFileName());
+        return 1;
     }
 
-    if (m_logger == nullptr)
+    if (m_useCache && initCache(assConfig))
     {
-        std::cerr << "Fail to create logger" << std::endl;
         return 1;
     }
 
-    if (getParser(assConfig))
+    // meta and styles are written first, so no event is kept until the end
+    std::string output(assConfig->getOutputFileName());
+    std::string part(partName(output));
+    auto meta(m_parser.attr("meta")());
+    auto styles(m_parser.attr("styles")());
+    try
     {
+        m_sink = m_yutils.attr("AssWriter").attr("Sink")(part.c_str(),
+                                                          meta,
+                                                          styles);
+    }
+    catch (py::error_already_set &e)
+    {
+        m_logger->writeErr(e.what());
+        remove(part.c_str());
         return 1;
     }
 
@@ -79,32 +204,41 @@ int AssLauncher::exec(std::shared_ptr<ConfigParser> &assConfig) NOTHROW
         if (execConfig(config, dialogs))
         {
             reset();
+            remove(part.c_str());
             std::cout << std::endl;
             return 1;
         }
 
+        // events of every script are on disk before the next one starts
+        try
+        {
+            m_sink.attr("flush")();
+        }
+        catch (py::error_already_set &e)
+        {
+            m_logger->writeErr(e.what());
+            reset();
+            remove(part.c_str());
+            return 1;
+        }
+
         std::cout << std::endl;
         ++m_currentConfig;
     }
 
-    auto meta(m_parser.attr("meta")());
-    auto styles(m_parser.attr("styles")());
-
-    // todo: find better way to solve this problem
-    py::list assBuf(py::cast(m_assBuf));
-
+    reportCache();
+    reportTimes();
     std::cout << "Writing output..." << std::endl;
     try
     {
-        m_yutils.attr("AssWriter").attr("write")(
-                    assConfig->getOutputFileName().c_str(),
-                    meta,
-                    styles,
-                    assBuf);
+        m_sink.attr("close")();
+        py::module::import("os").attr("replace")(part, output);
     }
     catch (py::error_already_set &e)
     {
         m_logger->writeErr(e.what());
+        reset();
+        remove(part.c_str());
         return 1;
     }
 
@@ -113,8 +247,110 @@ int AssLauncher::exec(std::shared_ptr<ConfigParser> &assConfig) NOTHROW
     return 0;
 }
 
+int AssLauncher::execJobs(std::shared_ptr<ConfigParser> &assConfig,
+                          size_t jobs,
+                          bool useCache) NOTHROW
+{
+#ifdef _WIN32
+    std::cerr << "--jobs needs fork, running in one process." << std::endl;
+    UNUSED(jobs);
+    py::scoped_interpreter guard{};
+    std::shared_ptr<AssLauncher> launcher(create(useCache));
+    return launcher ? launcher->exec(assConfig) : 1;
+#else
+    // workers are forked before any interpreter exists,
+    // so each of them starts a clean one
+    long run(processId());
+    std::vector<int> pids;
+    std::vector<int> progressFds;
+    for (size_t job = 0; job < jobs; ++job)
+    {
+        int fds[2];
+        if (pipe(fds))
+        {
+            perror("pipe");
+            break;
+        }
+
+        std::cout.flush();
+        std::cerr.flush();
+        int pid(fork());
+        if (pid < 0)
+        {
+            perror("fork");
+            close(fds[0]);
+            close(fds[1]);
+            break;
+        }
+
+        if (pid == 0)
+        {
+            // worker
+            for (int fd : progressFds)
+            {
+                close(fd);
+            }
+
+            close(fds[0]);
+            int ret(1);
+            {
+                py::scoped_interpreter guard{};
+                std::shared_ptr<AssLauncher> launcher(create(useCache));
+                if (launcher)
+                {
+                    ret = launcher->execJob(assConfig, run, job, jobs,
+                                            fds[1]);
+                }
+            }
+
+            close(fds[1]);
+            std::cout.flush();
+            _exit(ret);
+        }
+
+        close(fds[1]);
+        pids.push_back(pid);
+        progressFds.push_back(fds[0]);
+    } // end for (size_t job = 0; job < jobs; ++job)
+
+    py::scoped_interpreter guard{};
+    std::shared_ptr<AssLauncher> launcher(create(useCache));
+    if (!launcher || pids.size() != jobs)
+    {
+        stopJobs(assConfig, pids, progressFds);
+        return 1;
+    }
+
+    return launcher->mergeJobs(assConfig, pids, progressFds);
+#endif
+}
+
 // private member functions
 
+int AssLauncher::createLogger(std::shared_ptr<ConfigParser> &assConfig,
+                              const std::string &suffix) NOTHROW
+{
+    if (assConfig->getLogFileName() == "stdout")
+    {
+        m_logger = PROJ_NAMESPACE::Utils::Logger::create();
+    }
+    else
+    {
+        // workers have their own log files, so they never write at once
+        std::string logFileName(assConfig->getLogFileName() + suffix);
+        m_logger = PROJ_NAMESPACE::Utils::Logger::create(logFileName,
+                                                          logFileName);
+    }
+
+    if (m_logger == nullptr)
+    {
+        std::cerr << "Fail to create logger" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
 int AssLauncher::getParser(std::shared_ptr<ConfigParser> &assConfig) NOTHROW
 {
     try
@@ -132,10 +368,312 @@ int AssLauncher::getParser(std::shared_ptr<ConfigParser> &assConfig) NOTHROW
     return 0;
 }
 
+int AssLauncher::execJob(std::shared_ptr<ConfigParser> &assConfig,
+                         long run,
+                         size_t job,
+                         size_t jobs,
+                         int progressFd) NOTHROW
+{
+    if (createLogger(assConfig, ".job" + std::to_string(job)))
+    {
+        return 1;
+    }
+
+    if (getParser(assConfig))
+    {
+        return 1;
+    }
+
+    if (m_useCache && initCache(assConfig))
+    {
+        return 1;
+    }
+
+    m_job = job;
+    m_jobs = jobs;
+    m_progressFd = progressFd;
+
+    auto configs(assConfig->getConfigDatas());
+    py::list dialogs(m_parser.attr("dialogs")());
+    m_totalConfigs = configs.size();
+    for (size_t i = 0; i < m_totalConfigs; ++i)
+    {
+        try
+        {
+            m_sink = m_yutils.attr("AssWriter").attr("Sink")(
+                        segmentName(assConfig->getOutputFileName(),
+                                    run, job, i).c_str());
+        }
+        catch (py::error_already_set &e)
+        {
+            m_logger->writeErr(e.what());
+            reset();
+            return 1;
+        }
+
+        auto config(configs.at(i));
+        if (execConfig(config, dialogs))
+        {
+            reset();
+            return 1;
+        }
+
+        try
+        {
+            m_sink.attr("close")();
+        }
+        catch (py::error_already_set &e)
+        {
+            m_logger->writeErr(e.what());
+            reset();
+            return 1;
+        }
+
+        ++m_currentConfig;
+    }
+
+    reportTimes();
+    reset();
+
+    return 0;
+}
+
+int AssLauncher::mergeJobs(std::shared_ptr<ConfigParser> &assConfig,
+                           std::vector<int> &pids,
+                           std::vector<int> &progressFds) NOTHROW
+{
+#ifdef _WIN32
+    UNUSED(assConfig);
+    UNUSED(pids);
+    UNUSED(progressFds);
+    return 1;
+#else
+    if (createLogger(assConfig, ""))
+    {
+        stopJobs(assConfig, pids, progressFds);
+        return 1;
+    }
+
+    int ret(getParser(assConfig));
+
+    // lines of all configs, the way execConfig counts them
+    size_t totalLines(0);
+    auto configs(assConfig->getConfigDatas());
+    std::string output(assConfig->getOutputFileName());
+    std::string part(partName(output));
+    if (!ret)
+    {
+        size_t dialogs(py::len(m_parser.attr("dialogs")()));
+        for (auto &config : configs)
+        {
+            size_t endLine(config->endLine < 0 ?
+                               (dialogs - 1) :
+                               static_cast<size_t>(config->endLine));
+            size_t startLine(static_cast<size_t>(config->startLine));
+            if (startLine <= endLine && endLine < dialogs)
+            {
+                totalLines += endLine - startLine + 1;
+            }
+        }
+
+        // meta and styles are written while the workers run
+        try
+        {
+            auto meta(m_parser.attr("meta")());
+            auto styles(m_parser.attr("styles")());
+            m_yutils.attr("AssWriter").attr("Sink")(part.c_str(),
+                                                    meta,
+                                                    styles).attr("close")();
+        }
+        catch (py::error_already_set &e)
+        {
+            m_logger->writeErr(e.what());
+            ret = 1;
+        }
+    }
+
+    if (ret)
+    {
+        for (int pid : pids)
+        {
+            kill(pid, SIGTERM);
+        }
+    }
+
+    // every worker writes a byte per line, until it exits,
+    // 2 if the line was cached, 1 otherwise
+    std::vector<struct pollfd> fds;
+    for (int fd : progressFds)
+    {
+        fds.push_back({fd, POLLIN, 0});
+    }
+
+    size_t doneLines(0), openFds(fds.size());
+    char buffer[4096];
+    std::cout << std::setiosflags(std::ios::fixed) << std::setprecision(3);
+    while (openFds)
+    {
+        if (poll(fds.data(), fds.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            break;
+        }
+
+        for (auto &fd : fds)
+        {
+            if (fd.fd < 0 || !fd.revents)
+            {
+                continue;
+            }
+
+            ssize_t length(read(fd.fd, buffer, sizeof(buffer)));
+            if (length > 0)
+            {
+                doneLines += static_cast<size_t>(length);
+                for (ssize_t i = 0; i < length; ++i)
+                {
+                    m_cacheHits += (buffer[i] == 2);
+                }
+
+                continue;
+            }
+
+            if (length < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            close(fd.fd);
+            fd.fd = -1;
+            --openFds;
+        }
+
+        if (totalLines)
+        {
+            std::cout << "Total progress: "
+                      << (100. * static_cast<double>(doneLines) /
+                          static_cast<double>(totalLines))
+                      << "% (" << pids.size() << " jobs)\r" << std::flush;
+        }
+    } // end while (openFds)
+
+    std::cout << std::endl;
+    m_cacheDir = cacheDirName(output);
+    m_cacheMisses = doneLines - m_cacheHits;
+    reportCache();
+    for (auto &fd : fds)
+    {
+        if (fd.fd >= 0)
+        {
+            close(fd.fd);
+        }
+    }
+
+    for (size_t i = 0; i < pids.size(); ++i)
+    {
+        if (!waitJob(pids.at(i)))
+        {
+            std::string error("Error: job ");
+            error += std::to_string(i);
+            error += " failed, see its log for details.\n";
+            m_logger->writeErr(error);
+            ret = 1;
+        }
+    }
+
+    // segments are joined in dialog order: configs in order,
+    // and the slices of every config in order
+    std::cout << "Writing output..." << std::endl;
+    FILE *file(ret ? nullptr : fopen(part.c_str(), "ab"));
+    if (!ret && !file)
+    {
+        m_logger->writeErr("Error: CANNOT open output file.\n");
+        ret = 1;
+    }
+
+    std::vector<char> copyBuffer(file ? (1 << 20) : 0);
+    for (size_t config = 0; config < configs.size(); ++config)
+    {
+        for (size_t job = 0; job < pids.size(); ++job)
+        {
+            std::string segment(segmentName(output, processId(), job,
+                                            config));
+            FILE *input(file ? fopen(segment.c_str(), "rb") : nullptr);
+            if (file && !input)
+            {
+                m_logger->writeErr("Error: CANNOT open " + segment + "\n");
+                ret = 1;
+            }
+
+            while (input)
+            {
+                size_t length(fread(copyBuffer.data(), 1,
+                                    copyBuffer.size(), input));
+                if (!length)
+                {
+                    break;
+                }
+
+                if (fwrite(copyBuffer.data(), 1, length, file) != length)
+                {
+                    m_logger->writeErr("Error: CANNOT write output file.\n");
+                    ret = 1;
+                    break;
+                }
+            }
+
+            if (input)
+            {
+                fclose(input);
+            }
+
+            remove(segment.c_str());
+        }
+    }
+
+    if (file && fclose(file))
+    {
+        m_logger->writeErr("Error: CANNOT write output file.\n");
+        ret = 1;
+    }
+
+    if (!ret)
+    {
+        try
+        {
+            py::module::import("os").attr("replace")(part, output);
+        }
+        catch (py::error_already_set &e)
+        {
+            m_logger->writeErr(e.what());
+            ret = 1;
+        }
+    }
+
+    if (ret)
+    {
+        remove(part.c_str());
+    }
+
+    reset();
+
+    return ret;
+#endif
+}
+
 void AssLauncher::reset()
 {
-    m_resString.clear();
-    m_assBuf.clear();
+    // an unclosed sink flushes and closes its file when it is released
+    m_sink = py::object();
+    m_cacheHits = 0;
+    m_cacheMisses = 0;
+    m_mains.clear();
+    m_importSeconds = 0.;
+    m_effectSeconds = 0.;
     m_totalConfigs = 0;
     m_currentConfig = 1;
 }
@@ -146,12 +684,7 @@ int AssLauncher::execConfig(std::shared_ptr<ConfigData> &config,
     py::object mainObj;
     try
     {
-        py::object imp = py::module::import("importlib.util");
-        py::object spec = imp.attr("spec_from_file_location")("main",
-                                                    config->scriptName);
-        mainObj = imp.attr("module_from_spec")(spec);
-        spec.attr("loader").attr("exec_module")(mainObj);
-        mainObj = mainObj.attr("SubFXMain");
+        mainObj = getMain(config->scriptName);
     }
     catch (py::error_already_set &e)
     {
@@ -216,68 +749,364 @@ int AssLauncher::execConfig(std::shared_ptr<ConfigData> &config,
         return 1;
     }
 
-    py::list dialogsBak(dialogs);
-    std::cout << "Current script: " << config->scriptName << std::endl;
+    if (m_progressFd < 0)
+    {
+        std::cout << "Current script: " << config->scriptName << std::endl;
+    }
+
+    // a worker of execJobs runs its own contiguous slice of the lines
     size_t totalLines(endLine - startLine + 1);
-    for (size_t i = startLine; i <= endLine; ++i)
+    size_t firstLine(startLine + totalLines * m_job / m_jobs);
+    size_t lastLine(startLine + totalLines * (m_job + 1) / m_jobs);
+    // a dialog is read back from the cache while the script, the mode,
+    // the library, the dialog itself and its style are unchanged
+    py::object scriptHash;
+    py::dict styles;
+    if (m_useCache)
+    {
+        try
+        {
+            scriptHash = hashScript(config->scriptName, modeName);
+            styles = m_parser.attr("styles")();
+        }
+        catch (py::error_already_set &e)
+        {
+            pExecConfigError(e);
+            return 1;
+        }
+    }
+
+    for (size_t i = firstLine; i < lastLine; ++i)
     {
-        py::dict line(dialogsBak[i]);
-        py::object resObj;
-        if (modeName == "line")
+        py::dict line(dialogs[i]);
+        std::string cacheKey;
+        m_lineCached = false;
+        if (m_useCache)
         {
             try
             {
-                resObj = mainObj(line, py::list());
-                m_resString = resObj.cast<std::vector<std::string>>();
+                py::object style(py::none());
+                if (line.contains("style"))
+                {
+                    py::object styleName(line["style"]);
+                    if (styles.contains(styleName))
+                    {
+                        style = styles[styleName];
+                    }
+                }
+
+                py::object hash(scriptHash.attr("copy")());
+                hash.attr("update")(py::bytes(dialogCacheKey(line, style)));
+                cacheKey = hash.attr("hexdigest")().cast<std::string>();
+                m_lineCached = readCache(cacheKey);
             }
             catch (py::error_already_set &e)
             {
                 pExecConfigError(e);
                 return 1;
             }
-            catch (py::cast_error &e)
+            catch (std::invalid_argument &e)
             {
-                pExecConfigError(e);
-                return 1;
+                // a value the key cannot be made of, the dialog runs
+                // uncached every time
+                m_logger->writeErr(std::string("Warning: ") + e.what() + "\n");
+                cacheKey.clear();
             }
+        }
 
-            m_assBuf.insert(m_assBuf.end(),
-                            m_resString.begin(),
-                            m_resString.end());
+        if (m_lineCached)
+        {
+            ++m_cacheHits;
         }
         else
         {
-            py::list list(line[modeName.c_str()]);
-            for (size_t j = 0; j < py::len(list); ++j)
+            py::list events;
+            if (execDialog(mainObj, line, modeName, events))
             {
-                try
-                {
-                    resObj = mainObj(line, list[j]);
-                    m_resString = resObj.cast<std::vector<std::string>>();
-                }
-                catch (py::error_already_set &e)
-                {
-                    pExecConfigError(e);
-                    return 1;
-                }
-                catch (py::cast_error &e)
+                return 1;
+            }
+
+            if (m_useCache)
+            {
+                ++m_cacheMisses;
+                if (!cacheKey.empty())
                 {
-                    pExecConfigError(e);
-                    return 1;
+                    writeCache(cacheKey, events);
                 }
+            }
+        }
 
-                m_assBuf.insert(m_assBuf.end(),
-                                m_resString.begin(),
-                                m_resString.end());
-            } // end for j
-        } // end if (modeName == "line")
-
-        reportProgress(i + 1, totalLines);
+        reportProgress(i - firstLine + 1, lastLine - firstLine);
     } // end for i
 
     return 0;
 }
 
+int AssLauncher::initCache(std::shared_ptr<ConfigParser> &assConfig) NOTHROW
+{
+    m_cacheDir = cacheDirName(assConfig->getOutputFileName());
+    try
+    {
+        py::module::import("os").attr("makedirs")(m_cacheDir,
+                                                  py::arg("exist_ok") = true);
+        m_hashlib = py::module::import("hashlib");
+    }
+    catch (py::error_already_set &e)
+    {
+        pExecConfigError(e);
+        return 1;
+    }
+
+    return 0;
+}
+
+py::object AssLauncher::hashScript(const std::string &scriptName,
+                                   const std::string &modeName)
+{
+    py::object file(py::module::import("builtins").attr("open")(scriptName,
+                                                                "rb"));
+    py::object content(file.attr("read")());
+    file.attr("close")();
+
+    py::object hash(m_hashlib.attr("sha256")(content));
+    // the last line is the version of the cache file format,
+    // files of another one are never read
+    hash.attr("update")(py::bytes("\n" + modeName + "\n" + PROJ_VERSION +
+                                  "\n2\n"));
+    return hash;
+}
+
+bool AssLauncher::readCache(const std::string &key)
+{
+    std::string fileName(m_cacheDir + "/" + key);
+    std::vector<std::string> events;
+    {
+        std::ifstream file(fileName, std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+
+        if (!readCacheEvents(file, events))
+        {
+            // not written by writeCache, the dialog runs again
+            // and writes the key anew
+            file.close();
+            remove(fileName.c_str());
+            return false;
+        }
+    }
+
+    m_sink.attr("write")(events);
+    return true;
+}
+
+bool AssLauncher::readCacheEvents(std::ifstream &file,
+                                  std::vector<std::string> &events) NOTHROW
+{
+    // every event is its length in bytes, a newline, the event
+    // and a newline, so events may contain newlines themselves
+    if (!file.seekg(0, std::ios::end))
+    {
+        return false;
+    }
+
+    std::streamoff fileSize(file.tellg());
+    if (fileSize < 0 || !file.seekg(0, std::ios::beg))
+    {
+        return false;
+    }
+
+    try
+    {
+        std::string length;
+        while (std::getline(file, length))
+        {
+            if (length.empty() ||
+                length.find_first_not_of("0123456789") != std::string::npos)
+            {
+                return false;
+            }
+
+            errno = 0;
+            char *end(nullptr);
+            unsigned long long size(strtoull(length.c_str(), &end, 10));
+            if (errno || *end != '\0')
+            {
+                return false;
+            }
+
+            // the event and its newline must still be in the file,
+            // a corrupted length never reaches the allocation
+            std::streamoff pos(file.tellg());
+            if (pos < 0 ||
+                size >= static_cast<unsigned long long>(fileSize - pos))
+            {
+                return false;
+            }
+
+            std::string event(static_cast<size_t>(size), '\0');
+            if (!file.read(&event[0], static_cast<std::streamsize>(size)) ||
+                file.get() != '\n')
+            {
+                return false;
+            }
+
+            events.push_back(std::move(event));
+        }
+    }
+    catch (std::exception &)
+    {
+        return false;
+    }
+
+    return file.eof();
+}
+
+void AssLauncher::writeCache(const std::string &key, py::list &events) NOTHROW
+{
+    std::vector<std::string> lines;
+    try
+    {
+        lines = events.cast<std::vector<std::string>>();
+    }
+    catch (py::cast_error &)
+    {
+        return;
+    }
+
+    // written aside and renamed, so a key never has half of its events
+    std::string fileName(m_cacheDir + "/" + key);
+    std::string tmpName(fileName + ".tmp" + std::to_string(processId()));
+    {
+        std::ofstream file(tmpName, std::ios::binary | std::ios::trunc);
+        for (auto &line : lines)
+        {
+            // see readCache
+            file << line.size() << '\n' << line << '\n';
+        }
+
+        if (!file.flush())
+        {
+            file.close();
+            remove(tmpName.c_str());
+            return;
+        }
+    }
+
+    try
+    {
+        py::module::import("os").attr("replace")(tmpName, fileName);
+    }
+    catch (py::error_already_set &)
+    {
+        remove(tmpName.c_str());
+    }
+}
+
+void AssLauncher::reportCache()
+{
+    if (!m_useCache)
+    {
+        return;
+    }
+
+    std::cout << "Cache: " << m_cacheHits << " hits, "
+              << m_cacheMisses << " misses in " << m_cacheDir << std::endl;
+}
+
+py::object AssLauncher::getMain(const std::string &scriptName)
+{
+    auto it(m_mains.find(scriptName));
+    if (it != m_mains.end())
+    {
+        return it->second;
+    }
+
+    auto start(std::chrono::steady_clock::now());
+    py::object imp = py::module::import("importlib.util");
+    py::object spec = imp.attr("spec_from_file_location")("main", scriptName);
+    py::object mainObj = imp.attr("module_from_spec")(spec);
+    spec.attr("loader").attr("exec_module")(mainObj);
+    mainObj = mainObj.attr("SubFXMain");
+    m_importSeconds += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+
+    m_mains.emplace(scriptName, mainObj);
+    return mainObj;
+}
+
+void AssLauncher::reportTimes()
+{
+    std::ostringstream times;
+    times << std::setiosflags(std::ios::fixed) << std::setprecision(3);
+    times << "Time in imports: " << m_importSeconds << " s, in effects: "
+          << m_effectSeconds << " s (" << m_mains.size() << " scripts)\n";
+    if (m_progressFd < 0)
+    {
+        std::cout << times.str();
+    }
+    else
+    {
+        // a worker of execJobs, whose stdout is shared with the others
+        m_logger->writeOut(times.str());
+    }
+}
+
+int AssLauncher::execDialog(py::object &mainObj,
+                            py::dict &line,
+                            std::string &modeName,
+                            py::list &events)
+{
+    py::object resObj;
+    if (modeName == "line")
+    {
+        try
+        {
+            auto start(std::chrono::steady_clock::now());
+            resObj = mainObj(line, py::list());
+            m_effectSeconds += std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start).count();
+            m_sink.attr("write")(resObj);
+            if (m_useCache)
+            {
+                events.attr("extend")(resObj);
+            }
+        }
+        catch (py::error_already_set &e)
+        {
+            pExecConfigError(e);
+            return 1;
+        }
+    }
+    else
+    {
+        py::list list(line[modeName.c_str()]);
+        for (size_t j = 0; j < py::len(list); ++j)
+        {
+            try
+            {
+                auto start(std::chrono::steady_clock::now());
+                resObj = mainObj(line, list[j]);
+                m_effectSeconds += std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start).count();
+                m_sink.attr("write")(resObj);
+                if (m_useCache)
+                {
+                    events.attr("extend")(resObj);
+                }
+            }
+            catch (py::error_already_set &e)
+            {
+                pExecConfigError(e);
+                return 1;
+            }
+        } // end for j
+    } // end if (modeName == "line")
+
+    return 0;
+}
+
 void AssLauncher::pExecConfigWarning(std::string &input)
 {
     const char *now(getCurrentTime());
@@ -315,6 +1144,15 @@ const char *AssLauncher::getCurrentTime()
 
 void AssLauncher::reportProgress(size_t currentLine, size_t totalLines)
 {
+#ifndef _WIN32
+    if (m_progressFd >= 0)
+    {
+        // the parent of execJobs counts the lines of all workers
+        const char line(m_lineCached ? 2 : 1);
+        while (write(m_progressFd, &line, 1) < 0 && errno == EINTR) {}
+        return;
+    }
+#endif
 
     std::cout<< std::setiosflags(std::ios::fixed) << std::setprecision(3);
     double progress = static_cast<double>(currentLine);
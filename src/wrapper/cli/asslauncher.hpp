@@ -1,6 +1,11 @@
 #ifndef ASSLAUNCHER_HPP
 #define ASSLAUNCHER_HPP
 
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
 #include "internal/basecommon.h"
 
 #include "pybind11/pybind11.h"
@@ -14,42 +19,143 @@ class AssLauncher
 {
 public:
 
+    // If useCache is true, events of every dialog are kept in
+    // <output>.cache and read back while the script, the mode and
+    // the dialog are unchanged
     static std::shared_ptr<AssLauncher>
-    create() NOTHROW;
+    create(bool useCache = true) NOTHROW;
 
     int exec(std::shared_ptr<ConfigParser> &assConfig) NOTHROW;
 
+    // Same as exec, but the lines of every config are split into jobs
+    // contiguous slices, each run by a worker process with its own
+    // interpreter and parser. Workers write their events to segment files,
+    // which are joined in dialog order.
+    // Call it before any interpreter is started, it starts its own.
+    // On Windows it falls back to exec.
+    static int execJobs(std::shared_ptr<ConfigParser> &assConfig,
+                        size_t jobs,
+                        bool useCache = true) NOTHROW;
+
 protected:
 
     AssLauncher() :
-        m_assBuf(std::vector<std::string>()),
-        m_resString(std::vector<std::string>()),
         m_totalConfigs(0),
         m_currentConfig(1),
+        m_job(0),
+        m_jobs(1),
+        m_progressFd(-1),
+        m_useCache(true),
+        m_cacheDir(""),
+        m_cacheHits(0),
+        m_cacheMisses(0),
+        m_lineCached(false),
+        m_importSeconds(0.),
+        m_effectSeconds(0.),
         m_yutils(py::object()),
-        m_parser(py::object())
+        m_parser(py::object()),
+        m_sink(py::object()),
+        m_hashlib(py::object()),
+        m_mains(std::map<std::string, py::object>())
     {}
 
 private:
 
-    std::vector<std::string> m_assBuf;
-
-    std::vector<std::string> m_resString;
-
     size_t m_totalConfigs;
 
     size_t m_currentConfig;
 
+    // this process runs the m_job-th of m_jobs slices of every config
+    size_t m_job;
+
+    size_t m_jobs;
+
+    // a worker writes a byte here for every finished line, -1 otherwise
+    int m_progressFd;
+
+    bool m_useCache;
+
+    std::string m_cacheDir;
+
+    size_t m_cacheHits;
+
+    size_t m_cacheMisses;
+
+    // the current line was read from the cache
+    bool m_lineCached;
+
+    // spent in loading scripts and in their SubFXMain
+    double m_importSeconds;
+
+    double m_effectSeconds;
+
     py::object m_yutils;
 
     py::object m_parser;
 
+    // AssWriter.Sink of the output file, events go there as they are made
+    py::object m_sink;
+
+    py::object m_hashlib;
+
+    // SubFXMain of every script loaded in this run, by file name,
+    // so a script listed by several configs is imported once
+    std::map<std::string, py::object> m_mains;
+
     std::shared_ptr<PROJ_NAMESPACE::Utils::Logger> m_logger;
 
+    int createLogger(std::shared_ptr<ConfigParser> &assConfig,
+                     const std::string &suffix) NOTHROW;
+
     int getParser(std::shared_ptr<ConfigParser> &assConfig) NOTHROW;
 
+    // runs in a worker of execJobs, run is the process id of execJobs
+    int execJob(std::shared_ptr<ConfigParser> &assConfig,
+                long run,
+                size_t job,
+                size_t jobs,
+                int progressFd) NOTHROW;
+
+    // runs in the parent of execJobs, writes meta and styles,
+    // reports progress until the workers exit, then joins their segments
+    int mergeJobs(std::shared_ptr<ConfigParser> &assConfig,
+                  std::vector<int> &pids,
+                  std::vector<int> &progressFds) NOTHROW;
+
     void reset();
 
+    // creates the cache directory
+    int initCache(std::shared_ptr<ConfigParser> &assConfig) NOTHROW;
+
+    // hashlib.sha256 of everything but the dialog a cache key depends on
+    py::object hashScript(const std::string &scriptName,
+                          const std::string &modeName);
+
+    // writes the cached events of key to the sink,
+    // returns false if there are none or the file is unreadable,
+    // an unreadable file is removed
+    bool readCache(const std::string &key);
+
+    // reads the events of a cache file, false if it is malformed
+    static bool readCacheEvents(std::ifstream &file,
+                                std::vector<std::string> &events) NOTHROW;
+
+    // failures are ignored, the dialog runs again next time
+    void writeCache(const std::string &key, py::list &events) NOTHROW;
+
+    void reportCache();
+
+    // SubFXMain of scriptName, imported at its first use
+    py::object getMain(const std::string &scriptName);
+
+    void reportTimes();
+
+    // runs the script on one dialog, events go to the sink and to events
+    int execDialog(py::object &mainObj,
+                   py::dict &line,
+                   std::string &modeName,
+                   py::list &events);
+
     int execConfig(std::shared_ptr<ConfigData> &config,
                    py::list &dialogs);
 
@@ -0,0 +1,135 @@
+#include <stdexcept>
+
+#include "cachekey.hpp"
+
+// deeper than any dialog the parser makes, it only stops a cycle
+#define MAX_DEPTH 32
+
+static void writeSized(std::string &out, char tag, const std::string &bytes)
+{
+    out += tag;
+    out += std::to_string(bytes.size());
+    out += ':';
+    out += bytes;
+}
+
+static void writeValue(std::string &out,
+                       py::handle value,
+                       py::handle property,
+                       int depth) THROW
+{
+    if (depth > MAX_DEPTH)
+    {
+        throw std::invalid_argument("dialogCacheKey: too deeply nested");
+    }
+
+    if (value.is_none())
+    {
+        out += 'N';
+        return;
+    }
+
+    // bool before int, it is a subclass of int
+    if (py::isinstance<py::bool_>(value))
+    {
+        out += value.cast<bool>() ? "T" : "F";
+        return;
+    }
+
+    if (py::isinstance<py::int_>(value))
+    {
+        writeSized(out, 'I', py::str(value).cast<std::string>());
+        return;
+    }
+
+    if (py::isinstance<py::float_>(value))
+    {
+        // the shortest text that reads back as the same double
+        writeSized(out, 'D', py::repr(value).cast<std::string>());
+        return;
+    }
+
+    if (py::isinstance<py::str>(value))
+    {
+        writeSized(out, 'S', value.cast<std::string>());
+        return;
+    }
+
+    if (py::isinstance<py::bytes>(value))
+    {
+        writeSized(out, 'B', value.cast<std::string>());
+        return;
+    }
+
+    if (py::isinstance<py::list>(value) || py::isinstance<py::tuple>(value))
+    {
+        out += 'L';
+        out += std::to_string(py::len(value));
+        out += ':';
+        for (auto item : value)
+        {
+            writeValue(out, item, property, depth + 1);
+        }
+
+        return;
+    }
+
+    if (py::isinstance<py::dict>(value))
+    {
+        // the parser fills dictionaries in the same order every run
+        py::dict dict(py::reinterpret_borrow<py::dict>(value));
+        out += 'M';
+        out += std::to_string(dict.size());
+        out += ':';
+        for (auto item : dict)
+        {
+            writeValue(out, item.first, property, depth + 1);
+            writeValue(out, item.second, property, depth + 1);
+        }
+
+        return;
+    }
+
+    // bound classes such as AssSyl have no __repr__, the default one
+    // is their address, so they are written field by field
+    py::handle type(reinterpret_cast<PyObject *>(Py_TYPE(value.ptr())));
+    py::list names(py::module::import("builtins").attr("dir")(type));
+    std::string fields;
+    size_t count(0);
+    for (auto name : names)
+    {
+        std::string key(name.cast<std::string>());
+        if (key.empty() || key[0] == '_' ||
+            !py::isinstance(type.attr(name), property))
+        {
+            continue;
+        }
+
+        writeSized(fields, 'S', key);
+        writeValue(fields, value.attr(name), property, depth + 1);
+        ++count;
+    }
+
+    if (!count)
+    {
+        throw std::invalid_argument("dialogCacheKey: " +
+                                    py::str(type).cast<std::string>() +
+                                    " has no properties");
+    }
+
+    std::string typeName(type.attr("__qualname__").cast<std::string>());
+    writeSized(out, 'O', typeName);
+    out += std::to_string(count);
+    out += ':';
+    out += fields;
+}
+
+std::string dialogCacheKey(py::handle dialog, py::handle style) THROW
+{
+    py::object property(py::module::import("builtins").attr("property"));
+    std::string out;
+    writeValue(out, dialog, property, 0);
+    out += '\n';
+    writeValue(out, style, property, 0);
+    return out;
+}
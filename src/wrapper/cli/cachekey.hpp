@@ -0,0 +1,20 @@
+#ifndef CACHEKEY_HPP
+#define CACHEKEY_HPP
+
+#include <string>
+
+#include "internal/basecommon.h"
+
+#include "pybind11/pybind11.h"
+
+namespace py = pybind11;
+
+// The bytes a cache key hashes for a dialog and the style it refers to.
+// Values are written with their type and length, objects as their
+// properties in name order, so nothing depends on where they live in
+// memory and two runs over the same script give the same bytes.
+// Throws std::invalid_argument for a value that is none of None, bool,
+// int, float, str, bytes, list, tuple, dict or an object with properties.
+std::string dialogCacheKey(py::handle dialog, py::handle style) THROW;
+
+#endif // CACHEKEY_HPP
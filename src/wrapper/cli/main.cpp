@@ -43,7 +43,16 @@ int main(int argc, char **argv)
 
             ("p,parse",
              "Parse config file and output subtitle file.",
-             cxxopts::value<std::string>());
+             cxxopts::value<std::string>())
+
+            ("j,jobs",
+             "Number of worker processes --parse splits the lines of "
+             "every script to. Default is 1.",
+             cxxopts::value<size_t>()->default_value("1"))
+
+            ("no-cache",
+             "Run every dialog again, instead of reading the events of "
+             "unchanged dialogs from <output>.cache.");
 
     if (argc == 1)
     {
@@ -51,7 +60,7 @@ int main(int argc, char **argv)
         return 0;
     }
 
-    if (argc > 3)
+    if (argc > 6)
     {
         std::cerr << "Too many arguments!" << std::endl;
         std::cout << options.help() << std::endl;
@@ -134,8 +143,6 @@ int main(int argc, char **argv)
 
         if (result.count("parse"))
         {
-            py::scoped_interpreter guard{};
-
             std::string jsonFileName(result["parse"].as<std::string>());
             std::shared_ptr<ConfigParser> assConfig;
             try
@@ -153,8 +160,22 @@ int main(int argc, char **argv)
                 return 1;
             }
 
-            std::shared_ptr<AssLauncher> assLauncher(AssLauncher::create());
-            int ret(assLauncher->exec(assConfig));
+            size_t jobs(result["jobs"].as<size_t>());
+            bool useCache(result.count("no-cache") == 0);
+            int ret(1);
+            if (jobs > 1)
+            {
+                // workers are forked before any interpreter is started
+                ret = AssLauncher::execJobs(assConfig, jobs, useCache);
+            }
+            else
+            {
+                py::scoped_interpreter guard{};
+                std::shared_ptr<AssLauncher> assLauncher(
+                            AssLauncher::create(useCache));
+                ret = assLauncher ? assLauncher->exec(assConfig) : 1;
+            }
+
             if (ret)
             {
                 std::cerr << "Something error happened. "
@@ -0,0 +1,157 @@
+/*
+ * This file is part of SubFX,
+ * Copyright (c) 2020-2021 fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Checks that dialogCacheKey gives the same bytes for two dialogs built
+// apart from each other, as two runs over the same script build them,
+// with syllables of a bound class without __repr__.
+// Also checks that the bytes are the ones of a previous run, so they do not
+// depend on the process, and that a change to the dialog or to its style
+// changes them.
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "pybind11/embed.h"
+
+#include "../../cachekey.hpp"
+
+namespace py = pybind11;
+
+struct Syl
+{
+    std::string text;
+    double width;
+};
+
+struct Style
+{
+    std::string fontname;
+    double fontsize;
+};
+
+PYBIND11_EMBEDDED_MODULE(cachekeytest, m)
+{
+    py::class_<Syl>(m, "Syl")
+    .def(py::init())
+    .def_readwrite("text", &Syl::text)
+    .def_readwrite("width", &Syl::width);
+
+    py::class_<Style>(m, "Style")
+    .def(py::init())
+    .def_readwrite("fontname", &Style::fontname)
+    .def_readwrite("fontsize", &Style::fontsize);
+}
+
+static py::object makeSyl(const std::string &text, double width)
+{
+    py::object syl(py::module::import("cachekeytest").attr("Syl")());
+    syl.attr("text") = text;
+    syl.attr("width") = width;
+    return syl;
+}
+
+static py::dict makeDialog(const std::string &text)
+{
+    py::list syls;
+    syls.append(makeSyl("ka", 20.5));
+    syls.append(makeSyl(text, 31.25));
+
+    py::dict dialog;
+    dialog["comment"] = false;
+    dialog["layer"] = 0;
+    dialog["style"] = "Default";
+    dialog["text"] = "{\\k50}ka{\\k50}" + text;
+    dialog["effect"] = py::none();
+    dialog["syls"] = syls;
+    return dialog;
+}
+
+static py::object makeStyle(double fontsize)
+{
+    py::object style(py::module::import("cachekeytest").attr("Style")());
+    style.attr("fontname") = "Arial";
+    style.attr("fontsize") = fontsize;
+    return style;
+}
+
+int main()
+{
+    py::scoped_interpreter guard{};
+    try
+    {
+        py::dict first(makeDialog("ra"));
+        py::object firstStyle(makeStyle(40.));
+        // built while the first ones are alive, so at other addresses
+        py::dict second(makeDialog("ra"));
+        py::object secondStyle(makeStyle(40.));
+
+        std::string key(dialogCacheKey(first, firstStyle));
+        if (key != dialogCacheKey(second, secondStyle))
+        {
+            printf("equal dialogs have different keys\n");
+            return 1;
+        }
+
+        std::string expected("M6:S7:commentFS5:layerI1:0S5:styleS7:Default"
+                             "S4:textS16:{\\k50}ka{\\k50}raS6:effectN"
+                             "S4:sylsL2:O3:Syl2:S4:textS2:kaS5:widthD4:20.5"
+                             "O3:Syl2:S4:textS2:raS5:widthD5:31.25\n"
+                             "O5:Style2:S8:fontnameS5:ArialS8:fontsizeD4:40.0");
+        if (key != expected)
+        {
+            std::cout << "key is\n" << key << "\nexpected\n"
+                      << expected << std::endl;
+            return 1;
+        }
+
+        if (key == dialogCacheKey(makeDialog("ru"), firstStyle))
+        {
+            printf("a changed syllable keeps the key\n");
+            return 1;
+        }
+
+        if (key == dialogCacheKey(first, makeStyle(42.)))
+        {
+            printf("a changed style keeps the key\n");
+            return 1;
+        }
+
+        try
+        {
+            dialogCacheKey(first, py::module::import("builtins").attr("object")());
+            printf("an object without properties is accepted\n");
+            return 1;
+        }
+        catch (std::invalid_argument &)
+        {}
+    }
+    catch (std::exception &e)
+    {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}